@@ -41,6 +41,8 @@
 [include concepts/StreamType.qbk]
 [include concepts/TlsContext.qbk]
 [include concepts/is_authenticator.qbk]
+[include concepts/is_session_store.qbk]
+[include concepts/is_payload_sink.qbk]
 [include reason_codes/Reason_codes.qbk]
 [include properties/will_props.qbk]
 [include properties/connect_props.qbk]
@@ -1483,6 +1485,8 @@
     <xsl:when test="contains($qualified-name, 'StreamType')">StreamType</xsl:when>
     <xsl:when test="contains($qualified-name, 'TlsContext')">TlsContext</xsl:when>
     <xsl:when test="contains($qualified-name, 'is_authenticator')">is_authenticator</xsl:when>
+    <xsl:when test="contains($qualified-name, 'is_session_store')">is_session_store</xsl:when>
+    <xsl:when test="contains($qualified-name, 'is_payload_sink')">is_payload_sink</xsl:when>
     <xsl:otherwise></xsl:otherwise>
   </xsl:choose>
 </xsl:variable>
@@ -1534,7 +1538,8 @@
   <!-- unfortunately, there is no better way to differentiate between template types and non-documented types -->
   <xsl:when test="contains(type, 'CompletionToken') or contains(type, 'ExecutionContext')
     or contains(type, 'TlsContext') or contains(type, 'StreamType')
-    or contains(type, 'is_authenticator')">
+    or contains(type, 'is_authenticator') or contains(type, 'is_session_store')
+    or contains(type, 'is_payload_sink')">
     <xsl:call-template name="mqtt-template">
       <xsl:with-param name="qualified-name" select="$type"/>
     </xsl:call-template>
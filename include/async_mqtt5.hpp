@@ -2,8 +2,11 @@
 #define ASYNC_MQTT5_HPP
 
 #include <async_mqtt5/error.hpp>
+#include <async_mqtt5/mapped_session_store.hpp>
 #include <async_mqtt5/mqtt_client.hpp>
+#include <async_mqtt5/prepared_publish.hpp>
 #include <async_mqtt5/property_types.hpp>
+#include <async_mqtt5/publish_payload.hpp>
 #include <async_mqtt5/types.hpp>
 
 #endif // !ASYNC_MQTT5_HPP
@@ -0,0 +1,57 @@
+#ifndef ASYNC_MQTT5_ALLOCATE_FILE_HPP
+#define ASYNC_MQTT5_ALLOCATE_FILE_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace async_mqtt5::detail {
+
+// Creates a file of the given size with its disk blocks allocated.
+// The pages of a sparse file, as made by resize_file, are allocated when
+// first written through a mapping, which raises SIGBUS on a full disk.
+// Throws std::filesystem::filesystem_error if the file cannot be allocated.
+inline void allocate_file(const std::filesystem::path& path, size_t size) {
+#if defined(__linux__)
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		throw std::filesystem::filesystem_error(
+			"async_mqtt5: cannot create file", path,
+			std::error_code(errno, std::generic_category())
+		);
+	int rv = size ? ::posix_fallocate(fd, 0, off_t(size)) : 0;
+	::close(fd);
+	if (rv != 0)
+		throw std::filesystem::filesystem_error(
+			"async_mqtt5: cannot allocate file", path,
+			std::error_code(rv, std::generic_category())
+		);
+#else
+	constexpr size_t chunk_size = 64 * 1024;
+	std::ofstream file { path, std::ios::binary | std::ios::trunc };
+	std::vector<char> zeros(std::min(size, chunk_size), 0);
+	for (size_t left = size; file && left > 0; ) {
+		auto n = std::min(left, chunk_size);
+		file.write(zeros.data(), std::streamsize(n));
+		left -= n;
+	}
+	file.flush();
+	if (!file)
+		throw std::filesystem::filesystem_error(
+			"async_mqtt5: cannot allocate file", path,
+			std::make_error_code(std::errc::io_error)
+		);
+#endif
+}
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_ALLOCATE_FILE_HPP
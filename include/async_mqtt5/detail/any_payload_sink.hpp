@@ -0,0 +1,107 @@
+#ifndef ASYNC_MQTT5_ANY_PAYLOAD_SINK
+#define ASYNC_MQTT5_ANY_PAYLOAD_SINK
+
+#include <concepts>
+#include <memory>
+#include <string_view>
+
+#include <boost/system/error_code.hpp>
+
+#include <async_mqtt5/types.hpp>
+
+namespace async_mqtt5 {
+
+using error_code = boost::system::error_code;
+
+namespace detail {
+
+template <typename T>
+concept is_payload_sink = requires (T s) {
+	{
+		s.begin(std::string_view {}, publish_props {}, size_t {})
+	} -> std::same_as<void>;
+	{ s.chunk(std::string_view {}) } -> std::same_as<void>;
+	{ s.end(error_code {}) } -> std::same_as<void>;
+};
+
+class sink_fun_base {
+public:
+	virtual ~sink_fun_base() = default;
+
+	virtual void begin(
+		std::string_view topic, const publish_props& props,
+		size_t payload_size
+	) = 0;
+	virtual void chunk(std::string_view data) = 0;
+	virtual void end(error_code ec) = 0;
+};
+
+template <is_payload_sink PayloadSink>
+class sink_fun : public sink_fun_base {
+	PayloadSink _sink;
+
+public:
+	sink_fun(PayloadSink sink) :
+		_sink(std::forward<PayloadSink>(sink))
+	{}
+
+	void begin(
+		std::string_view topic, const publish_props& props,
+		size_t payload_size
+	) override {
+		_sink.begin(topic, props, payload_size);
+	}
+
+	void chunk(std::string_view data) override {
+		_sink.chunk(data);
+	}
+
+	void end(error_code ec) override {
+		_sink.end(ec);
+	}
+};
+
+} // end namespace detail
+
+// Without a sink, every payload is delivered whole through async_receive.
+class any_payload_sink {
+	std::unique_ptr<detail::sink_fun_base> _sink_fun;
+
+public:
+	any_payload_sink() = default;
+
+	template <detail::is_payload_sink PayloadSink>
+	any_payload_sink(PayloadSink&& s) :
+		_sink_fun(
+			new detail::sink_fun<PayloadSink>(
+				std::forward<PayloadSink>(s)
+			)
+		)
+	{}
+
+	bool enabled() const {
+		return _sink_fun != nullptr;
+	}
+
+	void begin(
+		std::string_view topic, const publish_props& props,
+		size_t payload_size
+	) {
+		if (_sink_fun)
+			_sink_fun->begin(topic, props, payload_size);
+	}
+
+	void chunk(std::string_view data) {
+		if (_sink_fun)
+			_sink_fun->chunk(data);
+	}
+
+	void end(error_code ec) {
+		if (_sink_fun)
+			_sink_fun->end(ec);
+	}
+};
+
+} // end namespace async_mqtt5
+
+#endif // !ASYNC_MQTT5_ANY_PAYLOAD_SINK
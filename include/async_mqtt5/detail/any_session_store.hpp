@@ -0,0 +1,124 @@
+#ifndef ASYNC_MQTT5_ANY_SESSION_STORE
+#define ASYNC_MQTT5_ANY_SESSION_STORE
+
+#include <concepts>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <async_mqtt5/types.hpp>
+
+namespace async_mqtt5 {
+
+namespace detail {
+
+template <typename T>
+concept is_session_store = requires (T s) {
+	{
+		s.store(
+			session_entry_e {}, uint16_t {},
+			std::string_view {}, std::string_view {}
+		)
+	} -> std::same_as<void>;
+	{ s.erase(session_entry_e {}, uint16_t {}) } -> std::same_as<void>;
+	{ s.load() } -> std::same_as<std::vector<session_entry>>;
+};
+
+class store_fun_base {
+public:
+	virtual ~store_fun_base() = default;
+
+	virtual void store(
+		session_entry_e kind, uint16_t packet_id,
+		std::string_view header, std::string_view payload
+	) = 0;
+	virtual void erase(session_entry_e kind, uint16_t packet_id) = 0;
+	virtual std::vector<session_entry> load() = 0;
+};
+
+template <is_session_store SessionStore>
+class store_fun : public store_fun_base {
+	SessionStore _store;
+
+public:
+	store_fun(SessionStore store) :
+		_store(std::forward<SessionStore>(store))
+	{}
+
+	void store(
+		session_entry_e kind, uint16_t packet_id,
+		std::string_view header, std::string_view payload
+	) override {
+		_store.store(kind, packet_id, header, payload);
+	}
+
+	void erase(session_entry_e kind, uint16_t packet_id) override {
+		_store.erase(kind, packet_id);
+	}
+
+	std::vector<session_entry> load() override {
+		return _store.load();
+	}
+};
+
+} // end namespace detail
+
+// Without a store, in-flight state is kept in memory only.
+// A store that throws is detached: the Client keeps the in-flight
+// state in memory from then on, and the caller reports the failure.
+class any_session_store {
+	std::unique_ptr<detail::store_fun_base> _store_fun;
+
+public:
+	any_session_store() = default;
+
+	template <detail::is_session_store SessionStore>
+	any_session_store(SessionStore&& s) :
+		_store_fun(
+			new detail::store_fun<SessionStore>(
+				std::forward<SessionStore>(s)
+			)
+		)
+	{}
+
+	bool enabled() const {
+		return _store_fun != nullptr;
+	}
+
+	// Returns false if the store failed and has been detached.
+	bool store(
+		session_entry_e kind, uint16_t packet_id,
+		std::string_view header, std::string_view payload
+	) noexcept {
+		return guarded([&] {
+			_store_fun->store(kind, packet_id, header, payload);
+		});
+	}
+
+	bool erase(session_entry_e kind, uint16_t packet_id) noexcept {
+		return guarded([&] { _store_fun->erase(kind, packet_id); });
+	}
+
+	bool load(std::vector<session_entry>& entries) noexcept {
+		return guarded([&] { entries = _store_fun->load(); });
+	}
+
+private:
+	template <typename Func>
+	bool guarded(Func&& func) noexcept {
+		if (!_store_fun)
+			return true;
+		try {
+			func();
+			return true;
+		}
+		catch (...) {
+			_store_fun.reset();
+			return false;
+		}
+	}
+};
+
+} // end namespace async_mqtt5
+
+#endif // !ASYNC_MQTT5_ANY_SESSION_STORE
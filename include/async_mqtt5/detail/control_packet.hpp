@@ -1,13 +1,24 @@
 #ifndef ASYNC_MQTT5_CONTROL_PACKET_HPP
 #define ASYNC_MQTT5_CONTROL_PACKET_HPP
 
-#include <mutex>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include <boost/asio/buffer.hpp>
 #include <boost/smart_ptr/allocate_unique.hpp>
 
+#include <async_mqtt5/publish_payload.hpp>
 #include <async_mqtt5/types.hpp>
 
+#include <async_mqtt5/detail/spill_log.hpp>
+
 namespace async_mqtt5 {
 
 
@@ -33,21 +44,181 @@ enum class control_code_e : std::uint8_t {
 
 constexpr struct with_pid_ {} with_pid {};
 constexpr struct no_pid_ {} no_pid {};
+constexpr struct with_payload_ {} with_payload {};
+constexpr struct fixed_ {} fixed {};
+
+// Packets whose encoding does not depend on any argument.
+namespace fixed_packets {
+
+inline constexpr std::array<char, 2> pingreq {
+	char(control_code_e::pingreq), 0
+};
+
+} // end namespace fixed_packets
+
+// A fixed number of slots for packets that differ only in a few bytes,
+// such as acknowledgements with no properties that differ only in
+// the Packet Identifier. The slots are shared by all clients and are
+// claimed through an atomic bitmap; when none is free, the packet is
+// allocated instead.
+class fixed_packet_pool {
+public:
+	static constexpr size_t slot_size = 8;
+	static constexpr int num_slots = 64;
+
+private:
+	std::atomic<uint64_t> _free { ~uint64_t(0) };
+	alignas(64) char _slots[num_slots][slot_size] {};
+
+public:
+	static fixed_packet_pool& instance() {
+		static fixed_packet_pool pool;
+		return pool;
+	}
+
+	// Returns -1 if all slots are in use.
+	int claim() {
+		auto free = _free.load(std::memory_order_relaxed);
+		while (free != 0) {
+			auto slot = std::countr_zero(free);
+			auto claimed = free & ~(uint64_t(1) << slot);
+			if (_free.compare_exchange_weak(
+				free, claimed, std::memory_order_acquire, std::memory_order_relaxed
+			))
+				return slot;
+		}
+		return -1;
+	}
+
+	void release(int slot) {
+		_free.fetch_or(uint64_t(1) << slot, std::memory_order_release);
+	}
+
+	char* data(int slot) {
+		return _slots[slot];
+	}
+
+	int available() const {
+		return std::popcount(_free.load(std::memory_order_relaxed));
+	}
+};
+
+// Refers to a packet in static storage or in a slot of
+// the fixed_packet_pool, which it releases when destroyed.
+class fixed_packet {
+	const char* _data { nullptr };
+	uint8_t _size { 0 };
+	int8_t _slot { -1 };
+
+public:
+	fixed_packet() noexcept = default;
+
+	template <size_t N>
+	explicit fixed_packet(const std::array<char, N>& packet) noexcept :
+		_data(packet.data()), _size(uint8_t(N))
+	{
+		static_assert(N <= fixed_packet_pool::slot_size);
+	}
+
+	fixed_packet(int slot, const char* data, size_t size) noexcept :
+		_data(data), _size(uint8_t(size)), _slot(int8_t(slot))
+	{}
+
+	fixed_packet(fixed_packet&& other) noexcept :
+		_data(std::exchange(other._data, nullptr)),
+		_size(std::exchange(other._size, 0)),
+		_slot(std::exchange(other._slot, -1))
+	{}
+
+	fixed_packet& operator=(fixed_packet&& other) noexcept {
+		if (this != &other) {
+			release();
+			_data = std::exchange(other._data, nullptr);
+			_size = std::exchange(other._size, 0);
+			_slot = std::exchange(other._slot, -1);
+		}
+		return *this;
+	}
+
+	~fixed_packet() {
+		release();
+	}
+
+	// Copies the packet into a slot of the pool. Returns an empty
+	// fixed_packet if all slots are in use.
+	template <size_t N>
+	static fixed_packet pooled(const std::array<char, N>& packet) noexcept {
+		static_assert(N <= fixed_packet_pool::slot_size);
+		auto& pool = fixed_packet_pool::instance();
+		auto slot = pool.claim();
+		if (slot < 0)
+			return {};
+		std::memcpy(pool.data(slot), packet.data(), N);
+		return { slot, pool.data(slot), N };
+	}
+
+	explicit operator bool() const noexcept {
+		return _data != nullptr;
+	}
+
+	const char* data() const noexcept {
+		return _data;
+	}
+
+	size_t size() const noexcept {
+		return _size;
+	}
+
+private:
+	void release() noexcept {
+		if (_slot >= 0)
+			fixed_packet_pool::instance().release(_slot);
+		_slot = -1;
+	}
+};
 
 template <typename Allocator>
 class control_packet {
+	// The encoded header is allocated with the packet's allocator.
+	using header_type = std::basic_string<
+		char, std::char_traits<char>,
+		typename std::allocator_traits<Allocator>::template rebind_alloc<char>
+	>;
+
+	// The payload is kept apart from the encoded header so that it
+	// is never copied into the packet, whether it is owned, borrowed
+	// or shared; both are written to the stream as separate buffers.
+	struct packet_data {
+		header_type header;
+		publish_payload payload;
+		// replaces header and payload once the packet is spilled
+		detail::spill_record spilled;
+	};
+
 	uint16_t _packet_id;
 
 	using alloc_type = Allocator;
-	using deleter = boost::alloc_deleter<std::string, alloc_type>;
-	std::unique_ptr<std::string, deleter> _packet;
+	using deleter = boost::alloc_deleter<packet_data, alloc_type>;
+	std::unique_ptr<packet_data, deleter> _packet;
+
+	// Used instead of _packet for packets that are not allocated.
+	fixed_packet _fixed;
 
 	control_packet(
 		const Allocator& a,
-		uint16_t packet_id, std::string packet
+		uint16_t packet_id, header_type header, publish_payload payload = {}
 	) noexcept :
 		_packet_id(packet_id),
-		_packet(boost::allocate_unique<std::string>(a, std::move(packet)))
+		_packet(boost::allocate_unique<packet_data>(
+			a, packet_data { std::move(header), std::move(payload), {} }
+		))
+	{}
+
+	control_packet(
+		const Allocator& a, uint16_t packet_id, fixed_packet fixed
+	) noexcept :
+		_packet_id(packet_id), _packet(nullptr, deleter(a)),
+		_fixed(std::move(fixed))
 	{}
 
 public:
@@ -63,7 +234,27 @@ public:
 		EncodeFun&& encode, uint16_t packet_id, Args&&... args
 	) {
 		return control_packet {
-			alloc, packet_id, encode(packet_id, std::forward<Args>(args)...)
+			alloc, packet_id,
+			encode(packet_id, std::forward<Args>(args)..., alloc)
+		};
+	}
+
+	template <
+		typename EncodeFun,
+		typename Payload,
+		typename ...Args
+	>
+	static control_packet of(
+		with_pid_, const Allocator& alloc,
+		EncodeFun&& encode, uint16_t packet_id,
+		with_payload_, Payload&& payload_arg, Args&&... args
+	) {
+		publish_payload payload(std::forward<Payload>(payload_arg));
+		auto header = encode(
+			packet_id, payload.size(), std::forward<Args>(args)..., alloc
+		);
+		return control_packet {
+			alloc, packet_id, std::move(header), std::move(payload)
 		};
 	}
 
@@ -76,12 +267,48 @@ public:
 		EncodeFun&& encode, Args&&... args
 	) {
 		return control_packet {
-			alloc, 0, encode(std::forward<Args>(args)...)
+			alloc, 0, encode(std::forward<Args>(args)..., alloc)
+		};
+	}
+
+	template <size_t N>
+	static control_packet of(
+		fixed_, const Allocator& alloc, const std::array<char, N>& packet
+	) {
+		return control_packet { alloc, 0, fixed_packet { packet } };
+	}
+
+	// PUBACK, PUBREC, PUBREL or PUBCOMP with Reason Code 0x00 (Success)
+	// and no properties, placed in the fixed_packet_pool when a slot is free.
+	static control_packet of(
+		fixed_, const Allocator& alloc,
+		control_code_e code, uint16_t packet_id
+	) {
+		auto first_byte = uint8_t(code);
+		if (code == control_code_e::pubrel)
+			first_byte |= 0b0010;
+
+		std::array<char, 5> packet {
+			char(first_byte), 3,
+			char(packet_id >> 8), char(packet_id & 0xff),
+			0
+		};
+
+		return pooled(alloc, packet_id, packet);
+	}
+
+	// DISCONNECT with no properties.
+	static control_packet of(
+		fixed_, const Allocator& alloc, uint8_t reason_code
+	) {
+		std::array<char, 4> packet {
+			char(control_code_e::disconnect), 2, char(reason_code), 0
 		};
+		return pooled(alloc, 0, packet);
 	}
 
 	control_code_e control_code() const {
-		return control_code_e(uint8_t(*(_packet->data())) & 0b11110000);
+		return control_code_e(uint8_t(*header_data()) & 0b11110000);
 	}
 
 	uint16_t packet_id() const {
@@ -90,74 +317,194 @@ public:
 
 	qos_e qos() const {
 		assert(control_code() == control_code_e::publish);
-		auto byte = (uint8_t(*(_packet->data())) & 0b00000110) >> 1;
+		auto byte = (uint8_t(*header_data()) & 0b00000110) >> 1;
 		return qos_e(byte);
 	}
 
+	dup_e dup() const {
+		assert(control_code() == control_code_e::publish);
+		auto byte = (uint8_t(*header_data()) & 0b00001000) >> 3;
+		return dup_e(byte);
+	}
+
+	// Moves the encoded packet into the spill log, releasing its memory.
+	// Returns false if the packet stays in memory.
+	bool spill(detail::spill_log& log) {
+		if (!_packet || _packet->spilled)
+			return false;
+
+		const auto& payload = _packet->payload;
+		auto record = log.append(
+			_packet->header, { payload.data(), payload.size() }
+		);
+		if (!record)
+			return false;
+
+		_packet->spilled = std::move(record);
+		header_type { _packet->header.get_allocator() }.swap(_packet->header);
+		std::exchange(_packet->payload, publish_payload {});
+		return true;
+	}
+
+	bool spilled() const {
+		return _packet && _packet->spilled;
+	}
+
+	// Replaces the encoded header, keeping the Packet Identifier
+	// and the payload.
+	template <
+		typename EncodeFun,
+		typename ...Args
+	>
+	control_packet& reencode(
+		with_payload_, EncodeFun&& encode, Args&&... args
+	) {
+		assert(!spilled());
+		_packet->header = encode(
+			_packet_id, _packet->payload.size(), std::forward<Args>(args)...,
+			_packet->header.get_allocator()
+		);
+		return *this;
+	}
+
 	control_packet& set_dup() {
 		assert(control_code() == control_code_e::publish);
-		auto& byte = *(_packet->data());
+		auto& byte = _packet->spilled ?
+			*_packet->spilled.header() : *_packet->header.data();
 		byte |= 0b00001000;
 		return *this;
 	}
 
-	const std::string& wire_data() const {
-		return *_packet;
+	std::array<boost::asio::const_buffer, 2> wire_data() const {
+		if (!_packet)
+			return {
+				boost::asio::buffer(_fixed.data(), _fixed.size()),
+				boost::asio::const_buffer {}
+			};
+		if (const auto& spilled = _packet->spilled)
+			return {
+				boost::asio::buffer(spilled.header(), spilled.header_size()),
+				boost::asio::buffer(spilled.payload(), spilled.payload_size())
+			};
+		return {
+			boost::asio::buffer(_packet->header),
+			boost::asio::buffer(_packet->payload.data(), _packet->payload.size())
+		};
+	}
+
+private:
+	template <size_t N>
+	static control_packet pooled(
+		const Allocator& alloc, uint16_t packet_id,
+		const std::array<char, N>& packet
+	) {
+		if (auto fixed = fixed_packet::pooled(packet))
+			return control_packet { alloc, packet_id, std::move(fixed) };
+
+		return control_packet {
+			alloc, packet_id,
+			header_type(packet.begin(), packet.end(), alloc)
+		};
+	}
+
+	const char* header_data() const {
+		if (!_packet)
+			return _fixed.data();
+		if (_packet->spilled)
+			return _packet->spilled.header();
+		return _packet->header.data();
 	}
 };
 
+// Packet Identifiers are released on the Client's executor, but they
+// are allocated where a publish is initiated, which may be any thread.
+// Each word of the bitmap is therefore claimed and released atomically,
+// without a lock. The lowest free Packet Identifier is returned unless
+// another thread allocates or releases one concurrently.
 class packet_id_allocator {
-	struct interval {
-		uint16_t start, end;
-		interval(uint16_t start, uint16_t end) : start(start), end(end) {}
-	};
-
-	std::mutex _mtx;
-	std::vector<interval> _free_ids;
 	static constexpr uint16_t MAX_PACKET_ID = 65535;
+	static constexpr size_t num_words = (MAX_PACKET_ID + 1) / 64;
+	static constexpr uint64_t all_ones = ~uint64_t(0);
+
+	// bit i of _used[w] is set when Packet Identifier w * 64 + i is allocated
+	std::array<std::atomic<uint64_t>, num_words> _used {};
+	// bit i of _full[s] is set when _used[s * 64 + i] has no free bits left,
+	// it is only a hint that lets allocate() skip full words
+	std::array<std::atomic<uint64_t>, num_words / 64> _full {};
 
 public:
 	packet_id_allocator() {
-		_free_ids.emplace_back(MAX_PACKET_ID, 0);
+		// 0 is not a valid Packet Identifier
+		_used[0] = 1;
 	}
 
+	// Returns the lowest free Packet Identifier, or 0 if all are in use.
 	uint16_t allocate() {
-		std::lock_guard _(_mtx);
-		if (_free_ids.empty()) return 0;
-		auto& last = _free_ids.back();
-		if (last.start == ++last.end) {
-			auto ret = last.end;
-			_free_ids.pop_back();
-			return ret;
+		for (size_t s = 0; s < _full.size(); ++s) {
+			for (
+				auto full = _full[s].load();
+				full != all_ones;
+				full = _full[s].load()
+			) {
+				size_t w = s * 64 + std::countr_one(full);
+				auto used = _used[w].load();
+				while (used != all_ones) {
+					auto bit = uint64_t(1) << std::countr_one(used);
+					if (!_used[w].compare_exchange_weak(used, used | bit))
+						continue;
+					if ((used | bit) == all_ones)
+						mark_full(w);
+					return uint16_t(w * 64 + std::countr_zero(bit));
+				}
+				mark_full(w);
+			}
 		}
-		return last.end;
+		return 0;
 	}
 
-	void free(uint16_t pid) {
-		std::lock_guard _(_mtx);
-		auto it = std::upper_bound(
-			_free_ids.begin(), _free_ids.end(), pid,
-			[](const uint16_t x, const interval& i) { return x > i.start; }
-		);
-		uint16_t* end_p = nullptr;
-		if (it != _free_ids.begin()) {
-			auto pit = std::prev(it);
-			if (pit->end == pid)
-				end_p = &pit->end;
-		}
-		if (it != _free_ids.end() && pid - 1 == it->start) {
-			if (!end_p)
-				it->start = pid;
-			else {
-				*end_p = it->end;
-				_free_ids.erase(it);
-			}
-		} else {
-			if (!end_p)
-				_free_ids.insert(it, interval(pid, pid - 1));
-			else
-				*end_p = pid - 1;
+	// Allocates a Packet Identifier for every element of pids.
+	// Either all identifiers are allocated or none are.
+	bool allocate(std::span<uint16_t> pids) {
+		for (size_t i = 0; i < pids.size(); ++i) {
+			pids[i] = allocate();
+			if (pids[i] != 0)
+				continue;
+			while (i > 0)
+				free(pids[--i]);
+			return false;
 		}
+		return true;
+	}
+
+	void free(uint16_t pid) {
+		if (pid == 0)
+			return;
+		size_t w = pid / 64;
+		_used[w].fetch_and(~(uint64_t(1) << (pid % 64)));
+		_full[w / 64].fetch_and(~(uint64_t(1) << (w % 64)));
+	}
+
+	// Allocates the given Packet Identifier, such as one restored from
+	// a session store. Returns false if it is already allocated.
+	bool reserve(uint16_t pid) {
+		size_t w = pid / 64;
+		auto bit = uint64_t(1) << (pid % 64);
+		auto used = _used[w].fetch_or(bit);
+		if (used & bit)
+			return false;
+		if ((used | bit) == all_ones)
+			mark_full(w);
+		return true;
+	}
+
+private:
+	void mark_full(size_t w) {
+		auto bit = uint64_t(1) << (w % 64);
+		_full[w / 64].fetch_or(bit);
+		// free() may have released an identifier of the word and
+		// cleared the hint before it was set here
+		if (_used[w].load() != all_ones)
+			_full[w / 64].fetch_and(~bit);
 	}
 };
 
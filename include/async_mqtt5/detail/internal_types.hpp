@@ -70,6 +70,27 @@ struct disconnect_context {
 	bool terminal = false;
 };
 
+struct write_coalescing {
+	duration linger { 0 };
+	size_t max_bytes { 0 };
+	size_t max_packets { 0 };
+
+	bool enabled() const { return linger > duration::zero(); }
+};
+
+// Limits of the outbound queue. New PUBLISH packets that would exceed
+// the high watermark are handled according to the overflow policy.
+// The queue becomes writable again once it drains to the low watermark.
+struct write_limits {
+	size_t max_bytes { 0 };
+	size_t max_packets { 0 };
+	size_t low_bytes { 0 };
+	size_t low_packets { 0 };
+	overflow_policy_e policy { overflow_policy_e::reject_newest };
+
+	bool enabled() const { return max_bytes || max_packets; }
+};
+
 using serial_num_t = uint32_t;
 constexpr serial_num_t no_serial = 0;
 
@@ -80,6 +101,19 @@ constexpr unsigned throttled = 0b001;
 constexpr unsigned prioritized = 0b010;
 constexpr unsigned terminal = 0b100;
 
+// bits 3 and 4 hold the traffic class, 0 denotes control packets
+constexpr unsigned traffic_class_shift = 3;
+constexpr unsigned traffic_class_mask = 0b11000;
+
+// new PUBLISH packets subject to write_limits
+constexpr unsigned bounded = 0b100000;
+// QoS 0 PUBLISH packets that may be dropped to make room in the queue
+constexpr unsigned droppable = 0b1000000;
+
+constexpr unsigned traffic_class(traffic_class_e tc) {
+	return unsigned(tc) << traffic_class_shift;
+}
+
 };
 
 } // end namespace async_mqtt5::detail
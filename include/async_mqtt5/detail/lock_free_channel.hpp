@@ -0,0 +1,241 @@
+#ifndef ASYNC_MQTT5_LOCK_FREE_CHANNEL_HPP
+#define ASYNC_MQTT5_LOCK_FREE_CHANNEL_HPP
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <tuple>
+
+#include <boost/asio/any_completion_handler.hpp>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/cancellation_type.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/post.hpp>
+
+#include <async_mqtt5/detail/async_traits.hpp>
+
+namespace async_mqtt5::detail {
+
+namespace asio = boost::asio;
+using error_code = boost::system::error_code;
+
+/*
+
+Receive queue shared by the Client, which sends into it from its
+executor, and a consumer that may run on another thread.
+The values are kept in a fixed ring of slots indexed by two counters,
+one advanced by each side, so that neither side takes a lock.
+A single receive may be outstanding at a time. The side that finds
+the waiting receive together with a value claims it by clearing the
+waiting flag, and completes it as if by asio::post.
+Values sent while the ring is full are rejected, whereas the channels
+of the other receive queues drop their oldest value to make room.
+Dropping the oldest value would require the sending side to advance
+the receiving side's counter. A waiting receive is cancelled through
+its cancellation slot, or by close; either way it is claimed like
+a receive completed with a value.
+
+*/
+
+template <typename Signature>
+class lock_free_channel;
+
+template <typename... Args>
+class lock_free_channel<void (error_code, Args...)> {
+	using value_type = std::tuple<error_code, Args...>;
+	using handler_type = asio::any_completion_handler<
+		void (error_code, Args...)
+	>;
+
+	static constexpr size_t capacity = 4096;
+	static constexpr size_t mask = capacity - 1;
+
+	asio::any_io_executor _ex;
+	// allocated by the first send
+	std::unique_ptr<std::optional<value_type>[]> _slots;
+
+	// next slot to receive from, advanced by the receiving side
+	alignas(64) std::atomic<size_t> _head { 0 };
+	// next slot to send into, advanced by the sending side
+	alignas(64) std::atomic<size_t> _tail { 0 };
+
+	alignas(64) std::atomic<bool> _waiting { false };
+	std::atomic<bool> _closed { false };
+	std::atomic<bool> _cancelled { false };
+	handler_type _waiter;
+
+	// Per-operation cancellation helper, invoked where the
+	// cancellation signal is emitted.
+	class cancel_receive {
+		lock_free_channel& _owner;
+	public:
+		explicit cancel_receive(lock_free_channel& owner) : _owner(owner) {}
+
+		void operator()(asio::cancellation_type_t type) {
+			if (type == asio::cancellation_type_t::none)
+				return;
+			_owner._cancelled.store(true, std::memory_order_seq_cst);
+			if (_owner._waiting.load(std::memory_order_seq_cst))
+				_owner.complete_waiter();
+		}
+	};
+
+public:
+	using executor_type = asio::any_io_executor;
+
+	// The size is ignored: the ring holds a fixed number of values.
+	template <typename Executor>
+	lock_free_channel(const Executor& ex, size_t /* max_buffer_size */) :
+		_ex(ex)
+	{}
+
+	lock_free_channel(const lock_free_channel&) = delete;
+	lock_free_channel& operator=(const lock_free_channel&) = delete;
+
+	~lock_free_channel() {
+		close();
+	}
+
+	executor_type get_executor() const noexcept {
+		return _ex;
+	}
+
+	template <typename... Vs>
+	bool try_send(error_code ec, Vs&&... values) {
+		if (_closed.load(std::memory_order_acquire))
+			return false;
+
+		if (!_slots)
+			_slots = std::make_unique<std::optional<value_type>[]>(capacity);
+
+		auto tail = _tail.load(std::memory_order_relaxed);
+		if (tail - _head.load(std::memory_order_acquire) == capacity)
+			return false;
+
+		_slots[tail & mask].emplace(ec, std::forward<Vs>(values)...);
+		_tail.store(tail + 1, std::memory_order_seq_cst);
+
+		if (_waiting.load(std::memory_order_seq_cst))
+			complete_waiter();
+		return true;
+	}
+
+	template <typename CompletionToken>
+	decltype(auto) async_receive(CompletionToken&& token) {
+		auto initiation = [this] (auto handler) {
+			auto ex = tracking_executor(handler, _ex);
+			receive(asio::bind_executor(std::move(ex), std::move(handler)));
+		};
+		return asio::async_initiate<
+			CompletionToken, void (error_code, Args...)
+		> (std::move(initiation), token);
+	}
+
+	// Completes the outstanding receive with operation_aborted
+	// and rejects the values sent until reset.
+	void close() {
+		_closed.store(true, std::memory_order_seq_cst);
+		if (_waiting.load(std::memory_order_seq_cst))
+			complete_waiter();
+	}
+
+	// Discards the queued values and reopens the channel.
+	// Must not run concurrently with sends or receives.
+	void reset() {
+		close();
+		if (_slots)
+			for (size_t i = 0; i < capacity; ++i)
+				_slots[i].reset();
+		_head.store(0, std::memory_order_relaxed);
+		_tail.store(0, std::memory_order_relaxed);
+		_cancelled.store(false, std::memory_order_relaxed);
+		_closed.store(false, std::memory_order_release);
+	}
+
+private:
+	void receive(handler_type handler) {
+		if (_closed.load(std::memory_order_acquire))
+			return complete(std::move(handler), std::nullopt);
+		if (auto value = pop())
+			return complete(std::move(handler), std::move(value));
+
+		_cancelled.store(false, std::memory_order_relaxed);
+		auto slot = handler.get_cancellation_slot();
+		if (slot.is_connected())
+			slot.template emplace<cancel_receive>(*this);
+
+		_waiter = std::move(handler);
+		_waiting.store(true, std::memory_order_seq_cst);
+
+		// a value sent, a close or a cancellation before the flag
+		// was set would not have seen the waiting receive
+		if (
+			interrupted() ||
+			_tail.load(std::memory_order_seq_cst) !=
+				_head.load(std::memory_order_relaxed)
+		)
+			complete_waiter();
+	}
+
+	bool interrupted() const {
+		return
+			_closed.load(std::memory_order_seq_cst) ||
+			_cancelled.load(std::memory_order_seq_cst);
+	}
+
+	// Completes the waiting receive if this side claims it.
+	void complete_waiter() {
+		while (_waiting.exchange(false, std::memory_order_acq_rel)) {
+			if (interrupted())
+				return complete(std::move(_waiter), std::nullopt);
+			if (auto value = pop())
+				return complete(std::move(_waiter), std::move(value));
+
+			// the value that made this side claim the receive was taken
+			// by an earlier one, so the receive waits again
+			_waiting.store(true, std::memory_order_seq_cst);
+			if (
+				!interrupted() &&
+				_tail.load(std::memory_order_seq_cst) ==
+					_head.load(std::memory_order_relaxed)
+			)
+				return;
+		}
+	}
+
+	// Only the side that holds the receive pops.
+	std::optional<value_type> pop() {
+		auto head = _head.load(std::memory_order_relaxed);
+		if (head == _tail.load(std::memory_order_acquire))
+			return std::nullopt;
+
+		auto& slot = _slots[head & mask];
+		std::optional<value_type> value = std::move(slot);
+		slot.reset();
+		_head.store(head + 1, std::memory_order_release);
+		return value;
+	}
+
+	void complete(handler_type handler, std::optional<value_type> value) {
+		if (!value)
+			value.emplace(
+				asio::error::operation_aborted, std::decay_t<Args>()...
+			);
+
+		// the slot is cleared where the cancellation signal is emitted
+		auto ex = asio::get_associated_executor(handler, _ex);
+		asio::post(
+			ex,
+			[handler = std::move(handler), value = std::move(*value)]() mutable {
+				handler.get_cancellation_slot().clear();
+				std::apply(std::move(handler), std::move(value));
+			}
+		);
+	}
+};
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_LOCK_FREE_CHANNEL_HPP
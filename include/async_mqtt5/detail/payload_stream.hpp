@@ -0,0 +1,142 @@
+#ifndef ASYNC_MQTT5_PAYLOAD_STREAM_HPP
+#define ASYNC_MQTT5_PAYLOAD_STREAM_HPP
+
+#include <algorithm>
+#include <optional>
+#include <string_view>
+
+#include <async_mqtt5/detail/any_payload_sink.hpp>
+#include <async_mqtt5/detail/internal_types.hpp>
+
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
+
+namespace async_mqtt5::detail {
+
+/*
+
+State of an inbound PUBLISH packet whose payload is passed to the
+payload sink in chunks as it is read from the stream, instead of being
+assembled in the receive buffer.
+The stream starts once the variable header has been read. The sink is
+told about the packet when the decoded variable header is handed over,
+and the decoded message is kept until the whole payload has been
+consumed, at which point the packet is acknowledged.
+Payload bytes read before the sink was told about the packet, such as
+those of a packet whose variable header turned out to be invalid,
+are discarded.
+
+*/
+
+class payload_stream {
+	any_payload_sink _sink;
+	size_t _threshold = 0;
+
+	bool _active = false;
+	bool _begun = false;
+	size_t _remaining = 0;
+	decoders::publish_message _message;
+
+public:
+	template <typename PayloadSink>
+	void configure(PayloadSink&& sink, size_t threshold) {
+		_sink = any_payload_sink(std::forward<PayloadSink>(sink));
+		_threshold = threshold;
+	}
+
+	// Whether the payload of a PUBLISH packet of packet_size bytes
+	// is streamed.
+	bool streams(size_t packet_size) const {
+		return _sink.enabled() && packet_size > _threshold;
+	}
+
+	bool active() const {
+		return _active;
+	}
+
+	// The variable header has been read, but not yet handed over.
+	bool starting() const {
+		return _active && !_begun;
+	}
+
+	// The whole payload has been consumed.
+	bool finished() const {
+		return _active && _remaining == 0;
+	}
+
+	void start(size_t payload_size) {
+		_active = true;
+		_begun = false;
+		_remaining = payload_size;
+	}
+
+	void begin(decoders::publish_message message) {
+		_message = std::move(message);
+		_begun = true;
+		auto& [topic, packet_id, flags, props, payload] = _message;
+		_sink.begin(topic, props, _remaining);
+	}
+
+	// Passes the payload bytes in [first, last) to the sink and returns
+	// the number of bytes that belong to the streamed payload.
+	size_t consume(byte_citer first, byte_citer last) {
+		auto num_bytes = std::min<size_t>(_remaining, std::distance(first, last));
+		if (_begun && num_bytes)
+			_sink.chunk(std::string_view(&*first, num_bytes));
+		_remaining -= num_bytes;
+		return num_bytes;
+	}
+
+	// Ends the finished stream and returns the message to acknowledge,
+	// or nothing if the sink was never told about it.
+	std::optional<decoders::publish_message> finish() {
+		_active = false;
+		if (!_begun)
+			return std::nullopt;
+		_begun = false;
+		_sink.end(error_code {});
+		return std::move(_message);
+	}
+
+	// Ends the stream before the whole payload has been read.
+	void abort(error_code ec) {
+		if (!_active)
+			return;
+		_active = false;
+		if (_begun) {
+			_begun = false;
+			_sink.end(ec);
+		}
+	}
+
+	// Returns the size of the variable header of the PUBLISH packet
+	// whose variable header starts at first, or nothing if
+	// the whole variable header is not in [first, last).
+	static std::optional<size_t> variable_header_size(
+		uint8_t control_byte, byte_citer first, byte_citer last
+	) {
+		auto available = size_t(std::distance(first, last));
+		if (available < 2)
+			return std::nullopt;
+
+		size_t size = 2 + (uint8_t(first[0]) << 8 | uint8_t(first[1]));
+		if (control_byte & 0b0110) // QoS > 0 has a Packet Identifier
+			size += 2;
+		if (available < size)
+			return std::nullopt;
+
+		auto it = first + size;
+		auto props_size = decoders::fast::decode_varint(it, last);
+		if (!props_size)
+			return std::nullopt;
+
+		size = std::distance(first, it) + *props_size;
+		if (available < size)
+			return std::nullopt;
+		return size;
+	}
+};
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_PAYLOAD_STREAM_HPP
@@ -0,0 +1,171 @@
+#ifndef ASYNC_MQTT5_READ_BUFFER_HPP
+#define ASYNC_MQTT5_READ_BUFFER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <boost/asio/buffer.hpp>
+
+#include <async_mqtt5/detail/internal_types.hpp>
+
+namespace async_mqtt5::detail {
+
+namespace asio = boost::asio;
+
+/*
+
+Receive buffer holding the bytes read from the stream that have not
+been consumed yet.
+The storage is allocated and zero-filled once. Consumed bytes are
+released by advancing an offset, and the unconsumed bytes are moved
+to the front of the storage only when the space after them runs short.
+Consuming the last unconsumed byte rewinds the buffer without moving
+anything.
+The storage grows to fit packets larger than its capacity, and returns
+to its capacity once no such packet has been received for the shrink
+delay, so that an occasional large packet does not pin a large buffer.
+The storage is a block that can be shared with received messages
+referring to it. Bytes in a shared block are never overwritten: instead
+of rewinding, moving or resizing it, the buffer starts a new block.
+
+*/
+
+class read_buffer {
+	// reading into less space than this is not worth a compaction
+	static constexpr size_t min_read_size = 4096;
+
+	using clock = std::chrono::steady_clock;
+
+	std::shared_ptr<std::string> _buff = std::make_shared<std::string>();
+	size_t _capacity;
+	size_t _first = 0, _last = 0;
+
+	clock::duration _shrink_delay;
+	clock::time_point _last_large;
+
+public:
+	explicit read_buffer(
+		size_t capacity = 65536,
+		clock::duration shrink_delay = std::chrono::seconds(30)
+	) :
+		_capacity(capacity), _shrink_delay(shrink_delay)
+	{}
+
+	void configure(size_t capacity, clock::duration shrink_delay) {
+		_capacity = std::max(capacity, min_read_size);
+		_shrink_delay = shrink_delay;
+	}
+
+	size_t capacity() const noexcept {
+		return _capacity;
+	}
+
+	// The size of the storage, larger than the capacity while grown.
+	size_t storage_size() const noexcept {
+		return _buff->size();
+	}
+
+	byte_citer begin() const noexcept {
+		return _buff->cbegin() + _first;
+	}
+
+	byte_citer end() const noexcept {
+		return _buff->cbegin() + _last;
+	}
+
+	size_t size() const noexcept {
+		return _last - _first;
+	}
+
+	// Shares the block into which the bytes have been read,
+	// keeping them in place for as long as it is referenced.
+	std::shared_ptr<const std::string> share() const noexcept {
+		return _buff;
+	}
+
+	// Returns the space after the unconsumed bytes that can be read into.
+	asio::mutable_buffer prepare() {
+		if (_buff->size() < _capacity)
+			resize(_capacity);
+		else if (_buff->size() > _capacity && _first == _last)
+			shrink();
+		if (_buff->size() - _last < min_read_size)
+			compact();
+		return asio::buffer(_buff->data() + _last, _buff->size() - _last);
+	}
+
+	void commit(size_t num_bytes) noexcept {
+		_last += num_bytes;
+	}
+
+	// Iterators to the consumed bytes stay valid until the next prepare.
+	void consume(size_t num_bytes) noexcept {
+		_first += num_bytes;
+		if (_first == _last && !shared())
+			_first = _last = 0;
+	}
+
+	// Ensures that a packet of packet_size bytes starting at begin()
+	// fits into the buffer, growing the storage if needed.
+	void make_room(size_t packet_size) {
+		if (packet_size > _capacity)
+			_last_large = clock::now();
+		if (_buff->size() - _first >= packet_size)
+			return;
+		if (shared())
+			return renew(std::max(_buff->size(), packet_size));
+		compact();
+		if (_buff->size() < packet_size)
+			_buff->resize(packet_size);
+	}
+
+	void clear() noexcept {
+		consume(size());
+	}
+
+private:
+	bool shared() const noexcept {
+		return _buff.use_count() > 1;
+	}
+
+	void resize(size_t storage_size) {
+		if (shared())
+			renew(storage_size);
+		else
+			_buff->resize(storage_size);
+	}
+
+	void shrink() {
+		if (clock::now() - _last_large < _shrink_delay)
+			return;
+		_buff = std::make_shared<std::string>(_capacity, '\0');
+		_first = _last = 0;
+	}
+
+	void compact() {
+		if (_first == 0)
+			return;
+		if (shared())
+			return renew(_buff->size());
+		std::copy(
+			_buff->begin() + _first, _buff->begin() + _last, _buff->begin()
+		);
+		_last -= _first;
+		_first = 0;
+	}
+
+	// Moves the unconsumed bytes to the front of a new block.
+	void renew(size_t storage_size) {
+		auto block = std::make_shared<std::string>(storage_size, '\0');
+		std::copy(begin(), end(), block->begin());
+		_buff = std::move(block);
+		_last -= _first;
+		_first = 0;
+	}
+};
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_READ_BUFFER_HPP
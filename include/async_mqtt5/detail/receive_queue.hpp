@@ -0,0 +1,44 @@
+#ifndef ASYNC_MQTT5_RECEIVE_QUEUE_HPP
+#define ASYNC_MQTT5_RECEIVE_QUEUE_HPP
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/experimental/basic_channel.hpp>
+#include <boost/asio/experimental/basic_concurrent_channel.hpp>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/channel_traits.hpp>
+#include <async_mqtt5/detail/lock_free_channel.hpp>
+
+namespace async_mqtt5::detail {
+
+namespace asio = boost::asio;
+
+template <receive_queue_e queue, typename Signature>
+struct receive_queue;
+
+template <typename Signature>
+struct receive_queue<receive_queue_e::concurrent, Signature> {
+	using type = asio::experimental::basic_concurrent_channel<
+		asio::any_io_executor, channel_traits<>, Signature
+	>;
+};
+
+template <typename Signature>
+struct receive_queue<receive_queue_e::strand_local, Signature> {
+	using type = asio::experimental::basic_channel<
+		asio::any_io_executor, channel_traits<>, Signature
+	>;
+};
+
+template <typename Signature>
+struct receive_queue<receive_queue_e::lock_free, Signature> {
+	using type = lock_free_channel<Signature>;
+};
+
+template <receive_queue_e queue, typename Signature>
+using receive_queue_t = typename receive_queue<queue, Signature>::type;
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_RECEIVE_QUEUE_HPP
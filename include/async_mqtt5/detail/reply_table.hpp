@@ -0,0 +1,174 @@
+#ifndef ASYNC_MQTT5_REPLY_TABLE_HPP
+#define ASYNC_MQTT5_REPLY_TABLE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <async_mqtt5/detail/control_packet.hpp>
+
+namespace async_mqtt5::detail {
+
+/*
+
+Unordered collection of entries keyed by (control code, Packet Identifier),
+such as handlers waiting for a reply.
+Entries are kept densely in a vector and erased by moving the last entry
+into the vacated position. An open addressing hash table with linear
+probing maps keys to positions, so lookup, insertion and erasure take
+constant time regardless of how many entries there are.
+Entry must provide code() and packet_id().
+
+*/
+
+template <typename Entry>
+class reply_table {
+	struct slot {
+		uint32_t key;
+		uint32_t pos;
+	};
+
+	// control codes of replies are never 0
+	static constexpr uint32_t no_key = 0;
+	static constexpr size_t min_slots = 16;
+
+	std::vector<Entry> _entries;
+	// power of 2 in size and at most half full
+	std::vector<slot> _slots;
+
+public:
+	using iterator = typename std::vector<Entry>::iterator;
+
+	iterator begin() noexcept { return _entries.begin(); }
+	iterator end() noexcept { return _entries.end(); }
+
+	bool empty() const noexcept { return _entries.empty(); }
+	size_t size() const noexcept { return _entries.size(); }
+
+	Entry* find(control_code_e code, uint16_t packet_id) {
+		if (_entries.empty())
+			return nullptr;
+		auto key = make_key(code, packet_id);
+		for (auto i = home(key); _slots[i].key != no_key; i = next(i))
+			if (_slots[i].key == key)
+				return &_entries[_slots[i].pos];
+		return nullptr;
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		_entries.emplace_back(std::forward<Args>(args)...);
+		if (2 * _entries.size() > _slots.size())
+			return rehash(std::max(min_slots, 2 * _slots.size()));
+		insert_slot(key_of(_entries.back()), _entries.size() - 1);
+	}
+
+	// Removes the entry pointed to by a pointer returned from find.
+	Entry take(Entry* entry) {
+		auto pos = size_t(entry - _entries.data());
+		auto last = _entries.size() - 1;
+
+		erase_slot(key_of(*entry), pos);
+		Entry ret = std::move(*entry);
+		if (pos != last) {
+			find_slot(key_of(_entries[last]), last).pos = uint32_t(pos);
+			*entry = std::move(_entries[last]);
+		}
+		_entries.pop_back();
+		return ret;
+	}
+
+	// Removes all entries.
+	std::vector<Entry> release() {
+		auto entries = std::move(_entries);
+		_entries.clear();
+		std::fill(_slots.begin(), _slots.end(), slot { no_key, 0 });
+		return entries;
+	}
+
+	// Removes the entries satisfying the predicate.
+	template <typename Predicate>
+	std::vector<Entry> extract_if(Predicate pred) {
+		std::vector<Entry> extracted;
+		auto kept = _entries.begin();
+		for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+			if (pred(std::as_const(*it)))
+				extracted.push_back(std::move(*it));
+			else {
+				if (kept != it)
+					*kept = std::move(*it);
+				++kept;
+			}
+		}
+		if (extracted.empty())
+			return extracted;
+
+		_entries.erase(kept, _entries.end());
+		rehash(_slots.size());
+		return extracted;
+	}
+
+	void clear() {
+		release();
+	}
+
+private:
+	static uint32_t make_key(control_code_e code, uint16_t packet_id) {
+		return uint32_t(code) << 16 | packet_id;
+	}
+
+	static uint32_t key_of(const Entry& entry) {
+		return make_key(entry.code(), entry.packet_id());
+	}
+
+	size_t mask() const {
+		return _slots.size() - 1;
+	}
+
+	size_t home(uint32_t key) const {
+		return size_t((key * 0x9E3779B97F4A7C15ull) >> 32) & mask();
+	}
+
+	size_t next(size_t i) const {
+		return (i + 1) & mask();
+	}
+
+	void rehash(size_t num_slots) {
+		_slots.assign(num_slots, slot { no_key, 0 });
+		for (size_t pos = 0; pos < _entries.size(); ++pos)
+			insert_slot(key_of(_entries[pos]), pos);
+	}
+
+	void insert_slot(uint32_t key, size_t pos) {
+		auto i = home(key);
+		while (_slots[i].key != no_key)
+			i = next(i);
+		_slots[i] = { key, uint32_t(pos) };
+	}
+
+	// Entries may share a key, their slots are told apart by position.
+	slot& find_slot(uint32_t key, size_t pos) {
+		auto i = home(key);
+		while (_slots[i].key != key || _slots[i].pos != pos)
+			i = next(i);
+		return _slots[i];
+	}
+
+	void erase_slot(uint32_t key, size_t pos) {
+		auto i = size_t(&find_slot(key, pos) - _slots.data());
+		// shift back the slots that would no longer be reachable
+		for (auto j = next(i); _slots[j].key != no_key; j = next(j)) {
+			auto h = home(_slots[j].key);
+			if (((j - h) & mask()) >= ((j - i) & mask())) {
+				_slots[i] = _slots[j];
+				i = j;
+			}
+		}
+		_slots[i].key = no_key;
+	}
+};
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_REPLY_TABLE_HPP
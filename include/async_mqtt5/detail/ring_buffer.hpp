@@ -208,8 +208,9 @@ public:
 	}
 
 	void clear() noexcept {
-		for (size_type i = 0; i < size(); ++i) {
-			allocator_traits::destroy(_alloc, &_buff[index(i)]);
+		auto s = size();
+		for (size_type i = 0; i < s; ++i) {
+			allocator_traits::destroy(_alloc, &_buff[index(_front + i)]);
 		}
 		_front = npos;
 		_back = 0;
@@ -324,7 +325,7 @@ public:
 
 	_iter operator--(int) noexcept {
 		auto tmp = *this;
-		_p = &_b->operator[](++_i);
+		_p = &_b->operator[](--_i);
 		return tmp;
 	}
 
@@ -0,0 +1,211 @@
+#ifndef ASYNC_MQTT5_SPILL_LOG_HPP
+#define ASYNC_MQTT5_SPILL_LOG_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <async_mqtt5/detail/allocate_file.hpp>
+
+namespace async_mqtt5::detail {
+
+namespace ipc = boost::interprocess;
+
+// A memory-mapped file of a fixed size to which packets are appended.
+// The file is removed once the last packet referring to it is released.
+class spill_segment {
+	std::filesystem::path _path;
+	ipc::mapped_region _region;
+	size_t _used { 0 };
+
+public:
+	// Throws ipc::interprocess_exception or std::filesystem::filesystem_error
+	// if the file cannot be created, allocated or mapped.
+	spill_segment(std::filesystem::path path, size_t size) :
+		_path(std::move(path))
+	{
+		try {
+			allocate_file(_path, size);
+			ipc::file_mapping file(_path.c_str(), ipc::read_write);
+			_region = ipc::mapped_region(file, ipc::read_write);
+		}
+		catch (...) {
+			std::error_code ec;
+			std::filesystem::remove(_path, ec);
+			throw;
+		}
+	}
+
+	spill_segment(const spill_segment&) = delete;
+	spill_segment& operator=(const spill_segment&) = delete;
+
+	~spill_segment() {
+		_region = ipc::mapped_region {};
+		std::error_code ec;
+		std::filesystem::remove(_path, ec);
+	}
+
+	char* data() {
+		return static_cast<char*>(_region.get_address());
+	}
+
+	size_t capacity() const {
+		return _region.get_size();
+	}
+
+	bool fits(size_t size) const {
+		return capacity() - _used >= size;
+	}
+
+	// Returns the offset of the appended bytes.
+	size_t append(std::string_view first, std::string_view second) {
+		auto offset = _used;
+		std::memcpy(data() + _used, first.data(), first.size());
+		std::memcpy(data() + _used + first.size(), second.data(), second.size());
+		_used += first.size() + second.size();
+		return offset;
+	}
+
+	// Called once nothing more is appended: the pages are written back
+	// and dropped from the process, to be read again when needed.
+	void seal() {
+		_region.flush(0, _used, true);
+		_region.advise(ipc::mapped_region::advice_dontneed);
+	}
+};
+
+// An encoded packet in a spill_segment: the header immediately followed
+// by the payload.
+class spill_record {
+	std::shared_ptr<spill_segment> _segment;
+	size_t _offset { 0 };
+	uint32_t _header_size { 0 };
+	uint32_t _payload_size { 0 };
+
+public:
+	spill_record() = default;
+
+	spill_record(
+		std::shared_ptr<spill_segment> segment, size_t offset,
+		size_t header_size, size_t payload_size
+	) :
+		_segment(std::move(segment)), _offset(offset),
+		_header_size(uint32_t(header_size)), _payload_size(uint32_t(payload_size))
+	{}
+
+	explicit operator bool() const {
+		return _segment != nullptr;
+	}
+
+	char* header() const {
+		return _segment->data() + _offset;
+	}
+
+	size_t header_size() const {
+		return _header_size;
+	}
+
+	const char* payload() const {
+		return header() + _header_size;
+	}
+
+	size_t payload_size() const {
+		return _payload_size;
+	}
+};
+
+// Append-only log of memory-mapped segment files. Packets moved into
+// the log take up no memory of their own: their pages are backed by
+// the files and are read back only when the packets are written.
+// The log is accessed from the Client's executor only.
+class spill_log {
+	static constexpr std::string_view prefix = "async_mqtt5-spill-";
+
+	std::filesystem::path _directory;
+	size_t _memory_limit { 0 };
+	size_t _segment_size { 0 };
+	uint64_t _segment_count { 0 };
+	std::shared_ptr<spill_segment> _current;
+
+public:
+	void configure(
+		std::string directory, size_t memory_limit, size_t segment_size
+	) {
+		_directory = std::move(directory);
+		_memory_limit = memory_limit;
+		_segment_size = segment_size;
+		_current.reset();
+		remove_stale_segments();
+	}
+
+	bool enabled() const {
+		return !_directory.empty() && _segment_size > 0;
+	}
+
+	// Packets are spilled once more than this many bytes are queued.
+	size_t memory_limit() const {
+		return _memory_limit;
+	}
+
+	// Returns an empty record if the packet cannot be spilled, in which
+	// case it stays in memory.
+	spill_record append(std::string_view header, std::string_view payload) {
+		auto size = header.size() + payload.size();
+		if (!enabled() || size > _segment_size)
+			return {};
+
+		if (!_current || !_current->fits(size)) {
+			if (_current)
+				_current->seal();
+			_current.reset();
+			try {
+				_current = std::make_shared<spill_segment>(
+					_directory / (std::string(prefix) + std::to_string(_segment_count++)),
+					_segment_size
+				);
+			}
+			catch (const ipc::interprocess_exception&) {
+				return {};
+			}
+			catch (const std::filesystem::filesystem_error&) {
+				return {};
+			}
+		}
+
+		auto offset = _current->append(header, payload);
+		return { _current, offset, header.size(), payload.size() };
+	}
+
+private:
+	// The directory belongs to this Client: segments found in it were
+	// left by a previous run that did not release them, such as one that
+	// crashed. Segments of this run are still mapped, so removing their
+	// files does not affect the packets in them.
+	void remove_stale_segments() {
+		if (!enabled())
+			return;
+		std::error_code ec;
+		for (
+			std::filesystem::directory_iterator it(_directory, ec), end;
+			!ec && it != end; it.increment(ec)
+		) {
+			auto name = it->path().filename().string();
+			if (name.starts_with(prefix)) {
+				std::error_code rec;
+				std::filesystem::remove(it->path(), rec);
+			}
+		}
+	}
+};
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_SPILL_LOG_HPP
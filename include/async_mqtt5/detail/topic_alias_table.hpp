@@ -0,0 +1,174 @@
+#ifndef ASYNC_MQTT5_TOPIC_ALIAS_TABLE_HPP
+#define ASYNC_MQTT5_TOPIC_ALIAS_TABLE_HPP
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <async_mqtt5/error.hpp>
+
+namespace async_mqtt5::detail {
+
+// Maps Topic Names of outbound PUBLISH packets to Topic Aliases.
+// An alias is assigned to a Topic Name on its first use. Once the Broker's
+// Topic Alias Maximum is reached, the least recently used alias that no
+// queued packet refers to is reassigned.
+//
+// A packet may omit the Topic Name only after the packet mapping the
+// alias to the Topic Name has been written. Aliases are valid for
+// a single Network Connection, every reconnect starts a new generation.
+class topic_alias_table {
+public:
+	struct lease {
+		uint16_t alias { 0 };
+		bool alias_only { false };
+		uint32_t generation { 0 };
+	};
+
+private:
+	struct entry {
+		std::string topic;
+		uint16_t alias { 0 };
+		size_t refs { 0 };
+		bool established { false };
+	};
+
+	using lru_list = std::list<entry>;
+
+	bool _enabled { false };
+	uint16_t _max { 0 };
+	uint32_t _generation { 1 };
+
+	lru_list _lru; // most recently used first
+	std::unordered_map<std::string_view, lru_list::iterator> _by_topic;
+	std::vector<lru_list::iterator> _by_alias;
+
+public:
+	void enable(bool enabled) {
+		_enabled = enabled;
+	}
+
+	bool enabled() const {
+		return _enabled;
+	}
+
+	void reset(uint16_t topic_alias_maximum) {
+		_max = _enabled ? topic_alias_maximum : 0;
+		++_generation;
+		_by_topic.clear();
+		_by_alias.clear();
+		_lru.clear();
+	}
+
+	// Returns a lease with alias 0 if no alias can be used.
+	lease acquire(std::string_view topic) {
+		if (_max == 0 || topic.empty())
+			return { 0, false, _generation };
+
+		if (auto it = _by_topic.find(topic); it != _by_topic.end()) {
+			auto e = it->second;
+			_lru.splice(_lru.begin(), _lru, e);
+			++e->refs;
+			return { e->alias, e->established, _generation };
+		}
+
+		auto e = free_entry();
+		if (e == _lru.end())
+			return { 0, false, _generation };
+
+		_lru.splice(_lru.begin(), _lru, e);
+		e->topic = topic;
+		e->refs = 1;
+		e->established = false;
+		_by_topic.emplace(e->topic, e);
+		return { e->alias, false, _generation };
+	}
+
+	bool current(const lease& l) const {
+		return l.generation == _generation;
+	}
+
+	// The packet mapping the alias to its Topic Name has been written.
+	void established(const lease& l) {
+		if (auto e = find(l))
+			e->established = true;
+	}
+
+	void release(lease& l) {
+		if (auto e = find(l))
+			--e->refs;
+		l = {};
+	}
+
+	size_t size() const {
+		return _lru.size();
+	}
+
+private:
+	entry* find(const lease& l) {
+		if (l.alias == 0 || !current(l) || l.alias > _by_alias.size())
+			return nullptr;
+		return &*_by_alias[l.alias - 1];
+	}
+
+	lru_list::iterator free_entry() {
+		if (_lru.size() < _max) {
+			_lru.push_back(entry { {}, uint16_t(_lru.size() + 1) });
+			_by_alias.push_back(std::prev(_lru.end()));
+			return _by_alias.back();
+		}
+
+		for (auto it = _lru.rbegin(); it != _lru.rend(); ++it)
+			if (it->refs == 0) {
+				auto e = std::prev(it.base());
+				_by_topic.erase(e->topic);
+				return e;
+			}
+
+		return _lru.end();
+	}
+};
+
+// Maps Topic Aliases of inbound PUBLISH packets to Topic Names.
+// The Topic Alias Maximum is the one the Client sent in its CONNECT.
+class inbound_topic_alias_table {
+	std::vector<std::string> _topics;
+
+public:
+	void reset(uint16_t topic_alias_maximum) {
+		_topics.assign(topic_alias_maximum, std::string {});
+	}
+
+	// Fills in the Topic Name of a packet that carries only the Topic
+	// Alias and records the mapping of a packet that carries both.
+	// Returns the Reason Code of the DISCONNECT if the alias is invalid.
+	std::optional<disconnect_rc_e> resolve(
+		std::string& topic, std::optional<int16_t> topic_alias
+	) {
+		if (!topic_alias)
+			return std::nullopt;
+
+		auto alias = uint16_t(*topic_alias);
+		if (alias == 0 || alias > _topics.size())
+			return disconnect_rc_e::topic_alias_invalid;
+
+		auto& mapped = _topics[alias - 1];
+		if (!topic.empty())
+			mapped = topic;
+		else if (!mapped.empty())
+			topic = mapped;
+		else
+			return disconnect_rc_e::protocol_error;
+
+		return std::nullopt;
+	}
+};
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_TOPIC_ALIAS_TABLE_HPP
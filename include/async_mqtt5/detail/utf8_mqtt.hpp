@@ -0,0 +1,209 @@
+#ifndef ASYNC_MQTT5_UTF8_MQTT_HPP
+#define ASYNC_MQTT5_UTF8_MQTT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ASYNC_MQTT5_UTF8_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASYNC_MQTT5_UTF8_SSE2
+#endif
+
+#include <async_mqtt5/error.hpp>
+#include <async_mqtt5/property_types.hpp>
+#include <async_mqtt5/types.hpp>
+
+namespace async_mqtt5::detail {
+
+/*
+
+Checks of the UTF-8 Encoded Strings of MQTT 5: the string must be
+well-formed UTF-8 and must not contain U+0000.
+Runs of ASCII characters are skipped 32 (AVX2), 16 (SSE2) or 8 bytes
+at a time, and the multi-byte sequences between them are decoded one
+at a time, which keeps the common all-ASCII Topic Name on the vector
+path from start to end.
+
+*/
+
+// Returns the number of leading bytes that are ASCII characters other than NUL.
+inline size_t ascii_prefix(const char* data, size_t size) {
+	size_t i = 0;
+#if defined(ASYNC_MQTT5_UTF8_AVX2)
+	const __m256i zero32 = _mm256_setzero_si256();
+	for (; i + 32 <= size; i += 32) {
+		auto block = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(data + i)
+		);
+		// the high bit is set in non-ASCII bytes and in the result of NUL == 0
+		auto stop = _mm256_or_si256(block, _mm256_cmpeq_epi8(block, zero32));
+		if (_mm256_movemask_epi8(stop))
+			break;
+	}
+#endif
+#if defined(ASYNC_MQTT5_UTF8_SSE2)
+	const __m128i zero16 = _mm_setzero_si128();
+	for (; i + 16 <= size; i += 16) {
+		auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		auto stop = _mm_or_si128(block, _mm_cmpeq_epi8(block, zero16));
+		if (_mm_movemask_epi8(stop))
+			break;
+	}
+#endif
+	constexpr uint64_t ones = 0x0101010101010101ull;
+	constexpr uint64_t highs = 0x8080808080808080ull;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		// non-ASCII bytes, and bytes that are zero
+		if ((word | ((word - ones) & ~word)) & highs)
+			break;
+	}
+	for (; i < size; ++i) {
+		auto c = uint8_t(data[i]);
+		if (c == 0 || c >= 0x80)
+			break;
+	}
+	return i;
+}
+
+// Returns the length of the multi-byte sequence at data,
+// or zero if it is not well-formed.
+inline size_t utf8_sequence(const char* data, size_t size) {
+	auto c = uint8_t(data[0]);
+	size_t len; uint32_t code_point, min;
+	if ((c & 0b1110'0000) == 0b1100'0000) {
+		len = 2; code_point = c & 0b0001'1111; min = 0x80;
+	}
+	else if ((c & 0b1111'0000) == 0b1110'0000) {
+		len = 3; code_point = c & 0b0000'1111; min = 0x800;
+	}
+	else if ((c & 0b1111'1000) == 0b1111'0000) {
+		len = 4; code_point = c & 0b0000'0111; min = 0x10000;
+	}
+	else
+		return 0;
+
+	if (size < len)
+		return 0;
+	for (size_t k = 1; k < len; ++k) {
+		auto cc = uint8_t(data[k]);
+		if ((cc & 0b1100'0000) != 0b1000'0000)
+			return 0;
+		code_point = code_point << 6 | (cc & 0b0011'1111);
+	}
+
+	bool surrogate = code_point >= 0xD800 && code_point <= 0xDFFF;
+	if (code_point < min || code_point > 0x10FFFF || surrogate)
+		return 0;
+	return len;
+}
+
+inline bool is_valid_mqtt_utf8(std::string_view str) {
+	const char* data = str.data();
+	size_t size = str.size();
+	for (size_t i = 0;;) {
+		i += ascii_prefix(data + i, size - i);
+		if (i == size)
+			return true;
+		if (data[i] == 0)
+			return false;
+		auto len = utf8_sequence(data + i, size - i);
+		if (len == 0)
+			return false;
+		i += len;
+	}
+}
+
+// Byte at a time, for reference.
+inline bool is_valid_mqtt_utf8_scalar(std::string_view str) {
+	for (size_t i = 0; i < str.size();) {
+		auto c = uint8_t(str[i]);
+		if (c == 0)
+			return false;
+		if (c < 0x80) {
+			++i;
+			continue;
+		}
+		auto len = utf8_sequence(str.data() + i, str.size() - i);
+		if (len == 0)
+			return false;
+		i += len;
+	}
+	return true;
+}
+
+// Topic Names must not contain wildcard characters.
+inline bool is_valid_topic_name(std::string_view topic) {
+	return
+		topic.size() <= 65535 &&
+		topic.find_first_of("+#") == std::string_view::npos &&
+		is_valid_mqtt_utf8(topic);
+}
+
+// In Topic Filters, a wildcard character occupies an entire level,
+// and the multi-level wildcard can only be the last level.
+inline bool is_valid_topic_filter(std::string_view filter) {
+	if (filter.empty() || filter.size() > 65535)
+		return false;
+
+	for (
+		auto pos = filter.find_first_of("+#");
+		pos != std::string_view::npos;
+		pos = filter.find_first_of("+#", pos + 1)
+	) {
+		bool level_start = pos == 0 || filter[pos - 1] == '/';
+		bool level_end = pos + 1 == filter.size() || filter[pos + 1] == '/';
+		if (!level_start || !level_end)
+			return false;
+		if (filter[pos] == '#' && pos + 1 != filter.size())
+			return false;
+	}
+
+	return is_valid_mqtt_utf8(filter);
+}
+
+// Checks the UTF-8 Encoded String properties, skipping
+// the Binary Data ones.
+template <typename Props>
+bool is_valid_mqtt_utf8(const Props& props) {
+	return props.visit([](auto p, const auto& value) -> bool {
+		using value_type = std::decay_t<decltype(value)>;
+		constexpr bool binary =
+			decltype(p)::value == prop::correlation_data ||
+			decltype(p)::value == prop::authentication_data;
+
+		if constexpr (std::is_same_v<value_type, std::optional<std::string>>)
+			return binary || !value || is_valid_mqtt_utf8(std::string_view(*value));
+		else if constexpr (std::is_same_v<value_type, std::vector<std::string>>)
+			return std::all_of(value.begin(), value.end(), [](const auto& s) {
+				return is_valid_mqtt_utf8(std::string_view(s));
+			});
+		else
+			return true;
+	});
+}
+
+inline error_code validate_publish_strings(
+	std::string_view topic, const publish_props& props
+) {
+	if (!is_valid_topic_name(topic))
+		return client::error::invalid_topic;
+	if (!is_valid_mqtt_utf8(props))
+		return client::error::malformed_string;
+	return {};
+}
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_UTF8_MQTT_HPP
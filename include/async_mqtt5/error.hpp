@@ -72,7 +72,28 @@ enum class error : int {
 	retain_not_available,
 
 	/** The Client attempted to send a Topic Alias that is greater than Topic Alias Maximum. */
-	topic_alias_maximum_reached
+	topic_alias_maximum_reached,
+
+	/** The outbound queue of the Client is full. */
+	queue_full,
+
+	/** The message was dropped to make room in the outbound queue. */
+	message_dropped,
+
+	/** The Topic Name or Topic Filter is not a valid UTF-8 Encoded String
+	 * or does not use the wildcard characters as the specification requires. */
+	invalid_topic,
+
+	/** A property is not a valid UTF-8 Encoded String. */
+	malformed_string,
+
+	/** The session store failed and the Client no longer records the in-flight state in it. */
+	session_store_failed,
+
+	/// \cond INTERNAL
+	/** A packet larger than the Maximum Packet Size has been received. */
+	packet_too_large
+	/// \endcond
 };
 
 
@@ -93,6 +114,19 @@ inline std::string client_error_to_string(error err) {
 		case topic_alias_maximum_reached:
 			return "The Client attempted to send a Topic Alias "
 				"that is greater than Topic Alias Maximum.";
+		case queue_full:
+			return "The outbound queue of the Client is full.";
+		case message_dropped:
+			return "The message was dropped to make room in the outbound queue.";
+		case invalid_topic:
+			return "The Topic Name or Topic Filter is not valid.";
+		case malformed_string:
+			return "A property is not a valid UTF-8 Encoded String.";
+		case session_store_failed:
+			return "The session store failed and the Client "
+				"no longer records the in-flight state in it.";
+		case packet_too_large:
+			return "A packet larger than the Maximum Packet Size has been received.";
 		default:
 			return "Unknown client error";
 	}
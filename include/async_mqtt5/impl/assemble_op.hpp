@@ -1,6 +1,8 @@
 #ifndef ASYNC_MQTT5_ASSEMBLE_OP_HPP
 #define ASYNC_MQTT5_ASSEMBLE_OP_HPP
 
+#include <algorithm>
+#include <optional>
 #include <string>
 
 #include <boost/asio/append.hpp>
@@ -14,8 +16,11 @@
 
 #include <async_mqtt5/detail/control_packet.hpp>
 #include <async_mqtt5/detail/internal_types.hpp>
+#include <async_mqtt5/detail/payload_stream.hpp>
+#include <async_mqtt5/detail/read_buffer.hpp>
 
 #include <async_mqtt5/impl/internal/codecs/base_decoders.hpp>
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
 
 
@@ -23,50 +28,183 @@ namespace async_mqtt5::detail {
 
 namespace asio = boost::asio;
 
-class data_span : private std::pair<byte_citer, byte_citer> {
-	using base = std::pair<byte_citer, byte_citer>;
+// A packet for read_message_op, or the error that ended the assembly.
+struct assembled_packet {
+	error_code ec;
+	uint8_t control_byte = 0;
+	byte_citer first, last;
+};
+
+/*
+
+Parses the packets buffered in the read buffer. Pings and replies are
+dispatched in place, so that all the acknowledgements received in one
+read are handled in a single pass, and parsing stops at the first packet
+for read_message_op, at an error, or when more bytes have to be read.
+
+*/
+
+template <typename ClientService>
+class packet_assembler {
+	using client_service = ClientService;
+
+	client_service& _svc;
+	read_buffer& _read_buff;
+
 public:
-	using base::base;
+	explicit packet_assembler(client_service& svc) :
+		_svc(svc), _read_buff(svc._read_buff)
+	{}
+
+	// Returns nothing if the buffered bytes do not complete a packet.
+	std::optional<assembled_packet> next() {
+		for (;;) {
+			if (_svc._payload_stream.active())
+				return stream_payload();
+
+			if (_read_buff.size() == 0)
+				return std::nullopt;
+
+			auto control_byte = uint8_t(*_read_buff.begin());
+
+			if ((control_byte & 0b11110000) == 0)
+				// close the connection, cancel
+				return error(client::error::malformed_packet);
 
-	auto first() const {
-		return base::first;
+			auto first = _read_buff.begin() + 1;
+			auto varlen = decoders::fast::decode_varint(first, _read_buff.end());
+
+			if (!varlen) {
+				if (_read_buff.size() < 5)
+					return std::nullopt;
+				return error(client::error::malformed_packet);
+			}
+
+			size_t header_size = std::distance(_read_buff.begin(), first);
+			if (header_size + *varlen > _svc.max_recv_packet_size())
+				return error(client::error::packet_too_large);
+
+			bool is_publish = control_code_e(control_byte & 0b11110000) ==
+				control_code_e::publish;
+			if (is_publish && _svc._payload_stream.streams(header_size + *varlen))
+				return start_stream(control_byte, header_size, *varlen);
+
+			if (std::distance(first, _read_buff.end()) < *varlen) {
+				_read_buff.make_room(header_size + *varlen);
+				return std::nullopt;
+			}
+
+			_read_buff.consume(header_size + *varlen);
+
+			auto packet = dispatch(control_byte, first, first + *varlen);
+			if (packet)
+				return packet;
+		}
 	}
-	auto last() const {
-		return base::second;
+
+private:
+	static assembled_packet error(client::error ec) {
+		return { ec, 0, {}, {} };
 	}
-	void expand_suffix(size_t num_chars) {
-		base::second += num_chars;
+
+	// Returns the fixed and variable header of a PUBLISH packet
+	// whose payload is streamed by subsequent reads.
+	std::optional<assembled_packet> start_stream(
+		uint8_t control_byte, size_t header_size, size_t remaining_length
+	) {
+		auto first = _read_buff.begin() + header_size;
+		auto var_header_size = payload_stream::variable_header_size(
+			control_byte, first, _read_buff.end()
+		);
+
+		if (!var_header_size) {
+			if (_read_buff.size() >= header_size + remaining_length)
+				return error(client::error::malformed_packet);
+			// grows geometrically while a large variable header is read
+			_read_buff.make_room(
+				std::min(header_size + remaining_length, 2 * _read_buff.size())
+			);
+			return std::nullopt;
+		}
+
+		if (*var_header_size > remaining_length)
+			return error(client::error::malformed_packet);
+
+		_read_buff.consume(header_size + *var_header_size);
+		_svc._payload_stream.start(remaining_length - *var_header_size);
+
+		return dispatch(control_byte, first, first + *var_header_size);
 	}
-	void remove_prefix(size_t num_chars) {
-		base::first += num_chars;
+
+	// Passes the buffered payload bytes to the payload sink and returns
+	// control code 0 once the whole payload has been consumed.
+	std::optional<assembled_packet> stream_payload() {
+		auto& stream = _svc._payload_stream;
+		_read_buff.consume(stream.consume(_read_buff.begin(), _read_buff.end()));
+
+		if (stream.finished())
+			return assembled_packet {};
+		return std::nullopt;
 	}
-	size_t size() const {
-		return std::distance(base::first, base::second);
+
+	static bool valid_header(uint8_t control_byte) {
+		using enum control_code_e;
+
+		auto code = control_code_e(control_byte & 0b11110000);
+
+		if (code == publish)
+			return true;
+
+		auto res = control_byte & 0b00001111;
+		if (code == pubrel)
+			return res == 0b00000010;
+		return res == 0b00000000;
 	}
-};
 
+	// Returns the packet if it is for read_message_op.
+	std::optional<assembled_packet> dispatch(
+		uint8_t control_byte, byte_citer first, byte_citer last
+	) {
+		using enum control_code_e;
+
+		if (!valid_header(control_byte))
+			return error(client::error::malformed_packet);
+
+		auto code = control_code_e(control_byte & 0b11110000);
+
+		if (code == pingresp)
+			return std::nullopt;
+
+		bool is_reply = code != publish && code != auth && code != disconnect;
+		if (is_reply) {
+			if (std::distance(first, last) < 2)
+				return error(client::error::malformed_packet);
+			auto packet_id = decoders::fast::decode_packet_id(first);
+			_svc._replies.dispatch(error_code {}, code, packet_id, first, last);
+			return std::nullopt;
+		}
+
+		return assembled_packet { error_code {}, control_byte, first, last };
+	}
+};
 
 template <typename ClientService, typename Handler>
 class assemble_op {
 	using client_service = ClientService;
 	struct on_read {};
 
-	static constexpr size_t max_packet_size = 65536;
-
 	client_service& _svc;
 	Handler _handler;
 
-	std::string& _read_buff;
-	data_span& _data_span;
+	read_buffer& _read_buff;
 
 public:
 	assemble_op(
-		client_service& svc, Handler&& handler,
-		std::string& read_buff, data_span& active_span
+		client_service& svc, Handler&& handler, read_buffer& read_buff
 	) :
 		_svc(svc),
 		_handler(std::move(handler)),
-		_read_buff(read_buff), _data_span(active_span)
+		_read_buff(read_buff)
 	{}
 
 	assemble_op(assemble_op&&) noexcept = default;
@@ -84,20 +222,12 @@ public:
 
 	template <typename CompletionCondition>
 	void perform(duration wait_for, CompletionCondition cc) {
-		_read_buff.erase(
-			_read_buff.cbegin(), _data_span.first()
-		);
-		// TODO: respect max packet size from CONNACK
-		_read_buff.resize(max_packet_size);
-		_data_span = {
-			_read_buff.cbegin(),
-			_read_buff.cbegin() + _data_span.size()
-		};
-
-		if (cc(error_code {}, 0) == 0 && _data_span.size()) {
-			/* TODO clear read buffer on reconnect
-			* OR use dispatch instead of post here
-			*/
+		bool buffered = _read_buff.size() || _svc._payload_stream.finished();
+		if (cc(error_code {}, 0) == 0 && buffered) {
+			// Bytes left in the buffer are parsed without reading more.
+			// They belong to the current connection, as a reconnect clears
+			// the buffer (see on_read). Posting rather than dispatching
+			// keeps a run of buffered packets from nesting the handlers.
 			return asio::post(
 				asio::prepend(
 					std::move(*this), on_read {}, error_code {},
@@ -107,11 +237,10 @@ public:
 		}
 
 		// Must be evaluated before this is moved
-		auto store_begin = _read_buff.data() + _data_span.size();
-		auto store_size = std::distance(_data_span.last(), _read_buff.cend());
+		auto store = _read_buff.prepare();
 
 		_svc._stream.async_read_some(
-			asio::buffer(store_begin, store_size), wait_for,
+			store, wait_for,
 			asio::prepend(
 				asio::append(std::move(*this), wait_for, std::move(cc)),
 				on_read {}
@@ -126,97 +255,34 @@ public:
 	) {
 		if (ec == asio::error::try_again) {
 			_svc.update_session_state();
+			_svc.reset_inbound_topic_aliases();
 			_svc._async_sender.resend();
-			_data_span = { _read_buff.cend(), _read_buff.cend() };
+			_svc._payload_stream.abort(asio::error::connection_aborted);
+			_read_buff.clear();
 			return perform(wait_for, std::move(cc));
 		}
 
-		if (ec)
-			return complete(ec, 0, {}, {});
-
-		_data_span.expand_suffix(bytes_read);
-		assert(_data_span.size());
-
-		auto control_byte = uint8_t(*_data_span.first());
-
-		if ((control_byte & 0b11110000) == 0)
-			// close the connection, cancel
-			return complete(client::error::malformed_packet, 0, {}, {});
-
-		auto first = _data_span.first() + 1;
-		auto varlen = decoders::type_parse(
-			first, _data_span.last(), decoders::basic::varint_
-		);
-
-		if (!varlen) {
-			if (_data_span.size() < 5)
-				return perform(wait_for, asio::transfer_at_least(1));
-			return complete(client::error::malformed_packet, 0, {}, {});
+		if (ec) {
+			_svc._payload_stream.abort(ec);
+			return complete({ ec, 0, {}, {} });
 		}
 
-		// TODO: respect max packet size which could be dinamically set by the broker
-		if (*varlen > max_packet_size - std::distance(_data_span.first(), first))
-			return complete(client::error::malformed_packet, 0, {}, {});
+		_read_buff.commit(bytes_read);
 
-		if (std::distance(first, _data_span.last()) < *varlen)
+		auto packet = packet_assembler { _svc }.next();
+		if (!packet)
 			return perform(wait_for, asio::transfer_at_least(1));
 
-		_data_span.remove_prefix(
-			std::distance(_data_span.first(), first) + *varlen
-		);
-
-		dispatch(wait_for, control_byte, first, first + *varlen);
+		complete(*packet);
 	}
 
 private:
-	static bool valid_header(uint8_t control_byte) {
-		using enum control_code_e;
-
-		auto code = control_code_e(control_byte & 0b11110000);
-
-		if (code == publish)
-			return true;
-
-		auto res = control_byte & 0b00001111;
-		if (code == pubrel)
-			return res == 0b00000010;
-		return res == 0b00000000;
-	}
-
-	void dispatch(
-		duration wait_for,
-		uint8_t control_byte, byte_citer first, byte_citer last
-	) {
-		using namespace decoders;
-		using enum control_code_e;
-
-		if (!valid_header(control_byte))
-			return complete(client::error::malformed_packet, 0, {}, {});
-
-		auto code = control_code_e(control_byte & 0b11110000);
-
-		if (code == pingresp)
-			return perform(wait_for, asio::transfer_at_least(0));
-
-		bool is_reply = code != publish && code != auth && code != disconnect;
-		if (is_reply) {
-			auto packet_id = decoders::decode_packet_id(first).value();
-			_svc._replies.dispatch(error_code {}, code, packet_id, first, last);
-			return perform(wait_for, asio::transfer_at_least(0));
-		}
-
-		complete(error_code {}, control_byte, first, last);
-	}
-
-	void complete(
-		error_code ec, uint8_t control_code,
-		byte_citer first, byte_citer last
-	) {
+	void complete(const assembled_packet& packet) {
 		asio::dispatch(
 			get_executor(),
 			asio::prepend(
-				std::move(_handler), ec, control_code,
-				first, last
+				std::move(_handler), packet.ec, packet.control_byte,
+				packet.first, packet.last
 			)
 		);
 	}
@@ -1,13 +1,25 @@
 #ifndef ASYNC_MQTT5_ASYNC_SENDER_HPP
 #define ASYNC_MQTT5_ASYNC_SENDER_HPP
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <vector>
+
 #include <boost/asio/any_completion_handler.hpp>
 #include <boost/asio/buffer.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/prepend.hpp>
+#include <boost/asio/recycling_allocator.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <boost/asio/ip/tcp.hpp>
 
+#include <async_mqtt5/error.hpp>
+
 #include <async_mqtt5/detail/internal_types.hpp>
+#include <async_mqtt5/detail/ring_buffer.hpp>
 
 namespace async_mqtt5::detail {
 
@@ -16,27 +28,43 @@ namespace asio = boost::asio;
 class write_req {
 	static constexpr unsigned SERIAL_BITS = sizeof(serial_num_t) * 8;
 
-	asio::const_buffer _buffer;
+	std::array<asio::const_buffer, 2> _buffers;
 	serial_num_t _serial_num;
 	unsigned _flags;
 	asio::any_completion_handler<void (error_code)> _handler;
 
 public:
 	write_req(
-		asio::const_buffer buffer,
+		const std::array<asio::const_buffer, 2>& buffers,
 		serial_num_t serial_num, unsigned flags,
 		asio::any_completion_handler<void (error_code)> handler
-	) : _buffer(buffer), _serial_num(serial_num), _flags(flags),
+	) : _buffers(buffers), _serial_num(serial_num), _flags(flags),
 		_handler(std::move(handler)) {}
 
 	static serial_num_t next_serial_num(serial_num_t last) {
 		return last + 1;
 	}
 
-	asio::const_buffer buffer() const { return _buffer; }
+	const std::array<asio::const_buffer, 2>& buffers() const {
+		return _buffers;
+	}
 	void complete(error_code ec) { std::move(_handler)(ec); }
 	bool throttled() const { return _flags & send_flag::throttled; }
 	bool terminal() const { return _flags & send_flag::terminal; }
+	bool bounded() const { return _flags & send_flag::bounded; }
+	bool droppable() const { return _flags & send_flag::droppable; }
+
+	// 0 denotes control packets, see traffic_class_e for the rest
+	size_t traffic_class() const {
+		if (prioritized())
+			return 0;
+		return (_flags & send_flag::traffic_class_mask) >>
+			send_flag::traffic_class_shift;
+	}
+
+	size_t byte_size() const {
+		return asio::buffer_size(_buffers);
+	}
 
 	bool operator<(const write_req& other) const {
 		if (prioritized() != other.prioritized()) {
@@ -55,15 +83,262 @@ private:
 	bool prioritized() const { return _flags & send_flag::prioritized; }
 };
 
+// Outbound requests queued per traffic class. Within a class, requests
+// are kept in two FIFO lanes so that throttled requests blocked by the
+// Receive Maximum quota never hold back unthrottled ones. Control packets
+// have strict priority while publish traffic classes share the remaining
+// per-write byte budget by deficit round robin, proportionally to
+// their weights.
+// Enqueuing and taking requests are O(1) amortized, so the cost of
+// a write depends on the number of requests written, not queued.
+class write_queue {
+	using lane_type = ring_buffer<write_req>;
+
+	struct class_queue {
+		lane_type unthrottled;
+		lane_type throttled;
+		size_t weight { 1 };
+		size_t deficit { 0 };
+	};
+
+	static constexpr size_t NUM_CLASSES = 4;
+	static constexpr size_t CONTROL_CLASS = 0;
+	static constexpr size_t QUANTUM = 4096;
+	static constexpr size_t DEFAULT_MAX_WRITE_BYTES = 256 * 1024;
+
+	lane_type _terminal;
+	std::array<class_queue, NUM_CLASSES> _classes;
+
+	size_t _size { 0 };
+	size_t _bytes { 0 };
+
+	size_t _max_write_bytes { DEFAULT_MAX_WRITE_BYTES };
+	size_t _drr_current { 1 };
+	bool _drr_in_turn { false };
+
+public:
+	write_queue() {
+		weights(4, 2, 1);
+	}
+
+	void weights(size_t alarm, size_t telemetry, size_t bulk) {
+		_classes[size_t(traffic_class_e::alarm)].weight = std::max<size_t>(alarm, 1);
+		_classes[size_t(traffic_class_e::telemetry)].weight = std::max<size_t>(telemetry, 1);
+		_classes[size_t(traffic_class_e::bulk)].weight = std::max<size_t>(bulk, 1);
+	}
+
+	void max_write_bytes(size_t max_write_bytes) {
+		_max_write_bytes = max_write_bytes;
+	}
+
+	bool empty() const { return _size == 0; }
+	size_t size() const { return _size; }
+	size_t bytes() const { return _bytes; }
+
+	// Whether take would move any request into a write.
+	bool writable(uint16_t quota, bool limited) const {
+		if (!_terminal.empty())
+			return true;
+		bool throttled = !limited || quota > 0;
+		return std::any_of(
+			_classes.begin(), _classes.end(),
+			[throttled](const class_queue& cq) {
+				return !cq.unthrottled.empty() ||
+					(throttled && !cq.throttled.empty());
+			}
+		);
+	}
+
+	void push(write_req req) {
+		++_size;
+		_bytes += req.byte_size();
+
+		if (req.terminal())
+			return _terminal.push_back(std::move(req));
+
+		auto& cq = _classes[req.traffic_class()];
+		if (req.throttled())
+			cq.throttled.push_back(std::move(req));
+		else
+			cq.unthrottled.push_back(std::move(req));
+	}
+
+	template <typename Allocator>
+	std::vector<write_req, Allocator> drain(const Allocator& alloc) {
+		std::vector<write_req, Allocator> reqs(alloc);
+		reqs.reserve(_size);
+
+		auto move_lane = [&reqs](lane_type& lane) {
+			for (; !lane.empty(); lane.pop_front())
+				reqs.push_back(std::move(lane.front()));
+		};
+
+		move_lane(_terminal);
+		for (auto& cq : _classes) {
+			move_lane(cq.unthrottled);
+			move_lane(cq.throttled);
+			cq.deficit = 0;
+		}
+
+		_size = _bytes = 0;
+		_drr_in_turn = false;
+		return reqs;
+	}
+
+	// Restores the publish order after requests have been queued
+	// for resending.
+	void sort() {
+		for (auto& cq : _classes) {
+			sort_lane(cq.unthrottled);
+			sort_lane(cq.throttled);
+		}
+	}
+
+	// Takes the oldest droppable request of the publish traffic classes.
+	// Droppable requests are never throttled.
+	std::optional<write_req> take_droppable() {
+		lane_type* oldest = nullptr;
+		for (size_t c = CONTROL_CLASS + 1; c < NUM_CLASSES; ++c) {
+			auto& lane = _classes[c].unthrottled;
+			if (lane.empty() || !lane.front().droppable())
+				continue;
+			if (!oldest || lane.front() < oldest->front())
+				oldest = &lane;
+		}
+		if (!oldest)
+			return std::nullopt;
+		return pop(*oldest);
+	}
+
+	template <typename Allocator>
+	bool take_terminal(std::vector<write_req, Allocator>& out) {
+		if (_terminal.empty())
+			return false;
+		out.push_back(pop(_terminal));
+		return true;
+	}
+
+	// Moves the requests to be written next into out. Throttled requests
+	// are taken only while quota is not exhausted (quota is not consulted
+	// if limited is false).
+	template <typename Allocator>
+	void take(
+		std::vector<write_req, Allocator>& out,
+		uint16_t& quota, bool limited
+	) {
+		size_t budget = _max_write_bytes ?
+			_max_write_bytes : std::numeric_limits<size_t>::max();
+		size_t taken = 0;
+
+		auto& control = _classes[CONTROL_CLASS];
+		while (auto lane = next_lane(control, quota, limited))
+			taken += take_one(out, *lane, quota, limited);
+
+		constexpr size_t first_class = CONTROL_CLASS + 1;
+		constexpr size_t num_weighted = NUM_CLASSES - first_class;
+
+		size_t idle = 0;
+		while (idle < num_weighted && (taken < budget || out.empty())) {
+			auto& cq = _classes[_drr_current];
+
+			if (!next_lane(cq, quota, limited)) {
+				cq.deficit = 0;
+				next_class();
+				++idle;
+				continue;
+			}
+			idle = 0;
+
+			if (!_drr_in_turn) {
+				cq.deficit += cq.weight * QUANTUM;
+				_drr_in_turn = true;
+			}
+
+			while (auto lane = next_lane(cq, quota, limited)) {
+				auto size = lane->front().byte_size();
+				if (size > cq.deficit)
+					break;
+				if (taken >= budget && !out.empty())
+					return; // continue this turn in the next write
+				cq.deficit -= size;
+				taken += take_one(out, *lane, quota, limited);
+			}
+
+			if (!next_lane(cq, quota, limited))
+				cq.deficit = 0;
+			next_class();
+		}
+	}
+
+private:
+	static void sort_lane(lane_type& lane) {
+		std::vector<write_req> reqs;
+		reqs.reserve(lane.size());
+		for (; !lane.empty(); lane.pop_front())
+			reqs.push_back(std::move(lane.front()));
+
+		std::stable_sort(reqs.begin(), reqs.end());
+
+		for (auto& req : reqs)
+			lane.push_back(std::move(req));
+	}
+
+	void next_class() {
+		_drr_in_turn = false;
+		if (++_drr_current == NUM_CLASSES)
+			_drr_current = CONTROL_CLASS + 1;
+	}
+
+	// The lane holding the oldest request of the class that can be
+	// written now, if any.
+	lane_type* next_lane(class_queue& cq, uint16_t quota, bool limited) {
+		bool unthrottled = !cq.unthrottled.empty();
+		bool throttled = !cq.throttled.empty() && (!limited || quota > 0);
+
+		if (unthrottled && throttled)
+			return cq.throttled.front() < cq.unthrottled.front() ?
+				&cq.throttled : &cq.unthrottled;
+		if (unthrottled)
+			return &cq.unthrottled;
+		if (throttled)
+			return &cq.throttled;
+		return nullptr;
+	}
+
+	template <typename Allocator>
+	size_t take_one(
+		std::vector<write_req, Allocator>& out, lane_type& lane,
+		uint16_t& quota, bool limited
+	) {
+		if (limited && lane.front().throttled())
+			--quota;
+		out.push_back(pop(lane));
+		return out.back().byte_size();
+	}
+
+	write_req pop(lane_type& lane) {
+		auto req = std::move(lane.front());
+		lane.pop_front();
+		--_size;
+		_bytes -= req.byte_size();
+		return req;
+	}
+};
+
 template <typename ClientService>
 class async_sender {
 	using client_service = ClientService;
 
+	struct on_linger {};
+
 	using queue_allocator_type = asio::recycling_allocator<write_req>;
 	using write_queue_t = std::vector<write_req, queue_allocator_type>;
+	using buffers_t = std::vector<
+		asio::const_buffer, asio::recycling_allocator<asio::const_buffer>
+	>;
 
 	ClientService& _svc;
-	write_queue_t _write_queue;
+	write_queue _write_queue;
 	bool _write_in_progress { false };
 
 	static constexpr uint16_t MAX_LIMIT = 65535;
@@ -72,8 +347,26 @@ class async_sender {
 
 	serial_num_t _last_serial_num { 0 };
 
+	// Write coalescing: unless a threshold is reached, queued requests
+	// are held for at most the linger time before they are written.
+	write_coalescing _coalescing;
+	asio::steady_timer _linger_timer;
+	bool _linger_armed { false };
+	bool _flush { false };
+
+	write_stats _stats;
+
+	// Bounded queue: new PUBLISH packets that do not fit are rejected,
+	// make room by dropping QoS 0 packets or wait in _blocked.
+	write_limits _limits;
+	bool _writable { true };
+	ring_buffer<write_req> _blocked;
+	std::vector<asio::any_completion_handler<void (error_code)>> _writable_waiters;
+
 public:
-	explicit async_sender(ClientService& svc) : _svc(svc) {}
+	explicit async_sender(ClientService& svc) :
+		_svc(svc), _linger_timer(svc.get_executor())
+	{}
 
 	using executor_type = typename client_service::executor_type;
 	executor_type get_executor() const noexcept {
@@ -89,6 +382,42 @@ public:
 		return _last_serial_num = write_req::next_serial_num(_last_serial_num);
 	}
 
+	void coalescing(write_coalescing coalescing) {
+		_coalescing = coalescing;
+	}
+
+	void traffic_class_weights(
+		size_t alarm, size_t telemetry, size_t bulk, size_t max_write_bytes
+	) {
+		_write_queue.weights(alarm, telemetry, bulk);
+		_write_queue.max_write_bytes(max_write_bytes);
+	}
+
+	void limits(write_limits limits) {
+		_limits = limits;
+	}
+
+	const write_stats& stats() const {
+		return _stats;
+	}
+
+	size_t queued_bytes() const {
+		return _write_queue.bytes();
+	}
+
+	template <typename CompletionToken>
+	decltype(auto) async_wait_writable(CompletionToken&& token) {
+		auto initiation = [this](auto handler) {
+			if (_writable)
+				return complete_post(std::move(handler), error_code {});
+			_writable_waiters.emplace_back(std::move(handler));
+		};
+
+		return asio::async_initiate<CompletionToken, void (error_code)>(
+			std::move(initiation), token
+		);
+	}
+
 	template <typename CompletionToken, typename BufferType>
 	decltype(auto) async_send(
 		const BufferType& buffer,
@@ -99,9 +428,11 @@ public:
 			auto handler, const BufferType& buffer,
 			serial_num_t serial_num, unsigned flags
 		) {
-			_write_queue.emplace_back(
-				asio::buffer(buffer), serial_num, flags, std::move(handler)
-			);
+			enqueue(write_req {
+				buffer, serial_num, flags, std::move(handler)
+			});
+			if (flags & (send_flag::prioritized | send_flag::terminal))
+				_flush = true;
 			do_write();
 		};
 
@@ -110,10 +441,47 @@ public:
 		);
 	}
 
+	// Enqueues all requests at once and starts at most one write.
+	// The write limits admit or reject the batch as a whole.
+	template <typename Allocator>
+	void send_batch(std::vector<write_req, Allocator> write_reqs) {
+		if (
+			!_limits.enabled() ||
+			_limits.policy == overflow_policy_e::block
+		) {
+			for (auto& req : write_reqs)
+				enqueue(std::move(req));
+			return do_write();
+		}
+
+		if (!admit_batch(write_reqs)) {
+			_writable = false;
+			for (auto& req : write_reqs) {
+				++_stats.rejected;
+				post_completion(std::move(req), client::error::queue_full);
+			}
+			return;
+		}
+
+		for (auto& req : write_reqs)
+			_write_queue.push(std::move(req));
+		update_writable();
+		do_write();
+	}
+
 	void cancel() {
-		auto ops = std::move(_write_queue);
+		cancel_linger();
+		auto ops = _write_queue.drain(get_allocator());
+		for (; !_blocked.empty(); _blocked.pop_front())
+			ops.push_back(std::move(_blocked.front()));
 		for (auto& op : ops)
 			op.complete(asio::error::operation_aborted);
+
+		_writable = true;
+		auto waiters = std::move(_writable_waiters);
+		_writable_waiters.clear();
+		for (auto& waiter : waiters)
+			complete_post(std::move(waiter), asio::error::operation_aborted);
 	}
 
 	void resend() {
@@ -129,15 +497,22 @@ public:
 		_limit = new_limit.value_or(MAX_LIMIT);
 		_quota = _limit;
 
-		auto write_queue = std::move(_write_queue);
+		// Topic Aliases do not outlive the Network Connection
+		_svc._topic_aliases.reset(
+			_svc._stream_context.connack_prop(prop::topic_alias_maximum)
+				.value_or(0)
+		);
+
+		auto write_queue = _write_queue.drain(get_allocator());
 		_svc._replies.resend_unanswered();
 
 		for (auto& op : write_queue)
 			op.complete(asio::error::try_again);
 
-		std::stable_sort(_write_queue.begin(), _write_queue.end());
+		_write_queue.sort();
 
 		_write_in_progress = false;
+		_flush = true;
 		do_write();
 	}
 
@@ -146,11 +521,8 @@ public:
 
 		if (ec == asio::error::try_again) {
 			_svc.update_session_state();
-			_write_queue.insert(
-				_write_queue.begin(),
-				std::make_move_iterator(write_queue.begin()),
-				std::make_move_iterator(write_queue.end())
-			);
+			for (auto& op : write_queue)
+				_write_queue.push(std::move(op));
 			return resend();
 		}
 
@@ -167,6 +539,16 @@ public:
 		do_write();
 	}
 
+	void operator()(on_linger, error_code ec) {
+		if (ec || !_linger_armed)
+			return;
+
+		_linger_armed = false;
+		_flush = true;
+		++_stats.linger_expirations;
+		do_write();
+	}
+
 	void throttled_op_done() {
 		if (_limit == MAX_LIMIT)
 			return;
@@ -177,50 +559,41 @@ public:
 
 private:
 	void do_write() {
-		if (_write_in_progress || _write_queue.empty())
+		if (_write_in_progress)
 			return;
 
-		_write_in_progress = true;
+		// throttled requests wait for the quota, not for the linger time
+		if (!_write_queue.writable(_quota, _limit != MAX_LIMIT))
+			return cancel_linger();
+
+		if (should_linger())
+			return;
 
 		write_queue_t write_queue;
 
-		auto terminal_req = std::find_if(
-			_write_queue.begin(), _write_queue.end(),
-			[](const auto& op) { return op.terminal(); }
-		);
-		if (terminal_req != _write_queue.end()) {
-			write_queue.push_back(std::move(*terminal_req));
-			_write_queue.erase(terminal_req);
-		}
-		else if (_limit == MAX_LIMIT)
-			write_queue = std::move(_write_queue);
-		else {
-			auto throttled_ptr = std::stable_partition(
-				_write_queue.begin(), _write_queue.end(),
-				[](const auto& op) { return !op.throttled(); }
-			);
-			uint16_t dist = std::distance(throttled_ptr, _write_queue.end());
-			uint16_t throttled_num = std::min(dist, _quota);
-			_quota -= throttled_num;
-			throttled_ptr += throttled_num;
+		if (!_write_queue.take_terminal(write_queue))
+			_write_queue.take(write_queue, _quota, _limit != MAX_LIMIT);
 
-			if (throttled_ptr == _write_queue.begin()) {
-				_write_in_progress = false;
-				return;
-			}
+		if (write_queue.empty())
+			return;
 
-			write_queue.insert(
-				write_queue.end(),
-				std::make_move_iterator(_write_queue.begin()),
-				std::make_move_iterator(throttled_ptr)
-			);
-			_write_queue.erase(_write_queue.begin(), throttled_ptr);
-		}
+		update_writable();
+
+		_write_in_progress = true;
 
-		std::vector<asio::const_buffer> buffers;
-		buffers.reserve(write_queue.size());
+		buffers_t buffers;
+		buffers.reserve(2 * write_queue.size());
 		for (const auto& op : write_queue)
-			buffers.push_back(op.buffer());
+			for (const auto& buff : op.buffers())
+				if (buff.size())
+					buffers.push_back(buff);
+
+		_flush = false;
+		cancel_linger();
+
+		++_stats.writes;
+		_stats.packets += write_queue.size();
+		_stats.bytes += asio::buffer_size(buffers);
 
 		_svc._replies.clear_fast_replies();
 
@@ -230,6 +603,161 @@ private:
 		);
 	}
 
+	bool should_linger() {
+		if (!_coalescing.enabled() || _flush)
+			return false;
+
+		// a threshold of zero is not applied
+		if (
+			(_coalescing.max_packets &&
+				_write_queue.size() >= _coalescing.max_packets) ||
+			(_coalescing.max_bytes &&
+				_write_queue.bytes() >= _coalescing.max_bytes)
+		)
+			return false;
+
+		if (!_linger_armed) {
+			_linger_armed = true;
+			_linger_timer.expires_after(_coalescing.linger);
+			_linger_timer.async_wait(
+				asio::prepend(std::ref(*this), on_linger {})
+			);
+		}
+		return true;
+	}
+
+	void cancel_linger() {
+		if (!_linger_armed)
+			return;
+		_linger_armed = false;
+		_linger_timer.cancel();
+	}
+
+	// Queues a request, applying the write limits to new PUBLISH packets.
+	void enqueue(write_req req) {
+		if (!req.bounded() || !_limits.enabled())
+			return _write_queue.push(std::move(req));
+
+		if (!_blocked.empty()) // blocked packets keep their publish order
+			return _blocked.push_back(std::move(req));
+
+		auto size = req.byte_size();
+		if (
+			!fits(size) &&
+			_limits.policy == overflow_policy_e::drop_oldest_qos0
+		)
+			make_room(size);
+
+		if (fits(size)) {
+			_write_queue.push(std::move(req));
+			return update_writable();
+		}
+
+		_writable = false;
+		if (_limits.policy == overflow_policy_e::block)
+			return _blocked.push_back(std::move(req));
+
+		++_stats.rejected;
+		post_completion(std::move(req), client::error::queue_full);
+	}
+
+	// Checks whether the bounded requests of a batch fit together,
+	// dropping older QoS 0 packets to make room if the policy allows.
+	template <typename Allocator>
+	bool admit_batch(const std::vector<write_req, Allocator>& write_reqs) {
+		size_t size = 0, packets = 0;
+		for (const auto& req : write_reqs)
+			if (req.bounded()) {
+				size += req.byte_size();
+				++packets;
+			}
+
+		if (
+			!fits(size, packets) &&
+			_limits.policy == overflow_policy_e::drop_oldest_qos0
+		)
+			make_room(size, packets);
+
+		return fits(size, packets);
+	}
+
+	// Requests always fit into an empty queue, however large they are.
+	bool fits(size_t size, size_t packets = 1) const {
+		if (_write_queue.empty())
+			return true;
+		if (_limits.max_bytes && _write_queue.bytes() + size > _limits.max_bytes)
+			return false;
+		if (
+			_limits.max_packets &&
+			_write_queue.size() + packets > _limits.max_packets
+		)
+			return false;
+		return true;
+	}
+
+	bool at_high_watermark() const {
+		return
+			(_limits.max_bytes && _write_queue.bytes() >= _limits.max_bytes) ||
+			(_limits.max_packets && _write_queue.size() >= _limits.max_packets);
+	}
+
+	bool at_low_watermark() const {
+		return
+			(!_limits.max_bytes || _write_queue.bytes() <= _limits.low_bytes) &&
+			(!_limits.max_packets || _write_queue.size() <= _limits.low_packets);
+	}
+
+	void make_room(size_t size, size_t packets = 1) {
+		while (!fits(size, packets)) {
+			auto req = _write_queue.take_droppable();
+			if (!req)
+				return;
+			++_stats.dropped;
+			post_completion(std::move(*req), client::error::message_dropped);
+		}
+	}
+
+	void update_writable() {
+		if (!_limits.enabled())
+			return;
+
+		if (_writable) {
+			_writable = !at_high_watermark();
+			return;
+		}
+
+		if (!at_low_watermark())
+			return;
+
+		for (; !_blocked.empty(); _blocked.pop_front()) {
+			if (!fits(_blocked.front().byte_size()))
+				break;
+			_write_queue.push(std::move(_blocked.front()));
+		}
+
+		_writable = _blocked.empty() && !at_high_watermark();
+		if (!_writable)
+			return;
+
+		auto waiters = std::move(_writable_waiters);
+		_writable_waiters.clear();
+		for (auto& waiter : waiters)
+			complete_post(std::move(waiter), error_code {});
+	}
+
+	void post_completion(write_req req, error_code ec) {
+		asio::post(
+			get_executor(),
+			[req = std::move(req), ec]() mutable { req.complete(ec); }
+		);
+	}
+
+	template <typename Handler>
+	void complete_post(Handler&& handler, error_code ec) {
+		auto ex = asio::get_associated_executor(handler, get_executor());
+		asio::post(ex, asio::prepend(std::move(handler), ec));
+	}
+
 };
 
 } // end namespace async_mqtt5::detail
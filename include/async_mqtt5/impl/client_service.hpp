@@ -1,10 +1,16 @@
 #ifndef ASYNC_MQTT5_CLIENT_SERVICE_HPP
 #define ASYNC_MQTT5_CLIENT_SERVICE_HPP
 
-#include <boost/asio/experimental/basic_concurrent_channel.hpp>
+#include <async_mqtt5/message_view.hpp>
 
+#include <async_mqtt5/detail/any_session_store.hpp>
 #include <async_mqtt5/detail/internal_types.hpp>
-#include <async_mqtt5/detail/channel_traits.hpp>
+#include <async_mqtt5/detail/control_packet.hpp>
+#include <async_mqtt5/detail/payload_stream.hpp>
+#include <async_mqtt5/detail/read_buffer.hpp>
+#include <async_mqtt5/detail/receive_queue.hpp>
+#include <async_mqtt5/detail/spill_log.hpp>
+#include <async_mqtt5/detail/topic_alias_table.hpp>
 
 #include <async_mqtt5/impl/assemble_op.hpp>
 #include <async_mqtt5/impl/async_sender.hpp>
@@ -107,7 +113,8 @@ public:
 
 template <
 	typename StreamType,
-	typename TlsContext = std::monostate
+	typename TlsContext = std::monostate,
+	receive_queue_e ReceiveQueue = receive_queue_e::concurrent
 >
 class client_service {
 	using stream_context_type = stream_context<StreamType, TlsContext>;
@@ -118,11 +125,19 @@ public:
 	using executor_type = typename stream_type::executor_type;
 private:
 	using tls_context_type = TlsContext;
-	using receive_channel = asio::experimental::basic_concurrent_channel<
-		asio::any_io_executor,
-		channel_traits<>,
+	using receive_channel = receive_queue_t<
+		ReceiveQueue,
 		void (error_code, std::string, std::string, publish_props)
 	>;
+	using view_channel = receive_queue_t<
+		ReceiveQueue,
+		void (error_code, message_view)
+	>;
+
+	// Sent in the CONNECT packet unless set with maximum_packet_size,
+	// so that the Broker cannot make the Client reserve up to 256 MiB
+	// for a single packet.
+	static constexpr uint32_t DEFAULT_MAX_PACKET_SIZE = 16 * 1024 * 1024;
 
 	template <typename ClientService>
 	friend class async_sender;
@@ -130,6 +145,9 @@ private:
 	template <typename ClientService, typename Handler>
 	friend class assemble_op;
 
+	template <typename ClientService>
+	friend class packet_assembler;
+
 	template <typename ClientService>
 	friend class ping_op;
 
@@ -143,13 +161,23 @@ private:
 	stream_type _stream;
 
 	packet_id_allocator _pid_allocator;
+	topic_alias_table _topic_aliases;
+	inbound_topic_alias_table _inbound_topic_aliases;
+	spill_log _spill_log;
+	any_session_store _session_store;
+	// set while cancelled operations complete, so that their state stays
+	// in the session store
+	bool _session_suspended { false };
 	replies _replies;
 	async_sender<client_service> _async_sender;
 
-	std::string _read_buff;
-	data_span _active_span;
+	read_buffer _read_buff;
+	payload_stream _payload_stream;
 
 	receive_channel _rec_channel;
+	view_channel _view_channel;
+	bool _zero_copy_receive { false };
+	bool _utf8_validation { true };
 
 	asio::cancellation_signal _cancel_ping;
 	asio::cancellation_signal _cancel_sentry;
@@ -164,9 +192,11 @@ public:
 		_stream_context(std::move(tls_context)),
 		_stream(ex, _stream_context),
 		_async_sender(*this),
-		_active_span(_read_buff.cend(), _read_buff.cend()),
-		_rec_channel(ex, std::numeric_limits<size_t>::max())
-	{}
+		_rec_channel(ex, std::numeric_limits<size_t>::max()),
+		_view_channel(ex, std::numeric_limits<size_t>::max())
+	{
+		maximum_packet_size(DEFAULT_MAX_PACKET_SIZE);
+	}
 
 	executor_type get_executor() const noexcept {
 		return _stream.get_executor();
@@ -206,14 +236,269 @@ public:
 			);
 	}
 
+	void coalescing(write_coalescing coalescing) {
+		if (!is_open())
+			_async_sender.coalescing(coalescing);
+	}
+
+	void traffic_class_weights(
+		size_t alarm, size_t telemetry, size_t bulk, size_t max_write_bytes
+	) {
+		if (!is_open())
+			_async_sender.traffic_class_weights(
+				alarm, telemetry, bulk, max_write_bytes
+			);
+	}
+
+	void queue_limits(write_limits limits) {
+		if (!is_open())
+			_async_sender.limits(limits);
+	}
+
+	template <typename CompletionToken>
+	decltype(auto) async_wait_writable(CompletionToken&& token) {
+		return _async_sender.async_wait_writable(
+			std::forward<CompletionToken>(token)
+		);
+	}
+
+	void reply_timeouts(const async_mqtt5::reply_timeouts& timeouts) {
+		if (!is_open())
+			_replies.timeouts(timeouts);
+	}
+
+	void offline_spill(
+		std::string directory, size_t memory_limit, size_t segment_size
+	) {
+		if (!is_open())
+			_spill_log.configure(
+				std::move(directory), memory_limit, segment_size
+			);
+	}
+
+	// Once more than the memory limit is queued, QoS 1 and QoS 2 PUBLISH
+	// packets are moved to the spill log before they are queued.
+	template <typename Allocator>
+	void spill(control_packet<Allocator>& publish) {
+		if (
+			_spill_log.enabled() &&
+			_async_sender.queued_bytes() >= _spill_log.memory_limit()
+		)
+			publish.spill(_spill_log);
+	}
+
+	template <typename SessionStore>
+	void session_store(SessionStore&& store) {
+		if (!is_open())
+			_session_store = any_session_store(
+				std::forward<SessionStore>(store)
+			);
+	}
+
+	bool session_store_enabled() const {
+		return _session_store.enabled();
+	}
+
+	template <typename Allocator>
+	void store_publish(const control_packet<Allocator>& publish) {
+		if (!_session_store.enabled())
+			return;
+		const auto& [header, payload] = publish.wire_data();
+		store_publish(
+			publish.packet_id(),
+			{ static_cast<const char*>(header.data()), header.size() },
+			{ static_cast<const char*>(payload.data()), payload.size() }
+		);
+	}
+
+	void store_publish(
+		uint16_t packet_id, std::string_view header, std::string_view payload
+	) {
+		check_session_store(_session_store.store(
+			session_entry_e::publish, packet_id, header, payload
+		));
+	}
+
+	void store_pubrel(uint16_t packet_id) {
+		check_session_store(
+			_session_store.store(session_entry_e::pubrel, packet_id, {}, {})
+		);
+	}
+
+	void store_inbound_publish(
+		uint16_t packet_id, std::string_view header, std::string_view payload
+	) {
+		check_session_store(_session_store.store(
+			session_entry_e::inbound_publish, packet_id, header, payload
+		));
+	}
+
+	void erase_inbound_publish(uint16_t packet_id) {
+		if (!_session_suspended)
+			check_session_store(_session_store.erase(
+				session_entry_e::inbound_publish, packet_id
+			));
+	}
+
+	// Returns the stored entries to be resumed, with their Packet
+	// Identifiers of outgoing packets allocated.
+	std::vector<session_entry> restore_session() {
+		std::vector<session_entry> entries;
+		if (!check_session_store(_session_store.load(entries)))
+			return entries;
+		std::erase_if(entries, [this](const session_entry& entry) {
+			if (
+				entry.kind == session_entry_e::inbound_publish ||
+				_pid_allocator.reserve(entry.packet_id)
+			)
+				return false;
+			check_session_store(
+				_session_store.erase(entry.kind, entry.packet_id)
+			);
+			return true;
+		});
+		return entries;
+	}
+
+	// The session store detaches itself when it fails, so the in-flight
+	// state kept in memory stays consistent; the failure is reported once.
+	bool check_session_store(bool stored) {
+		if (!stored)
+			channel_store_error(client::error::session_store_failed);
+		return stored;
+	}
+
+	void topic_aliasing(bool enable) {
+		if (!is_open())
+			_topic_aliases.enable(enable);
+	}
+
+	topic_alias_table& topic_aliases() {
+		return _topic_aliases;
+	}
+
+	void topic_alias_maximum(uint16_t topic_alias_maximum) {
+		if (is_open())
+			return;
+		auto& co_props = _stream_context.mqtt_context().co_props;
+		if (topic_alias_maximum)
+			co_props[prop::topic_alias_maximum] = topic_alias_maximum;
+		else
+			co_props[prop::topic_alias_maximum] = std::nullopt;
+	}
+
+	void maximum_packet_size(uint32_t size) {
+		if (is_open())
+			return;
+		auto& co_props = _stream_context.mqtt_context().co_props;
+		if (size)
+			co_props[prop::maximum_packet_size] = int32_t(
+				std::min<uint32_t>(size, std::numeric_limits<int32_t>::max())
+			);
+		else
+			co_props[prop::maximum_packet_size] = std::nullopt;
+	}
+
+	// The Broker must not send packets larger than the Maximum Packet Size
+	// the Client sent in the CONNECT packet.
+	size_t max_recv_packet_size() {
+		auto& co_props = _stream_context.mqtt_context().co_props;
+		return co_props[prop::maximum_packet_size].value_or(
+			std::numeric_limits<int32_t>::max()
+		);
+	}
+
+	void receive_buffer(size_t size, duration shrink_delay) {
+		if (!is_open())
+			_read_buff.configure(size, shrink_delay);
+	}
+
+	template <typename PayloadSink>
+	void payload_sink(PayloadSink&& sink, size_t threshold) {
+		if (!is_open())
+			_payload_stream.configure(
+				std::forward<PayloadSink>(sink), threshold
+			);
+	}
+
+	bool payload_stream_starting() const {
+		return _payload_stream.starting();
+	}
+
+	void begin_payload_stream(decoders::publish_message message) {
+		_payload_stream.begin(std::move(message));
+	}
+
+	std::optional<decoders::publish_message> end_payload_stream() {
+		return _payload_stream.finish();
+	}
+
+	// Topic Aliases the Broker uses are valid for a single connection.
+	void reset_inbound_topic_aliases() {
+		auto& co_props = _stream_context.mqtt_context().co_props;
+		_inbound_topic_aliases.reset(
+			co_props[prop::topic_alias_maximum].value_or(0)
+		);
+	}
+
+	std::optional<disconnect_rc_e> resolve_topic_alias(
+		decoders::publish_message& message
+	) {
+		auto& [topic, packet_id, flags, props, payload] = message;
+		return _inbound_topic_aliases.resolve(topic, props[prop::topic_alias]);
+	}
+
+	std::optional<disconnect_rc_e> resolve_topic_alias(
+		decoders::publish_message_view& message
+	) {
+		auto& view = std::get<0>(message);
+		auto topic_alias = view.props()[prop::topic_alias];
+		if (!topic_alias)
+			return std::nullopt;
+
+		auto topic = std::string(view.topic());
+		auto rc = _inbound_topic_aliases.resolve(topic, topic_alias);
+		if (!rc && view.topic().empty())
+			view.aliased_topic(std::move(topic));
+		return rc;
+	}
+
+	void zero_copy_receive(bool enable) {
+		if (!is_open())
+			_zero_copy_receive = enable;
+	}
+
+	bool zero_copy_receive() const {
+		return _zero_copy_receive;
+	}
+
+	void utf8_validation(bool enable) {
+		if (!is_open())
+			_utf8_validation = enable;
+	}
+
+	bool utf8_validation() const {
+		return _utf8_validation;
+	}
+
+	std::shared_ptr<const std::string> share_read_buffer() const {
+		return _read_buff.share();
+	}
+
+	const write_stats& stats() const {
+		return _async_sender.stats();
+	}
+
 	template <typename Prop>
 	decltype(auto) connack_prop(Prop p) {
 		return _stream_context.connack_prop(p);
 	}
 
 	void run() {
+		_session_suspended = false;
 		_stream.open();
 		_rec_channel.reset();
+		_view_channel.reset();
 	}
 
 	void open_stream() {
@@ -229,10 +514,12 @@ public:
 	}
 
 	void cancel() {
+		_session_suspended = true;
 		_cancel_ping.emit(asio::cancellation_type::terminal);
 		_cancel_sentry.emit(asio::cancellation_type::terminal);
 
 		_rec_channel.close();
+		_view_channel.close();
 		_replies.cancel_unanswered();
 		_async_sender.cancel();
 		_stream.close();
@@ -242,7 +529,15 @@ public:
 		return _pid_allocator.allocate();
 	}
 
+	bool allocate_pids(std::span<uint16_t> pids) {
+		return _pid_allocator.allocate(pids);
+	}
+
 	void free_pid(uint16_t pid, bool was_throttled = false) {
+		if (!_session_suspended)
+			check_session_store(
+				_session_store.erase(session_entry_e::publish, pid)
+			);
 		_pid_allocator.free(pid);
 		if (was_throttled)
 			_async_sender.throttled_op_done();
@@ -263,12 +558,16 @@ public:
 		);
 	}
 
+	template <typename Allocator>
+	void send_batch(std::vector<write_req, Allocator> write_reqs) {
+		_async_sender.send_batch(std::move(write_reqs));
+	}
+
 	template <typename CompletionToken>
 	decltype(auto) async_assemble(duration wait_for, CompletionToken&& token) {
 		auto initiation = [this] (auto handler, duration wait_for) mutable {
 			assemble_op {
-				*this, std::move(handler),
-				_read_buff, _active_span
+				*this, std::move(handler), _read_buff
 			}.perform(wait_for, asio::transfer_at_least(0));
 		};
 
@@ -280,6 +579,11 @@ public:
 		);
 	}
 
+	// The next packet for read_message_op that is already buffered.
+	std::optional<assembled_packet> assemble_buffered() {
+		return packet_assembler { *this }.next();
+	}
+
 	template <typename CompletionToken>
 	decltype(auto) async_wait_reply(
 		control_code_e code, uint16_t packet_id, CompletionToken&& token
@@ -293,7 +597,10 @@ public:
 		auto& session_state = _stream_context.mqtt_context().session_state;
 		if (!session_state.session_present()) {
 			channel_store_error(client::error::session_expired);
-			_replies.clear_pending_pubrels();
+			for (auto packet_id : _replies.clear_pending_pubrels())
+				check_session_store(_session_store.erase(
+					session_entry_e::inbound_publish, packet_id
+				));
 			session_state.session_present(true);
 		}
 	}
@@ -306,7 +613,15 @@ public:
 		);
 	}
 
+	bool channel_store(decoders::publish_message_view message) {
+		return _view_channel.try_send(
+			error_code {}, std::move(std::get<0>(message))
+		);
+	}
+
 	bool channel_store_error(error_code ec) {
+		if (_zero_copy_receive)
+			return _view_channel.try_send(ec, message_view {});
 		return _rec_channel.try_send(ec, std::string {}, std::string {}, publish_props {});
 	}
 
@@ -318,6 +633,14 @@ public:
 		);
 	}
 
+	template <typename CompletionToken>
+	decltype(auto) async_channel_receive_view(CompletionToken&& token) {
+		// sig = void (error_code, message_view)
+		return _view_channel.async_receive(
+			std::forward<CompletionToken>(token)
+		);
+	}
+
 };
 
 
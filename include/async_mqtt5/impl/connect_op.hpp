@@ -197,7 +197,7 @@ public:
 		const auto& wire_data = packet.wire_data();
 
 		detail::async_write(
-			_stream, asio::buffer(wire_data),
+			_stream, wire_data,
 			asio::consign(
 				asio::prepend(std::move(*this), on_send_connect{}),
 				std::move(packet)
@@ -348,7 +348,7 @@ public:
 		const auto& wire_data = packet.wire_data();
 
 		async_mqtt5::detail::async_write(
-			_stream, asio::buffer(wire_data),
+			_stream, wire_data,
 			asio::consign(
 				asio::prepend(std::move(*this), on_send_auth{}),
 				std::move(packet)
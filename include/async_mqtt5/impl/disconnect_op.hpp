@@ -58,11 +58,18 @@ public:
 	}
 
 	void perform() {
-		auto disconnect = control_packet<allocator_type>::of(
-			no_pid, get_allocator(),
-			encoders::encode_disconnect,
-			static_cast<uint8_t>(_context.reason_code), _context.props
-		);
+		auto reason_code = static_cast<uint8_t>(_context.reason_code);
+		auto has_props =
+			encoders::prop::props_may_omit_(_context.props).byte_size() != 0;
+
+		auto disconnect = has_props ?
+			control_packet<allocator_type>::of(
+				no_pid, get_allocator(),
+				encoders::encode_disconnect, reason_code, _context.props
+			) :
+			control_packet<allocator_type>::of(
+				fixed, get_allocator(), reason_code
+			);
 
 		send_disconnect(std::move(disconnect));
 	}
@@ -374,6 +374,8 @@ public:
 		uint32_t props_length;
 		if (!basic::varint_.parse(iter, last, ctx, rctx, props_length))
 			return false;
+		if (std::distance(iter, last) < props_length)
+			return false;
 
 		const It scoped_last = iter + props_length;
 		// attr = Props{};
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include <boost/endian/conversion.hpp>
 
@@ -23,6 +24,16 @@ inline void to_variable_bytes(std::string& s, int32_t val) {
 	s.push_back(val & 0b01111111);
 }
 
+inline uint8_t* to_variable_bytes(uint8_t* p, int32_t val) {
+	if (val > 0xfffffff) return p;
+	while (val > 127) {
+		*p++ = uint8_t((val & 0b01111111) | 0b10000000);
+		val >>= 7;
+	}
+	*p++ = uint8_t(val & 0b01111111);
+	return p;
+}
+
 inline size_t variable_length(int32_t val) {
 	if (val > 0xfffffff) return 0;
 	size_t rv = 1;
@@ -75,7 +86,7 @@ public:
 		return flag_def<bits, repr> { val };
 	}
 
-	uint16_t byte_size() const { return sizeof(repr); }
+	size_t byte_size() const { return sizeof(repr); }
 
 	template <size_t rhs_bits, typename rhs_repr>
 	auto operator|(const flag_def<rhs_bits, rhs_repr>& rhs) const {
@@ -91,6 +102,12 @@ public:
 		endian_store<repr, sizeof(repr), order::big>(p, _val);
 		return s;
 	}
+
+	uint8_t* encode(uint8_t* p) const {
+		using namespace boost::endian;
+		endian_store<repr, sizeof(repr), order::big>(p, _val);
+		return p + sizeof(repr);
+	}
 };
 
 template <size_t bits, typename repr = uint8_t>
@@ -103,13 +120,13 @@ class int_val : public encoder {
 public:
 	int_val(T val) : _val(val) {}
 
-	uint16_t byte_size() const { 
+	size_t byte_size() const {
 		if constexpr (is_optional<T>) {
-			if (_val) return uint16_t(val_length(*_val));
-			return uint16_t(0);
+			if (_val) return val_length(*_val);
+			return 0;
 		}
 		else
-			return uint16_t(val_length(_val));
+			return val_length(_val);
 	}
 
 	std::string& encode(std::string& s) const {
@@ -120,6 +137,15 @@ public:
 		else
 			return encode_val(s, _val);
 	}
+
+	uint8_t* encode(uint8_t* p) const {
+		if constexpr (is_optional<T>) {
+			if (_val) return encode_val(p, *_val);
+			return p;
+		}
+		else
+			return encode_val(p, _val);
+	}
 private:
 	template <typename U>
 	static size_t val_length(U&& val) {
@@ -143,6 +169,17 @@ private:
 			return s;
 		}
 	}
+
+	template <typename U>
+	static uint8_t* encode_val(uint8_t* p, U&& val) {
+		using namespace boost::endian;
+		if constexpr (std::is_same_v<Repr, intptr_t>)
+			return to_variable_bytes(p, int32_t(val));
+		else {
+			endian_store<Repr, sizeof(Repr), order::big>(p, val);
+			return p + sizeof(Repr);
+		}
+	}
 };
 
 template <typename Repr>
@@ -185,11 +222,11 @@ public:
 		static_assert(std::is_reference_v<T> || std::is_same_v<T, std::string_view>);
 	}
 
-	uint16_t byte_size() const { 
+	size_t byte_size() const {
 		if constexpr (is_optional<T>)
-			return uint16_t(_val ? _with_length * 2 + val_length(*_val) : 0); 
+			return _val ? _with_length * 2 + val_length(*_val) : 0;
 		else
-		 	return uint16_t(_with_length * 2 + val_length(_val));
+			return _with_length * 2 + val_length(_val);
 	}
 
 	std::string& encode(std::string& s) const {
@@ -201,6 +238,15 @@ public:
 			return encode_val(s, _val);
 	}
 
+	uint8_t* encode(uint8_t* p) const {
+		if constexpr (is_optional<T>) {
+			if (_val) return encode_val(p, *_val);
+			return p;
+		}
+		else
+			return encode_val(p, _val);
+	}
+
 private:
 	template <typename U>
 	static size_t val_length(U&& val) {
@@ -215,16 +261,33 @@ private:
 	template <typename U>
 	std::string& encode_val(std::string& s, U&& u) const {
 		using namespace boost::endian;
-		int16_t byte_len = int16_t(val_length(std::forward<U>(u)));
+		size_t byte_len = val_length(std::forward<U>(u));
 		if (byte_len == 0 && !_with_length) return s;
 		if (_with_length) {
 			size_t sz = s.size(); s.resize(sz + 2);
 			auto p = reinterpret_cast<uint8_t*>(s.data() + sz);
-			endian_store<int16_t, sizeof(int16_t), order::big>(p, byte_len);
+			endian_store<uint16_t, sizeof(uint16_t), order::big>(
+				p, uint16_t(byte_len)
+			);
 		}
 		s.append(std::begin(u), std::begin(u) + byte_len);
 		return s;
 	}
+
+	template <typename U>
+	uint8_t* encode_val(uint8_t* p, U&& u) const {
+		using namespace boost::endian;
+		size_t byte_len = val_length(std::forward<U>(u));
+		if (_with_length) {
+			endian_store<uint16_t, sizeof(uint16_t), order::big>(
+				p, uint16_t(byte_len)
+			);
+			p += 2;
+		}
+		if (byte_len)
+			std::memcpy(p, &*std::begin(u), byte_len);
+		return p + byte_len;
+	}
 };
 
 template <bool with_length = true>
@@ -266,14 +329,18 @@ public:
 	composed_val(T lhs, U rhs) : 
 		_lhs(std::forward<T>(lhs)), _rhs(std::forward<U>(rhs)) {}
 
-	uint16_t byte_size() const { 
-		return uint16_t(_lhs.byte_size() + _rhs.byte_size()); 
+	size_t byte_size() const {
+		return _lhs.byte_size() + _rhs.byte_size();
 	}
 
 	std::string& encode(std::string& s) const {
 		_lhs.encode(s);
 		return _rhs.encode(s);
 	}
+
+	uint8_t* encode(uint8_t* p) const {
+		return _rhs.encode(_lhs.encode(p));
+	}
 };
 
 template <class T, class U>
@@ -378,6 +445,14 @@ public:
 		auto sval = encoder_for_prop<p>(_val);
 		return sval.encode(s); 
 	}
+
+	uint8_t* encode(uint8_t* out) const {
+		if (!_val)
+			return out;
+		*out++ = p();
+		auto sval = encoder_for_prop<p>(_val);
+		return sval.encode(out);
+	}
 };
 
 template <typename T, std::integral_constant p>
@@ -410,11 +485,24 @@ public:
 
 		for (const auto& pr: _val) {
 			auto sval = encoder_for_prop<p>(pr);
+			if (!sval.byte_size())
+				continue;
 			s.push_back(p());
 			sval.encode(s); 
 		}
 		return s;
 	}
+
+	uint8_t* encode(uint8_t* out) const {
+		for (const auto& pr: _val) {
+			auto sval = encoder_for_prop<p>(pr);
+			if (!sval.byte_size())
+				continue;
+			*out++ = p();
+			out = sval.encode(out);
+		}
+		return out;
+	}
 };
 
 
@@ -460,6 +548,14 @@ public:
 		apply_each([&s](const auto& pv) { return pv.encode(s); });
 		return s;
 	}
+
+	uint8_t* encode(uint8_t* p) const {
+		size_t psize = props_size();
+		if (_may_omit && psize == 0) return p;
+		p = basic::varlen_(psize).encode(p);
+		apply_each([&p](const auto& pv) { return p = pv.encode(p); });
+		return p;
+	}
 private:
 	size_t props_size() const {
 		size_t retval = 0;
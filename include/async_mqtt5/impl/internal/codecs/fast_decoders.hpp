@@ -0,0 +1,231 @@
+#ifndef ASYNC_MQTT5_FAST_DECODERS_HPP
+#define ASYNC_MQTT5_FAST_DECODERS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <async_mqtt5/message_view.hpp>
+
+#include <async_mqtt5/detail/internal_types.hpp>
+
+#include <async_mqtt5/impl/internal/codecs/base_decoders.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
+
+/*
+
+Hand-written decoders of the packets the Client receives most often,
+producing the same results as the Spirit X3 decoders in
+message_decoders.hpp, which remain the reference implementation.
+Properties are decoded with the X3 property parser unless their
+Property Length is zero, which is the common case.
+
+*/
+
+namespace async_mqtt5::decoders::fast {
+
+using byte_citer = detail::byte_citer;
+
+inline uint16_t big_word(byte_citer it) {
+	return uint16_t(uint8_t(it[0]) << 8 | uint8_t(it[1]));
+}
+
+inline std::optional<uint32_t> decode_varint(
+	byte_citer& it, const byte_citer last
+) {
+	auto iter = it;
+	uint32_t result = 0;
+	for (unsigned bit_shift = 0; bit_shift < 28; bit_shift += 7) {
+		if (iter == last)
+			return std::nullopt;
+		auto val = uint8_t(*iter++);
+		result |= uint32_t(val & 0b0111'1111u) << bit_shift;
+		if (!(val & 0b1000'0000u)) {
+			it = iter;
+			return result;
+		}
+	}
+	return std::nullopt;
+}
+
+inline std::optional<fixed_header> decode_fixed_header(
+	byte_citer& it, const byte_citer last
+) {
+	if (it == last)
+		return std::nullopt;
+	auto iter = it + 1;
+	auto remain_length = decode_varint(iter, last);
+	if (!remain_length)
+		return std::nullopt;
+	auto control_byte = uint8_t(*it);
+	it = iter;
+	return fixed_header { control_byte, *remain_length };
+}
+
+// The caller makes sure that two bytes are available.
+inline packet_id decode_packet_id(byte_citer& it) {
+	auto rv = big_word(it);
+	it += 2;
+	return rv;
+}
+
+// Properties missing altogether are decoded as empty, like the X3 parser.
+template <typename Props>
+bool decode_props(byte_citer& it, const byte_citer last, Props& props) {
+	if (it == last)
+		return true;
+	if (*it == 0) {
+		++it;
+		return true;
+	}
+	auto rv = type_parse(it, last, prop::props_<Props>);
+	if (!rv)
+		return false;
+	props = std::move(*rv);
+	return true;
+}
+
+inline std::optional<publish_message> decode_publish(
+	uint8_t control_byte, uint32_t remain_length, byte_citer& it
+) {
+	uint8_t flags = control_byte & 0b1111;
+	auto qos = qos_e((flags >> 1) & 0b11);
+	auto iter = it;
+	const byte_citer last = it + remain_length;
+
+	if (remain_length < 2)
+		return std::nullopt;
+	size_t topic_size = big_word(iter);
+	iter += 2;
+	if (size_t(std::distance(iter, last)) < topic_size)
+		return std::nullopt;
+
+	publish_message msg;
+	auto& [topic, packet_id, msg_flags, props, payload] = msg;
+	topic.assign(iter, iter + topic_size);
+	iter += topic_size;
+
+	if (qos != qos_e::at_most_once) {
+		if (std::distance(iter, last) < 2)
+			return std::nullopt;
+		packet_id = decode_packet_id(iter);
+	}
+	msg_flags = flags;
+
+	if (!decode_props(iter, last, props))
+		return std::nullopt;
+
+	payload.assign(iter, last);
+	it = last;
+	return msg;
+}
+
+// Decodes a PUBLISH packet read into block without copying
+// its Topic Name and Payload.
+inline std::optional<publish_message_view> decode_publish_view(
+	uint8_t control_byte, uint32_t remain_length, byte_citer& it,
+	std::shared_ptr<const std::string> block
+) {
+	uint8_t flags = control_byte & 0b1111;
+	auto qos = qos_e((flags >> 1) & 0b11);
+	auto iter = it;
+	const byte_citer last = it + remain_length;
+
+	if (remain_length < 2)
+		return std::nullopt;
+	size_t topic_size = big_word(iter);
+	iter += 2;
+	if (size_t(std::distance(iter, last)) < topic_size)
+		return std::nullopt;
+	auto topic = std::string_view(&*it + 2, topic_size);
+	iter += topic_size;
+
+	std::optional<uint16_t> packet_id;
+	if (qos != qos_e::at_most_once) {
+		if (std::distance(iter, last) < 2)
+			return std::nullopt;
+		packet_id = decode_packet_id(iter);
+	}
+
+	publish_props props;
+	if (!decode_props(iter, last, props))
+		return std::nullopt;
+
+	auto payload = std::string_view(
+		iter == last ? nullptr : &*iter, std::distance(iter, last)
+	);
+	it = last;
+
+	return publish_message_view {
+		message_view(std::move(block), topic, payload, std::move(props)),
+		packet_id, flags
+	};
+}
+
+// PUBACK, PUBREC, PUBREL and PUBCOMP share the layout
+// of their variable header.
+template <typename Message>
+std::optional<Message> decode_pub_reply(
+	uint32_t remain_length, byte_citer& it
+) {
+	if (remain_length == 0)
+		return Message {};
+
+	const byte_citer last = it + remain_length;
+	auto iter = it;
+	Message msg;
+	auto& [reason_code, props] = msg;
+	reason_code = uint8_t(*iter++);
+	if (!decode_props(iter, last, props))
+		return std::nullopt;
+
+	it = iter;
+	return msg;
+}
+
+inline std::optional<puback_message> decode_puback(
+	uint32_t remain_length, byte_citer& it
+) {
+	return decode_pub_reply<puback_message>(remain_length, it);
+}
+
+inline std::optional<pubrec_message> decode_pubrec(
+	uint32_t remain_length, byte_citer& it
+) {
+	return decode_pub_reply<pubrec_message>(remain_length, it);
+}
+
+inline std::optional<pubrel_message> decode_pubrel(
+	uint32_t remain_length, byte_citer& it
+) {
+	return decode_pub_reply<pubrel_message>(remain_length, it);
+}
+
+inline std::optional<pubcomp_message> decode_pubcomp(
+	uint32_t remain_length, byte_citer& it
+) {
+	return decode_pub_reply<pubcomp_message>(remain_length, it);
+}
+
+inline std::optional<suback_message> decode_suback(
+	uint32_t remain_length, byte_citer& it
+) {
+	const byte_citer last = it + remain_length;
+	auto iter = it;
+	suback_message msg;
+	auto& [props, reason_codes] = msg;
+	if (!decode_props(iter, last, props) || iter == last)
+		return std::nullopt;
+
+	reason_codes.assign(iter, last);
+	it = last;
+	return msg;
+}
+
+} // end namespace async_mqtt5::decoders::fast
+
+#endif // !ASYNC_MQTT5_FAST_DECODERS_HPP
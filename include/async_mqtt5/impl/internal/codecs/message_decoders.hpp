@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <string>
 
+#include <async_mqtt5/message_view.hpp>
+
 #include <async_mqtt5/detail/internal_types.hpp>
 
 #include <async_mqtt5/impl/internal/codecs/base_decoders.hpp>
@@ -140,6 +142,12 @@ inline std::optional<publish_message> decode_publish(
 	return type_parse(it, it + remain_length, publish_);
 }
 
+using publish_message_view = std::tuple<
+	message_view, // topic, payload and publish props
+	std::optional<uint16_t>, // packet_id
+	uint8_t // dup_e, qos_e, retain_e
+>;
+
 using puback_message = std::tuple<
 	uint8_t, // puback reason code
 	puback_props // props
@@ -1,8 +1,11 @@
 #ifndef ASYNC_MQTT5_MESSAGE_ENCODERS_HPP
 #define ASYNC_MQTT5_MESSAGE_ENCODERS_HPP
 
-#include <string>
+#include <cassert>
+#include <cstring>
 #include <optional>
+#include <span>
+#include <string>
 
 #include <async_mqtt5/types.hpp>
 
@@ -11,411 +14,592 @@
 
 namespace async_mqtt5::encoders {
 
-template <typename encoder>
-std::string encode(const encoder& e) {
-	std::string s;
-	s.reserve(e.byte_size());
-	s << e;
-	return s;
-}
+template <typename Allocator>
+using string_for = std::basic_string<
+	char, std::char_traits<char>,
+	typename std::allocator_traits<Allocator>::template rebind_alloc<char>
+>;
 
-inline std::string encode_connect(
-	std::string_view client_id,
-	std::optional<std::string_view> user_name,
-	std::optional<std::string_view> password,
-	uint16_t keep_alive, bool clean_start,
-	const connect_props& props,
-	const std::optional<will>& w
-) {
-
-	auto packet_type_ =
-		basic::flag<4>(0b0001) |
-		basic::flag<4>(0);
-
-	auto conn_flags_ =
-		basic::flag<1>(user_name) |
-		basic::flag<1>(password) |
-		basic::flag<1>(w, &will::retain) |
-		basic::flag<2>(w, &will::qos) |
-		basic::flag<1>(w) |
-		basic::flag<1>(clean_start) |
-		basic::flag<1>(0);
-
-	auto var_header_ =
-		basic::utf8_("MQTT") &
-		basic::byte_(uint8_t(5)) &
-		conn_flags_ &
-		basic::int16_(keep_alive) &
-		prop::props_(props);
-
-	auto payload_ =
-		basic::utf8_(client_id) &
-		prop::props_(w) &
-		basic::utf8_(w, &will::topic) &
-	 	basic::binary_(w, &will::message) &
-		basic::utf8_(user_name) &
-		basic::utf8_(password);
-
-	auto message_body_ = var_header_ & payload_;
-
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(message_body_.byte_size());
-
-	auto connect_message_ = fixed_header_ & message_body_;
-
-	return encode(connect_message_);
+template <typename String>
+uint8_t* buffer_of(String& s) {
+	return reinterpret_cast<uint8_t*>(s.data());
 }
 
-inline std::string encode_connack(
-	bool session_present,
-	uint8_t reason_code,
-	const connack_props& props
-) {
-
-	auto packet_type_ =
-		basic::flag<4>(0b0010) |
-		basic::flag<4>(0);
-
-	auto var_header_ =
-		basic::flag<1>(session_present) &
-		basic::byte_(reason_code) &
-		prop::props_(props);
-
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size());
-
-	auto connack_message_ = fixed_header_ & var_header_;
-
-	return encode(connack_message_);
+// The message is sized once and every field is stored directly
+// into the buffer, allocated with the given allocator.
+template <typename encoder, typename Allocator = std::allocator<char>>
+string_for<Allocator> encode(const encoder& e, const Allocator& alloc = {}) {
+	string_for<Allocator> s(e.byte_size(), '\0', alloc);
+	[[maybe_unused]] auto end = e.encode(buffer_of(s));
+	assert(end == buffer_of(s) + s.size());
+	return s;
 }
 
-inline std::string encode_publish(
-	uint16_t packet_id,
-	std::string_view topic_name,
-	std::string_view payload,
-	qos_e qos, retain_e retain, dup_e dup,
-	const publish_props& props
-) {
+// Encodes the message into a user-provided buffer.
+// Returns the number of bytes written, or 0 if the buffer is too small.
+template <typename encoder>
+size_t encode_into(const encoder& e, std::span<uint8_t> buffer) {
+	auto size = e.byte_size();
+	if (size > buffer.size())
+		return 0;
+	e.encode(buffer.data());
+	return size;
+}
 
-	std::optional<uint16_t> used_packet_id;
-	if (qos != qos_e::at_most_once) used_packet_id.emplace(packet_id);
+// Appends the message to the string one field at a time.
+template <typename encoder>
+std::string encode_appending(const encoder& e) {
+	std::string s;
+	s.reserve(e.byte_size());
+	s << e;
+	return s;
+}
 
-	auto packet_type_ =
-		basic::flag<4>(0b0011) |
-		basic::flag<1>(dup) |
-		basic::flag<2>(qos) |
-		basic::flag<1>(retain);
+// The message encoders are function objects so that they can be passed
+// to control_packet::of, which appends the allocator of the packet.
+constexpr struct encode_connect_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		std::string_view client_id,
+		std::optional<std::string_view> user_name,
+		std::optional<std::string_view> password,
+		uint16_t keep_alive, bool clean_start,
+		const connect_props& props,
+		const std::optional<will>& w,
+		const Allocator& alloc = {}
+	) const {
+
+		auto packet_type_ =
+			basic::flag<4>(0b0001) |
+			basic::flag<4>(0);
+
+		auto conn_flags_ =
+			basic::flag<1>(user_name) |
+			basic::flag<1>(password) |
+			basic::flag<1>(w, &will::retain) |
+			basic::flag<2>(w, &will::qos) |
+			basic::flag<1>(w) |
+			basic::flag<1>(clean_start) |
+			basic::flag<1>(0);
+
+		auto var_header_ =
+			basic::utf8_("MQTT") &
+			basic::byte_(uint8_t(5)) &
+			conn_flags_ &
+			basic::int16_(keep_alive) &
+			prop::props_(props);
+
+		auto payload_ =
+			basic::utf8_(client_id) &
+			prop::props_(w) &
+			basic::utf8_(w, &will::topic) &
+		 	basic::binary_(w, &will::message) &
+			basic::utf8_(user_name) &
+			basic::utf8_(password);
+
+		auto message_body_ = var_header_ & payload_;
+
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(message_body_.byte_size());
+
+		auto connect_message_ = fixed_header_ & message_body_;
+
+		return encode(connect_message_, alloc);
+	}
+} encode_connect {};
 
-	auto var_header_ =
-		basic::utf8_(topic_name) &
-		basic::int16_(used_packet_id) &
-		prop::props_(props);
+constexpr struct encode_connack_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		bool session_present,
+		uint8_t reason_code,
+		const connack_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto message_body_ = var_header_ & basic::verbatim_(payload);
+		auto packet_type_ =
+			basic::flag<4>(0b0010) |
+			basic::flag<4>(0);
 
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(message_body_.byte_size());
+		auto var_header_ =
+			basic::flag<1>(session_present) &
+			basic::byte_(reason_code) &
+			prop::props_(props);
 
-	auto publish_message_ = fixed_header_ & message_body_;
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size());
 
-	return encode(publish_message_);
-}
+		auto connack_message_ = fixed_header_ & var_header_;
 
-inline std::string encode_puback(
-	uint16_t packet_id,
-	uint8_t reason_code,
-	const puback_props& props
-) {
+		return encode(connack_message_, alloc);
+	}
+} encode_connack {};
+
+constexpr struct encode_publish_header_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		size_t payload_size,
+		std::string_view topic_name,
+		qos_e qos, retain_e retain, dup_e dup,
+		const publish_props& props,
+		const Allocator& alloc = {}
+	) const {
+
+		std::optional<uint16_t> used_packet_id;
+		if (qos != qos_e::at_most_once) used_packet_id.emplace(packet_id);
+
+		auto packet_type_ =
+			basic::flag<4>(0b0011) |
+			basic::flag<1>(dup) |
+			basic::flag<2>(qos) |
+			basic::flag<1>(retain);
+
+		auto var_header_ =
+			basic::utf8_(topic_name) &
+			basic::int16_(used_packet_id) &
+			prop::props_(props);
+
+		// the payload is not part of the encoded header, it is written
+		// to the stream as a separate buffer
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(size_t(var_header_.byte_size()) + payload_size);
+
+		auto publish_header_ = fixed_header_ & var_header_;
+
+		return encode(publish_header_, alloc);
+	}
+} encode_publish_header {};
+
+// Encodes the Variable Header of a PUBLISH packet whose Packet Identifier
+// (if any) is left zeroed, to be patched in for every publish.
+constexpr struct encode_publish_var_header_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		std::string_view topic_name, qos_e qos,
+		const publish_props& props,
+		const Allocator& alloc = {}
+	) const {
+
+		std::optional<uint16_t> used_packet_id;
+		if (qos != qos_e::at_most_once) used_packet_id.emplace(0);
+
+		auto var_header_ =
+			basic::utf8_(topic_name) &
+			basic::int16_(used_packet_id) &
+			prop::props_(props);
+
+		return encode(var_header_, alloc);
+	}
+} encode_publish_var_header {};
+
+constexpr struct encode_prepared_publish_header_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		size_t payload_size,
+		std::string_view var_header, size_t packet_id_offset,
+		qos_e qos, retain_e retain, dup_e dup,
+		const Allocator& alloc = {}
+	) const {
+
+		auto packet_type_ =
+			basic::flag<4>(0b0011) |
+			basic::flag<1>(dup) |
+			basic::flag<2>(qos) |
+			basic::flag<1>(retain);
+
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header.size() + payload_size);
+
+		string_for<Allocator> s(
+			fixed_header_.byte_size() + var_header.size(), '\0', alloc
+		);
+		auto var_header_begin = fixed_header_.encode(buffer_of(s));
+		std::memcpy(var_header_begin, var_header.data(), var_header.size());
+
+		if (qos != qos_e::at_most_once)
+			boost::endian::endian_store<uint16_t, 2, boost::endian::order::big>(
+				var_header_begin + packet_id_offset, packet_id
+			);
+
+		return s;
+	}
+} encode_prepared_publish_header {};
+
+// Copies a header encoded earlier, such as one restored from a session store.
+constexpr struct encode_stored_header_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t /*packet_id*/, size_t /*payload_size*/,
+		std::string_view header,
+		const Allocator& alloc = {}
+	) const {
+		return string_for<Allocator>(header, alloc);
+	}
+} encode_stored_header {};
+
+constexpr struct encode_publish_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		std::string_view topic_name,
+		std::string_view payload,
+		qos_e qos, retain_e retain, dup_e dup,
+		const publish_props& props,
+		const Allocator& alloc = {}
+	) const {
+		auto s = encode_publish_header(
+			packet_id, payload.size(), topic_name, qos, retain, dup, props,
+			alloc
+		);
+		s.append(payload);
+		return s;
+	}
+} encode_publish {};
 
-	auto packet_type_ =
-		basic::flag<4>(0b0100) |
-		basic::flag<4>(0);
+constexpr struct encode_puback_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		uint8_t reason_code,
+		const puback_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		basic::byte_(reason_code) &
-		prop::props_may_omit_(props);
+		auto packet_type_ =
+			basic::flag<4>(0b0100) |
+			basic::flag<4>(0);
 
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size());
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			basic::byte_(reason_code) &
+			prop::props_may_omit_(props);
 
-	auto puback_message_ = fixed_header_ & var_header_;
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size());
 
-	return encode(puback_message_);
-}
+		auto puback_message_ = fixed_header_ & var_header_;
 
-inline std::string encode_pubrec(
-	uint16_t packet_id,
-	uint8_t reason_code,
-	const pubrec_props& props
-) {
+		return encode(puback_message_, alloc);
+	}
+} encode_puback {};
 
-	auto packet_type_ =
-		basic::flag<4>(0b0101) |
-		basic::flag<4>(0b0000);
+constexpr struct encode_pubrec_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		uint8_t reason_code,
+		const pubrec_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		basic::byte_(reason_code) &
-		prop::props_may_omit_(props);
+		auto packet_type_ =
+			basic::flag<4>(0b0101) |
+			basic::flag<4>(0b0000);
 
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size());
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			basic::byte_(reason_code) &
+			prop::props_may_omit_(props);
 
-	auto pubrec_message_ = fixed_header_ & var_header_;
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size());
 
-	return encode(pubrec_message_);
-}
+		auto pubrec_message_ = fixed_header_ & var_header_;
 
-inline std::string encode_pubrel(
-	uint16_t packet_id,
-	uint8_t reason_code,
-	const pubrel_props& props
-) {
+		return encode(pubrec_message_, alloc);
+	}
+} encode_pubrec {};
 
-	auto packet_type_ =
-		basic::flag<4>(0b0110) |
-		basic::flag<4>(0b0010);
+constexpr struct encode_pubrel_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		uint8_t reason_code,
+		const pubrel_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		basic::byte_(reason_code) &
-		prop::props_may_omit_(props);
+		auto packet_type_ =
+			basic::flag<4>(0b0110) |
+			basic::flag<4>(0b0010);
 
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size());
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			basic::byte_(reason_code) &
+			prop::props_may_omit_(props);
 
-	auto pubrel_message_ = fixed_header_ & var_header_;
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size());
 
-	return encode(pubrel_message_);
-}
+		auto pubrel_message_ = fixed_header_ & var_header_;
 
-inline std::string encode_pubcomp(
-	uint16_t packet_id,
-	uint8_t reason_code,
-	const pubcomp_props& props
-) {
+		return encode(pubrel_message_, alloc);
+	}
+} encode_pubrel {};
 
-	auto packet_type_ =
-		basic::flag<4>(0b0111) |
-		basic::flag<4>(0b0000);
+constexpr struct encode_pubcomp_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		uint8_t reason_code,
+		const pubcomp_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		basic::byte_(reason_code) &
-		prop::props_may_omit_(props);
+		auto packet_type_ =
+			basic::flag<4>(0b0111) |
+			basic::flag<4>(0b0000);
 
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size());
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			basic::byte_(reason_code) &
+			prop::props_may_omit_(props);
 
-	auto pubcomp_message_ = fixed_header_ & var_header_;
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size());
 
-	return encode(pubcomp_message_);
-}
+		auto pubcomp_message_ = fixed_header_ & var_header_;
 
-inline std::string encode_subscribe(
-	uint16_t packet_id,
-	const std::vector<subscribe_topic>& topics,
-	const subscribe_props& props
-) {
-
-	auto packet_type_ =
-		basic::flag<4>(0b1000) |
-		basic::flag<4>(0b0010);
-
-	size_t payload_size = 0;
-	for (const auto& [topic_filter, _]: topics)
-		payload_size += basic::utf8_(topic_filter).byte_size() + 1;
-
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		prop::props_(props);
-
-	auto message_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size()  + payload_size) &
-		var_header_;
-
-	auto s = encode(message_);
-	s.reserve(s.size() + payload_size);
-
-	for (const auto& [topic_filter, sub_opts]: topics) {
-		auto opts_ =
-			basic::flag<2>(sub_opts.retain_handling) |
-			basic::flag<1>(sub_opts.retain_as_published) |
-			basic::flag<1>(sub_opts.no_local) |
-			basic::flag<2>(sub_opts.max_qos);
-		auto filter_ = basic::utf8_(topic_filter) & opts_;
-		s << filter_;
+		return encode(pubcomp_message_, alloc);
 	}
+} encode_pubcomp {};
+
+constexpr struct encode_subscribe_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		const std::vector<subscribe_topic>& topics,
+		const subscribe_props& props,
+		const Allocator& alloc = {}
+	) const {
+
+		auto packet_type_ =
+			basic::flag<4>(0b1000) |
+			basic::flag<4>(0b0010);
+
+		size_t payload_size = 0;
+		for (const auto& [topic_filter, _]: topics)
+			payload_size += basic::utf8_(topic_filter).byte_size() + 1;
+
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			prop::props_(props);
+
+		auto message_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size()  + payload_size) &
+			var_header_;
+
+		string_for<Allocator> s(message_.byte_size() + payload_size, '\0', alloc);
+		auto p = message_.encode(buffer_of(s));
+
+		for (const auto& [topic_filter, sub_opts]: topics) {
+			auto opts_ =
+				basic::flag<2>(sub_opts.retain_handling) |
+				basic::flag<1>(sub_opts.retain_as_published) |
+				basic::flag<1>(sub_opts.no_local) |
+				basic::flag<2>(sub_opts.max_qos);
+			auto filter_ = basic::utf8_(topic_filter) & opts_;
+			p = filter_.encode(p);
+		}
+
+		return s;
+	}
+} encode_subscribe {};
 
-	return s;
-}
-
-inline std::string encode_suback(
-	uint16_t packet_id,
-	std::vector<uint8_t>& reason_codes,
-	const suback_props& props
-) {
+constexpr struct encode_suback_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		std::vector<uint8_t>& reason_codes,
+		const suback_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto packet_type_ =
-		basic::flag<4>(0b1001) |
-		basic::flag<4>(0b0000);
+		auto packet_type_ =
+			basic::flag<4>(0b1001) |
+			basic::flag<4>(0b0000);
 
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		prop::props_(props);
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			prop::props_(props);
 
-	auto message_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size()  + reason_codes.size()) &
-		var_header_;
+		auto message_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size()  + reason_codes.size()) &
+			var_header_;
 
-	auto s = encode(message_);
-	s.reserve(s.size() + reason_codes.size());
+		string_for<Allocator> s(message_.byte_size() + reason_codes.size(), '\0', alloc);
+		auto p = message_.encode(buffer_of(s));
 
-	for (auto reason_code: reason_codes)
-		s << basic::byte_(reason_code);
+		for (auto reason_code: reason_codes)
+			p = basic::byte_(reason_code).encode(p);
 
-	return s;
-}
+		return s;
+	}
+} encode_suback {};
 
-inline std::string encode_unsubscribe(
-	uint16_t packet_id,
-	const std::vector<std::string>& topics,
-	const unsubscribe_props& props
-) {
+constexpr struct encode_unsubscribe_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		const std::vector<std::string>& topics,
+		const unsubscribe_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto packet_type_ =
-		basic::flag<4>(0b1010) |
-		basic::flag<4>(0b0010);
+		auto packet_type_ =
+			basic::flag<4>(0b1010) |
+			basic::flag<4>(0b0010);
 
-	size_t payload_size = 0;
-	for (const auto& topic: topics)
-		payload_size += basic::utf8_(topic).byte_size();
+		size_t payload_size = 0;
+		for (const auto& topic: topics)
+			payload_size += basic::utf8_(topic).byte_size();
 
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		prop::props_(props);
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			prop::props_(props);
 
-	auto message_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size()  + payload_size) &
-		var_header_;
+		auto message_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size()  + payload_size) &
+			var_header_;
 
-	auto s = encode(message_);
-	s.reserve(s.size() + payload_size);
+		string_for<Allocator> s(message_.byte_size() + payload_size, '\0', alloc);
+		auto p = message_.encode(buffer_of(s));
 
-	for (const auto& topic: topics)
-		s << basic::utf8_(topic);
+		for (const auto& topic: topics)
+			p = basic::utf8_(topic).encode(p);
 
-	return s;
-}
+		return s;
+	}
+} encode_unsubscribe {};
 
-inline std::string encode_unsuback(
-	uint16_t packet_id,
-	std::vector<uint8_t>& reason_codes,
-	const unsuback_props& props
-) {
+constexpr struct encode_unsuback_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint16_t packet_id,
+		std::vector<uint8_t>& reason_codes,
+		const unsuback_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto packet_type_ =
-		basic::flag<4>(0b1011) |
-		basic::flag<4>(0b0000);
+		auto packet_type_ =
+			basic::flag<4>(0b1011) |
+			basic::flag<4>(0b0000);
 
-	auto var_header_ =
-		basic::int16_(packet_id) &
-		prop::props_(props);
+		auto var_header_ =
+			basic::int16_(packet_id) &
+			prop::props_(props);
 
-	auto message_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size()  + reason_codes.size()) &
-		var_header_;
+		auto message_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size()  + reason_codes.size()) &
+			var_header_;
 
-	auto s = encode(message_);
-	s.reserve(s.size() + reason_codes.size());
+		string_for<Allocator> s(message_.byte_size() + reason_codes.size(), '\0', alloc);
+		auto p = message_.encode(buffer_of(s));
 
-	for (auto reason_code: reason_codes)
-		s << basic::byte_(reason_code);
+		for (auto reason_code: reason_codes)
+			p = basic::byte_(reason_code).encode(p);
 
-	return s;
-}
+		return s;
+	}
+} encode_unsuback {};
 
-inline std::string encode_pingreq() {
-	auto packet_type_ =
-		basic::flag<4>(0b1100) |
-		basic::flag<4>(0);
+constexpr struct encode_pingreq_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(const Allocator& alloc = {}) const {
+		auto packet_type_ =
+			basic::flag<4>(0b1100) |
+			basic::flag<4>(0);
 
-	auto remaining_len_ =
-		basic::byte_(0);
+		auto remaining_len_ =
+			basic::byte_(0);
 
-	auto ping_req_ = packet_type_ & remaining_len_;
+		auto ping_req_ = packet_type_ & remaining_len_;
 
-	return encode(ping_req_);
-}
+		return encode(ping_req_, alloc);
+	}
+} encode_pingreq {};
 
-inline std::string encode_pingresp() {
-	auto packet_type_ =
-		basic::flag<4>(0b1101) |
-		basic::flag<4>(0);
+constexpr struct encode_pingresp_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(const Allocator& alloc = {}) const {
+		auto packet_type_ =
+			basic::flag<4>(0b1101) |
+			basic::flag<4>(0);
 
-	auto remaining_len_ =
-		basic::byte_(0);
+		auto remaining_len_ =
+			basic::byte_(0);
 
-	auto ping_resp_ = packet_type_ & remaining_len_;
+		auto ping_resp_ = packet_type_ & remaining_len_;
 
-	return encode(ping_resp_);
-}
+		return encode(ping_resp_, alloc);
+	}
+} encode_pingresp {};
 
-inline std::string encode_disconnect(
-	uint8_t reason_code,
-	const disconnect_props& props
-) {
+constexpr struct encode_disconnect_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint8_t reason_code,
+		const disconnect_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto packet_type_ =
-		basic::flag<4>(0b1110) |
-		basic::flag<4>(0b0000);
+		auto packet_type_ =
+			basic::flag<4>(0b1110) |
+			basic::flag<4>(0b0000);
 
-	auto var_header_ =
-		basic::byte_(reason_code) &
-		prop::props_(props);
+		auto var_header_ =
+			basic::byte_(reason_code) &
+			prop::props_(props);
 
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size());
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size());
 
-	auto disconnect_message_ = fixed_header_ & var_header_;
+		auto disconnect_message_ = fixed_header_ & var_header_;
 
-	return encode(disconnect_message_);
-}
+		return encode(disconnect_message_, alloc);
+	}
+} encode_disconnect {};
 
-inline std::string encode_auth(
-	uint8_t reason_code,
-	const auth_props& props
-) {
+constexpr struct encode_auth_ {
+	template <typename Allocator = std::allocator<char>>
+	string_for<Allocator> operator()(
+		uint8_t reason_code,
+		const auth_props& props,
+		const Allocator& alloc = {}
+	) const {
 
-	auto packet_type_ =
-		basic::flag<4>(0b1111) |
-		basic::flag<4>(0b0000);
+		auto packet_type_ =
+			basic::flag<4>(0b1111) |
+			basic::flag<4>(0b0000);
 
-	auto var_header_ =
-		basic::byte_(reason_code) &
-		prop::props_(props);
+		auto var_header_ =
+			basic::byte_(reason_code) &
+			prop::props_(props);
 
-	auto fixed_header_ =
-		packet_type_ &
-		basic::varlen_(var_header_.byte_size());
+		auto fixed_header_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size());
 
-	auto auth_message_ = fixed_header_ & var_header_;
+		auto auth_message_ = fixed_header_ & var_header_;
 
-	return encode(auth_message_);
-}
+		return encode(auth_message_, alloc);
+	}
+} encode_auth {};
 
 
 } // end namespace async_mqtt5::encoders
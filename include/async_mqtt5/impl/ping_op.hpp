@@ -69,7 +69,7 @@ public:
 			return;
 
 		auto pingreq = control_packet<allocator_type>::of(
-			no_pid, get_allocator(), encoders::encode_pingreq
+			fixed, get_allocator(), fixed_packets::pingreq
 		);
 
 		const auto& wire_data = pingreq.wire_data();
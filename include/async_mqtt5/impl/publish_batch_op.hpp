@@ -0,0 +1,415 @@
+#ifndef ASYNC_MQTT5_PUBLISH_BATCH_OP_HPP
+#define ASYNC_MQTT5_PUBLISH_BATCH_OP_HPP
+
+#include <memory>
+#include <vector>
+
+#include <boost/asio/detached.hpp>
+#include <boost/asio/prepend.hpp>
+
+#include <async_mqtt5/error.hpp>
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/cancellable_handler.hpp>
+#include <async_mqtt5/detail/control_packet.hpp>
+#include <async_mqtt5/detail/internal_types.hpp>
+
+#include <async_mqtt5/impl/async_sender.hpp>
+#include <async_mqtt5/impl/disconnect_op.hpp>
+#include <async_mqtt5/impl/publish_send_op.hpp>
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+namespace async_mqtt5::detail {
+
+namespace asio = boost::asio;
+
+template <qos_e qos_type>
+using on_publish_batch_signature = std::conditional_t<
+	qos_type == qos_e::at_most_once,
+		void (error_code),
+		void (error_code, std::vector<reason_code>)
+>;
+
+template <qos_e qos_type>
+using batch_cancel_args = std::conditional_t<
+	qos_type == qos_e::at_most_once,
+		std::tuple<>,
+		std::tuple<std::vector<reason_code>>
+>;
+
+// Publishes a batch of messages with a single completion handler.
+// Every message in the batch is tracked by a copy of this op that
+// shares the batch state and knows the index of its message.
+template <typename ClientService, typename Handler, qos_e qos_type>
+class publish_batch_op {
+	using client_service = ClientService;
+
+	struct on_publish {};
+	struct on_puback {};
+	struct on_pubrec {};
+	struct on_pubrel {};
+	struct on_pubcomp {};
+
+public:
+	using executor_type = typename client_service::executor_type;
+	using allocator_type = asio::associated_allocator_t<Handler>;
+
+private:
+	struct batch_state {
+		std::shared_ptr<client_service> svc_ptr;
+		allocator_type alloc;
+		cancellable_handler<
+			Handler, executor_type, batch_cancel_args<qos_type>
+		> handler;
+		std::vector<reason_code> results;
+		size_t pending { 0 };
+		error_code ec;
+
+		batch_state(
+			const std::shared_ptr<client_service>& svc_ptr,
+			Handler&& handler
+		) :
+			svc_ptr(svc_ptr),
+			alloc(asio::get_associated_allocator(handler)),
+			handler(std::move(handler), svc_ptr->get_executor())
+		{}
+	};
+
+	std::shared_ptr<batch_state> _state;
+	size_t _index { 0 };
+	serial_num_t _serial_num { 0 };
+	traffic_class_e _traffic_class { traffic_class_e::telemetry };
+
+	// Only the first send of the packet is subject to the write limits.
+	bool _admitted { false };
+
+public:
+	publish_batch_op(
+		const std::shared_ptr<client_service>& svc_ptr, Handler&& handler
+	) {
+		auto alloc = asio::get_associated_allocator(handler);
+		_state = std::allocate_shared<batch_state>(
+			alloc, svc_ptr, std::move(handler)
+		);
+	}
+
+	publish_batch_op(publish_batch_op&&) noexcept = default;
+	publish_batch_op(const publish_batch_op&) = default;
+
+	executor_type get_executor() const noexcept {
+		return _state->svc_ptr->get_executor();
+	}
+
+	allocator_type get_allocator() const noexcept {
+		return _state->alloc;
+	}
+
+	void perform(std::vector<publish_message> messages) {
+		auto& svc = *_state->svc_ptr;
+
+		for (const auto& msg : messages) {
+			auto ec = validate_publish<qos_type>(
+				svc, msg.topic, msg.retain, msg.props
+			);
+			if (ec)
+				return complete_post(ec);
+		}
+
+		if (messages.empty())
+			return complete_post(error_code {});
+
+		std::vector<uint16_t> packet_ids(messages.size(), 0);
+		if constexpr (qos_type != qos_e::at_most_once)
+			if (!svc.allocate_pids(packet_ids))
+				return complete_post(client::error::pid_overrun);
+
+		_state->pending = messages.size();
+		if constexpr (qos_type != qos_e::at_most_once)
+			_state->results.assign(messages.size(), reason_codes::empty);
+
+		std::vector<write_req> write_reqs;
+		write_reqs.reserve(messages.size());
+
+		for (size_t i = 0; i < messages.size(); ++i) {
+			auto& msg = messages[i];
+
+			publish_batch_op op { *this };
+			op._index = i;
+			op._serial_num = svc.next_serial_num();
+			op._traffic_class = msg.traffic_class;
+
+			auto publish = control_packet<allocator_type>::of(
+				with_pid, get_allocator(),
+				encoders::encode_publish_header, packet_ids[i],
+				with_payload, std::move(msg.payload),
+				msg.topic, qos_type, msg.retain, dup_e::no, msg.props
+			);
+			if constexpr (qos_type != qos_e::at_most_once) {
+				svc.spill(publish);
+				svc.store_publish(publish);
+			}
+
+			const auto& wire_data = publish.wire_data();
+			auto serial_num = op._serial_num;
+			auto flags = op.publish_flags();
+			op._admitted = true;
+			write_reqs.emplace_back(
+				wire_data, serial_num, flags,
+				asio::prepend(std::move(op), on_publish {}, std::move(publish))
+			);
+		}
+
+		svc.send_batch(std::move(write_reqs));
+	}
+
+	void send_publish(control_packet<allocator_type> publish) {
+		if (_state->handler.empty()) { // already cancelled
+			if constexpr (qos_type != qos_e::at_most_once)
+				_state->svc_ptr->free_pid(publish.packet_id());
+			return element_done();
+		}
+
+		auto flags = publish_flags();
+		_admitted = true;
+
+		const auto& wire_data = publish.wire_data();
+		_state->svc_ptr->async_send(
+			wire_data,
+			_serial_num, flags,
+			asio::prepend(std::move(*this), on_publish {}, std::move(publish))
+		);
+	}
+
+	void operator()(
+		on_publish, control_packet<allocator_type> publish,
+		error_code ec
+	) {
+		if (ec == asio::error::try_again)
+			return send_publish(std::move(publish));
+
+		if constexpr (qos_type == qos_e::at_most_once)
+			return complete(ec);
+
+		else {
+			auto packet_id = publish.packet_id();
+
+			// the packet was never written and holds no Receive Maximum quota
+			if (ec == client::error::queue_full)
+				return complete(ec, reason_codes::empty, packet_id, false);
+
+			if (ec)
+				return complete(ec, reason_codes::empty, packet_id);
+
+			if constexpr (qos_type == qos_e::at_least_once)
+				_state->svc_ptr->async_wait_reply(
+					control_code_e::puback, packet_id,
+					asio::prepend(
+						std::move(*this), on_puback {}, std::move(publish)
+					)
+				);
+			else
+				_state->svc_ptr->async_wait_reply(
+					control_code_e::pubrec, packet_id,
+					asio::prepend(
+						std::move(*this), on_pubrec {}, std::move(publish)
+					)
+				);
+		}
+	}
+
+	void operator()(
+		on_puback, control_packet<allocator_type> publish,
+		error_code ec, byte_citer first, byte_citer last
+	)
+	requires (qos_type == qos_e::at_least_once) {
+
+		if (ec == asio::error::try_again) // "resend unanswered"
+			return send_publish(std::move(publish.set_dup()));
+
+		uint16_t packet_id = publish.packet_id();
+
+		if (ec)
+			return complete(ec, reason_codes::empty, packet_id);
+
+		auto puback = decoders::fast::decode_puback(std::distance(first, last), first);
+		if (!puback.has_value()) {
+			on_malformed_packet("Malformed PUBACK: cannot decode");
+			return send_publish(std::move(publish.set_dup()));
+		}
+
+		auto& [reason_code, props] = *puback;
+		auto rc = to_reason_code<reason_codes::category::puback>(reason_code);
+		if (!rc) {
+			on_malformed_packet("Malformed PUBACK: invalid Reason Code");
+			return send_publish(std::move(publish.set_dup()));
+		}
+
+		complete(ec, *rc, packet_id);
+	}
+
+	void operator()(
+		on_pubrec, control_packet<allocator_type> publish,
+		error_code ec, byte_citer first, byte_citer last
+	)
+	requires (qos_type == qos_e::exactly_once) {
+
+		if (ec == asio::error::try_again) // "resend unanswered"
+			return send_publish(std::move(publish.set_dup()));
+
+		uint16_t packet_id = publish.packet_id();
+
+		if (ec)
+			return complete(ec, reason_codes::empty, packet_id);
+
+		auto pubrec = decoders::fast::decode_pubrec(std::distance(first, last), first);
+		if (!pubrec.has_value()) {
+			on_malformed_packet("Malformed PUBREC: cannot decode");
+			return send_publish(std::move(publish.set_dup()));
+		}
+
+		auto& [reason_code, props] = *pubrec;
+
+		auto rc = to_reason_code<reason_codes::category::pubrec>(reason_code);
+		if (!rc) {
+			on_malformed_packet("Malformed PUBREC: invalid Reason Code");
+			return send_publish(std::move(publish.set_dup()));
+		}
+
+		if (*rc)
+			return complete(ec, *rc, packet_id);
+
+		_state->svc_ptr->store_pubrel(packet_id);
+
+		auto pubrel = control_packet<allocator_type>::of(
+			fixed, get_allocator(),
+			control_code_e::pubrel, packet_id
+		);
+
+		send_pubrel(std::move(pubrel), false);
+	}
+
+	void send_pubrel(control_packet<allocator_type> pubrel, bool throttled) {
+		const auto& wire_data = pubrel.wire_data();
+		_state->svc_ptr->async_send(
+			wire_data,
+			_serial_num,
+			(send_flag::throttled * throttled) | send_flag::prioritized,
+			asio::prepend(std::move(*this), on_pubrel {}, std::move(pubrel))
+		);
+	}
+
+	void operator()(
+		on_pubrel, control_packet<allocator_type> pubrel, error_code ec
+	)
+	requires (qos_type == qos_e::exactly_once) {
+
+		if (ec == asio::error::try_again)
+			return send_pubrel(std::move(pubrel), true);
+
+		uint16_t packet_id = pubrel.packet_id();
+
+		if (ec)
+			return complete(ec, reason_codes::empty, packet_id);
+
+		_state->svc_ptr->async_wait_reply(
+			control_code_e::pubcomp, packet_id,
+			asio::prepend(std::move(*this), on_pubcomp {}, std::move(pubrel))
+		);
+	}
+
+	void operator()(
+		on_pubcomp, control_packet<allocator_type> pubrel,
+		error_code ec,
+		byte_citer first, byte_citer last
+	)
+	requires (qos_type == qos_e::exactly_once) {
+
+		if (ec == asio::error::try_again) // "resend unanswered"
+			return send_pubrel(std::move(pubrel), true);
+
+		uint16_t packet_id = pubrel.packet_id();
+
+		if (ec)
+			return complete(ec, reason_codes::empty, packet_id);
+
+		auto pubcomp = decoders::fast::decode_pubcomp(std::distance(first, last), first);
+		if (!pubcomp.has_value()) {
+			on_malformed_packet("Malformed PUBCOMP: cannot decode");
+			return send_pubrel(std::move(pubrel), true);
+		}
+
+		auto& [reason_code, props] = *pubcomp;
+
+		auto rc = to_reason_code<reason_codes::category::pubcomp>(reason_code);
+		if (!rc) {
+			on_malformed_packet("Malformed PUBCOMP: invalid Reason Code");
+			return send_pubrel(std::move(pubrel), true);
+		}
+
+		return complete(ec, *rc, packet_id);
+	}
+
+private:
+	unsigned publish_flags() const {
+		return (send_flag::throttled * (qos_type != qos_e::at_most_once)) |
+			(send_flag::droppable * (qos_type == qos_e::at_most_once)) |
+			(send_flag::bounded * !_admitted) |
+			send_flag::traffic_class(_traffic_class);
+	}
+
+	void on_malformed_packet(const std::string& reason) {
+		auto props = disconnect_props {};
+		props[prop::reason_string] = reason;
+		async_disconnect(
+			disconnect_rc_e::malformed_packet, props, false, _state->svc_ptr,
+			asio::detached
+		);
+	}
+
+	void complete(error_code ec)
+	requires (qos_type == qos_e::at_most_once)
+	{
+		if (ec && !_state->ec)
+			_state->ec = ec;
+		element_done();
+	}
+
+	void complete(
+		error_code ec, reason_code rc, uint16_t packet_id,
+		bool was_throttled = true
+	)
+	requires (qos_type != qos_e::at_most_once)
+	{
+		_state->svc_ptr->free_pid(packet_id, was_throttled);
+		_state->results[_index] = rc;
+		if (ec && !_state->ec)
+			_state->ec = ec;
+		element_done();
+	}
+
+	void element_done() {
+		if (--_state->pending)
+			return;
+
+		if constexpr (qos_type == qos_e::at_most_once)
+			_state->handler.complete(_state->ec);
+		else
+			_state->handler.complete(
+				_state->ec, std::move(_state->results)
+			);
+	}
+
+	void complete_post(error_code ec) {
+		if constexpr (qos_type == qos_e::at_most_once)
+			_state->handler.complete_post(ec);
+		else
+			_state->handler.complete_post(ec, std::vector<reason_code> {});
+	}
+};
+
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_PUBLISH_BATCH_OP_HPP
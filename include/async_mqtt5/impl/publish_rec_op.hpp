@@ -2,6 +2,9 @@
 #define ASYNC_MQTT5_PUBLISH_REC_OP_HPP
 
 #include <memory>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 
 #include <boost/asio/consign.hpp>
 #include <boost/asio/detached.hpp>
@@ -15,6 +18,7 @@
 #include <async_mqtt5/detail/internal_types.hpp>
 
 #include <async_mqtt5/impl/disconnect_op.hpp>
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
 
@@ -22,7 +26,12 @@ namespace async_mqtt5::detail {
 
 namespace asio = boost::asio;
 
-template <typename ClientService>
+// Message is either decoders::publish_message or, when the Client
+// receives without copying, decoders::publish_message_view.
+template <
+	typename ClientService,
+	typename Message = decoders::publish_message
+>
 class publish_rec_op {
 	using client_service = ClientService;
 	struct on_puback {};
@@ -31,7 +40,9 @@ class publish_rec_op {
 	struct on_pubcomp {};
 
 	std::shared_ptr<client_service> _svc_ptr;
-	decoders::publish_message _message;
+	Message _message;
+	// the payload was passed to the payload sink instead of the channel
+	bool _streamed = false;
 
 public:
 	publish_rec_op(const std::shared_ptr<client_service>& svc_ptr) :
@@ -51,7 +62,7 @@ public:
 		return allocator_type {};
 	}
 
-	void perform(decoders::publish_message message) {
+	void perform(Message message) {
 		auto flags = std::get<2>(message);
 		auto qos_bits = (flags >> 1) & 0b11;
 		if (qos_bits == 0b11)
@@ -69,23 +80,65 @@ public:
 
 		if (qos == qos_e::at_least_once) {
 			auto puback = control_packet<allocator_type>::of(
-				with_pid, get_allocator(),
-				encoders::encode_puback, *packet_id,
-				uint8_t(0), puback_props {}
+				fixed, get_allocator(),
+				control_code_e::puback, *packet_id
 			);
 			return send_puback(std::move(puback));
 		}
 
 		// qos == qos_e::exactly_once
+		store_inbound_publish();
+
 		auto pubrec = control_packet<allocator_type>::of(
-			with_pid, get_allocator(),
-			encoders::encode_pubrec, *packet_id,
-			uint8_t(0), pubrec_props {}
+			fixed, get_allocator(),
+			control_code_e::pubrec, *packet_id
 		);
 
 		return send_pubrec(std::move(pubrec));
 	}
 
+	// Hands the variable header of a PUBLISH whose payload is streamed
+	// over to the payload sink. The packet is acknowledged by end_stream.
+	void begin_stream(decoders::publish_message message) {
+		auto flags = std::get<2>(message);
+		if (((flags >> 1) & 0b11) == 0b11)
+			return on_malformed_packet(
+				"Malformed PUBLISH received: QoS bits set to 0b11"
+			);
+
+		_svc_ptr->begin_payload_stream(std::move(message));
+	}
+
+	void end_stream() {
+		auto message = _svc_ptr->end_payload_stream();
+		if (!message)
+			return;
+
+		_streamed = true;
+		perform(std::move(*message));
+	}
+
+	// Resumes waiting for the PUBREL of a packet restored from
+	// the session store.
+	void resume(session_entry entry) {
+		auto packet = std::move(entry.header) + entry.payload;
+		auto control_byte = uint8_t(packet[0]);
+
+		byte_citer first = packet.cbegin() + 1;
+		auto varlen = decoders::type_parse(
+			first, packet.cend(), decoders::basic::varint_
+		);
+		if (!varlen)
+			return _svc_ptr->erase_inbound_publish(entry.packet_id);
+
+		auto message = decoders::decode_publish(control_byte, *varlen, first);
+		if (!message)
+			return _svc_ptr->erase_inbound_publish(entry.packet_id);
+
+		_message = std::move(*message);
+		wait_pubrel(entry.packet_id);
+	}
+
 	void send_puback(control_packet<allocator_type> puback) {
 		const auto& wire_data = puback.wire_data();
 		_svc_ptr->async_send(
@@ -118,6 +171,7 @@ public:
 		on_pubrec, control_packet<allocator_type> packet,
 		error_code ec
 	) {
+		// the packet stays in the session store if the Client was cancelled
 		if (ec)
 			return;
 
@@ -141,7 +195,7 @@ public:
 		if (ec)
 			return;
 
-		auto pubrel = decoders::decode_pubrel(std::distance(first, last), first);
+		auto pubrel = decoders::fast::decode_pubrel(std::distance(first, last), first);
 		if (!pubrel.has_value()) {
 			on_malformed_packet("Malformed PUBREL received: cannot decode");
 			return wait_pubrel(packet_id);
@@ -155,9 +209,8 @@ public:
 		}
 
 		auto pubcomp = control_packet<allocator_type>::of(
-			with_pid, get_allocator(),
-			encoders::encode_pubcomp, packet_id,
-			uint8_t(0), pubcomp_props{}
+			fixed, get_allocator(),
+			control_code_e::pubcomp, packet_id
 		);
 		send_pubcomp(std::move(pubcomp));
 	}
@@ -181,6 +234,7 @@ public:
 		if (ec)
 			return;
 
+		_svc_ptr->erase_inbound_publish(packet.packet_id());
 		complete();
 	}
 
@@ -194,8 +248,43 @@ private:
 		);
 	}
 
+	// The packet is stored before its PUBREC is sent and erased once
+	// its PUBCOMP has been written. A wait aborted by a duplicate of
+	// the packet leaves the entry of the duplicate in place.
+	// A streamed payload is not kept, and is streamed again if
+	// the Broker resends the packet.
+	void store_inbound_publish() {
+		if (_streamed || !_svc_ptr->session_store_enabled())
+			return;
+
+		auto packet_id = *std::get<1>(_message);
+		auto flags = std::get<2>(_message);
+		auto [topic, props, payload] = message_fields();
+		auto header = encoders::encode_publish_header(
+			packet_id, payload.size(), topic, qos_e::exactly_once,
+			retain_e(flags & 0b0001), dup_e((flags & 0b1000) >> 3), props
+		);
+		_svc_ptr->store_inbound_publish(packet_id, header, payload);
+	}
+
+	std::tuple<std::string_view, const publish_props&, std::string_view>
+	message_fields() const {
+		if constexpr (std::is_same_v<Message, decoders::publish_message>) {
+			auto& [topic, packet_id, flags, props, payload] = _message;
+			return { topic, props, payload };
+		}
+		else {
+			auto& view = std::get<0>(_message);
+			return { view.topic(), view.props(), view.payload() };
+		}
+	}
+
 	void complete() {
-		/* auto rv = */_svc_ptr->channel_store(std::move(_message));
+		if (_streamed)
+			return;
+		// the message is already acknowledged, so it is lost if the
+		// receive queue drops it (see receive_queue_e)
+		_svc_ptr->channel_store(std::move(_message));
 	}
 };
 
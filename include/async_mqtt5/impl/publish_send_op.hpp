@@ -5,13 +5,18 @@
 #include <boost/asio/prepend.hpp>
 
 #include <async_mqtt5/error.hpp>
+#include <async_mqtt5/prepared_publish.hpp>
+#include <async_mqtt5/publish_payload.hpp>
 #include <async_mqtt5/types.hpp>
 
 #include <async_mqtt5/detail/cancellable_handler.hpp>
 #include <async_mqtt5/detail/control_packet.hpp>
 #include <async_mqtt5/detail/internal_types.hpp>
+#include <async_mqtt5/detail/topic_alias_table.hpp>
+#include <async_mqtt5/detail/utf8_mqtt.hpp>
 
 #include <async_mqtt5/impl/disconnect_op.hpp>
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
 
@@ -52,6 +57,40 @@ using cancel_args = std::conditional_t<
 		>
 >;
 
+template <qos_e qos_type, typename ClientService>
+error_code validate_publish(
+	ClientService& svc, retain_e retain, const publish_props& props
+) {
+	auto max_qos = svc.connack_prop(prop::maximum_qos);
+	if (max_qos && uint8_t(qos_type) > *max_qos)
+		return client::error::qos_not_supported;
+
+	auto retain_available = svc.connack_prop(prop::retain_available);
+	if (retain_available && *retain_available == 0 && retain == retain_e::yes)
+		return client::error::retain_not_available;
+
+	auto topic_alias_max = svc.connack_prop(prop::topic_alias_maximum);
+	auto topic_alias = props[prop::topic_alias];
+	if ((!topic_alias_max || topic_alias_max && *topic_alias_max == 0) && topic_alias)
+		return client::error::topic_alias_maximum_reached;
+	if (topic_alias_max && topic_alias && *topic_alias > *topic_alias_max)
+		return client::error::topic_alias_maximum_reached;
+	return {};
+}
+
+// Also checks the Topic Name and the UTF-8 Encoded String properties,
+// unless the validation has been disabled for trusted input.
+template <qos_e qos_type, typename ClientService>
+error_code validate_publish(
+	ClientService& svc, std::string_view topic,
+	retain_e retain, const publish_props& props
+) {
+	if (svc.utf8_validation())
+		if (auto ec = validate_publish_strings(topic, props))
+			return ec;
+	return validate_publish<qos_type>(svc, retain, props);
+}
+
 template <typename ClientService, typename Handler, qos_e qos_type>
 class publish_send_op {
 	using client_service = ClientService;
@@ -71,6 +110,17 @@ class publish_send_op {
 	> _handler;
 
 	serial_num_t _serial_num;
+	traffic_class_e _traffic_class { traffic_class_e::telemetry };
+
+	// Only the first send of the packet is subject to the write limits.
+	bool _admitted { false };
+
+	// With automatic Topic Aliases, the Topic Name is kept to re-encode
+	// the packet once the aliases of the previous connection are gone.
+	std::string _topic;
+	publish_props _props;
+	retain_e _retain { retain_e::no };
+	topic_alias_table::lease _alias;
 
 public:
 	publish_send_op(
@@ -94,10 +144,13 @@ public:
 	}
 
 	void perform(
-		std::string topic, std::string payload,
-		retain_e retain, const publish_props& props
-	) {	
-		auto ec = validate_publish(retain, props);
+		std::string topic, publish_payload payload,
+		retain_e retain, const publish_props& props,
+		traffic_class_e traffic_class = traffic_class_e::telemetry
+	) {
+		_traffic_class = traffic_class;
+
+		auto ec = validate_publish(topic, retain, props);
 		if (ec)
 			return complete_post(ec);
 
@@ -110,49 +163,133 @@ public:
 
 		_serial_num = _svc_ptr->next_serial_num();
 
+		if (_svc_ptr->topic_aliases().enabled() && !topic.empty()) {
+			_topic = std::move(topic);
+			_props = props;
+			_retain = retain;
+
+			auto publish = control_packet<allocator_type>::of(
+				with_pid, get_allocator(),
+				encode_aliased_header(), packet_id,
+				with_payload, std::move(payload), dup_e::no
+			);
+
+			return send_publish(std::move(publish));
+		}
+
 		auto publish = control_packet<allocator_type>::of(
 			with_pid, get_allocator(),
-			encoders::encode_publish, packet_id,
-			std::move(topic), std::move(payload),
-			qos_type, retain, dup_e::no, props
+			encoders::encode_publish_header, packet_id,
+			with_payload, std::move(payload),
+			topic, qos_type, retain, dup_e::no, props
 		);
 
 		send_publish(std::move(publish));
 	}
 
+	void perform(
+		const prepared_publish<qos_type>& prepared, publish_payload payload,
+		retain_e retain
+	) {
+		_traffic_class = prepared.traffic_class();
+
+		auto ec = _svc_ptr->utf8_validation() ?
+			prepared.validation() : error_code {};
+		if (!ec)
+			ec = validate_publish(retain, prepared.props());
+		if (ec)
+			return complete_post(ec);
+
+		uint16_t packet_id = 0;
+		if constexpr (qos_type != qos_e::at_most_once) {
+			packet_id = _svc_ptr->allocate_pid();
+			if (packet_id == 0)
+				return complete_post(client::error::pid_overrun);
+		}
+
+		_serial_num = _svc_ptr->next_serial_num();
+
+		auto publish = control_packet<allocator_type>::of(
+			with_pid, get_allocator(),
+			encoders::encode_prepared_publish_header, packet_id,
+			with_payload, std::move(payload),
+			prepared.var_header(), prepared.packet_id_offset(),
+			qos_type, retain, dup_e::no
+		);
+
+		send_publish(std::move(publish));
+	}
+
+	// Resumes the exchange of an outgoing packet restored from
+	// the session store.
+	void resume(session_entry entry) {
+		_serial_num = _svc_ptr->next_serial_num();
+		_admitted = true;
+
+		if constexpr (qos_type == qos_e::exactly_once)
+			if (entry.kind == session_entry_e::pubrel) {
+				auto pubrel = control_packet<allocator_type>::of(
+					fixed, get_allocator(),
+					control_code_e::pubrel, entry.packet_id
+				);
+				return send_pubrel(std::move(pubrel), true);
+			}
+
+		auto publish = control_packet<allocator_type>::of(
+			with_pid, get_allocator(),
+			encoders::encode_stored_header, entry.packet_id,
+			with_payload, std::move(entry.payload), entry.header
+		);
+
+		send_publish(std::move(publish.set_dup()));
+	}
+
 	error_code validate_publish(
 		retain_e retain, const publish_props& props
 	) {
-		auto max_qos = _svc_ptr->connack_prop(prop::maximum_qos);
-		if (max_qos && uint8_t(qos_type) > *max_qos)
-			return client::error::qos_not_supported;
-
-		auto retain_available = _svc_ptr->connack_prop(prop::retain_available);
-		if (retain_available && *retain_available == 0 && retain == retain_e::yes)
-			return client::error::retain_not_available;
-
-		// TODO: topic alias mapping
-		auto topic_alias_max = _svc_ptr->connack_prop(prop::topic_alias_maximum);
-		auto topic_alias = props[prop::topic_alias];
-		if ((!topic_alias_max || topic_alias_max && *topic_alias_max == 0) && topic_alias)
-			return client::error::topic_alias_maximum_reached;
-		if (topic_alias_max && topic_alias && *topic_alias > *topic_alias_max)
-			return client::error::topic_alias_maximum_reached;
-		return {};
+		return detail::validate_publish<qos_type>(*_svc_ptr, retain, props);
+	}
+
+	error_code validate_publish(
+		std::string_view topic, retain_e retain, const publish_props& props
+	) {
+		return detail::validate_publish<qos_type>(
+			*_svc_ptr, topic, retain, props
+		);
 	}
 
 	void send_publish(control_packet<allocator_type> publish) {
 		if (_handler.empty()) { // already cancelled
+			release_topic_alias(false);
 			if constexpr (qos_type != qos_e::at_most_once)
 				_svc_ptr->free_pid(publish.packet_id());
 			return;
 		}
 
+		if (!_topic.empty() && !_svc_ptr->topic_aliases().current(_alias))
+			publish.reencode(
+				with_payload, encode_aliased_header(), publish.dup()
+			);
+
+		if constexpr (qos_type != qos_e::at_most_once)
+			if (!_admitted) {
+				// packets using automatic Topic Aliases may need to be re-encoded
+				if (_topic.empty())
+					_svc_ptr->spill(publish);
+				store_publish(publish);
+			}
+
+		auto flags =
+			(send_flag::throttled * (qos_type != qos_e::at_most_once)) |
+			(send_flag::droppable * (qos_type == qos_e::at_most_once)) |
+			(send_flag::bounded * !_admitted) |
+			send_flag::traffic_class(_traffic_class);
+		_admitted = true;
+
 		const auto& wire_data = publish.wire_data();
 		_svc_ptr->async_send(
 			wire_data,
-			_serial_num,
-			send_flag::throttled * (qos_type != qos_e::at_most_once),
+			_serial_num, flags,
 			asio::prepend(std::move(*this), on_publish {}, std::move(publish))
 		);
 	}
@@ -164,12 +301,21 @@ public:
 		if (ec == asio::error::try_again)
 			return send_publish(std::move(publish));
 
+		release_topic_alias(!ec);
+
 		if constexpr (qos_type == qos_e::at_most_once)
 			return complete(ec);
 
 		else {
 			auto packet_id = publish.packet_id();
 
+			// the packet was never written and holds no Receive Maximum quota
+			if (ec == client::error::queue_full)
+				return complete(
+					ec, reason_codes::empty, packet_id,
+					on_publish_props_type<qos_type> {}, false
+				);
+
 			if constexpr (qos_type == qos_e::at_least_once) {
 				if (ec)
 					return complete(
@@ -214,7 +360,7 @@ public:
 				ec, reason_codes::empty, packet_id, puback_props {}
 			);
 
-		auto puback = decoders::decode_puback(std::distance(first, last), first);
+		auto puback = decoders::fast::decode_puback(std::distance(first, last), first);
 		if (!puback.has_value()) {
 			on_malformed_packet("Malformed PUBACK: cannot decode");
 			return send_publish(std::move(publish.set_dup()));
@@ -246,7 +392,7 @@ public:
 				ec, reason_codes::empty, packet_id, pubcomp_props {}
 			);
 
-		auto pubrec = decoders::decode_pubrec(std::distance(first, last), first);
+		auto pubrec = decoders::fast::decode_pubrec(std::distance(first, last), first);
 		if (!pubrec.has_value()) {
 			on_malformed_packet("Malformed PUBREC: cannot decode");
 			return send_publish(std::move(publish.set_dup()));
@@ -263,10 +409,11 @@ public:
 		if (*rc)
 			return complete(ec, *rc, packet_id, pubcomp_props {});
 
+		_svc_ptr->store_pubrel(packet_id);
+
 		auto pubrel = control_packet<allocator_type>::of(
-			with_pid, get_allocator(),
-			encoders::encode_pubrel, packet_id,
-			0, pubrel_props {}
+			fixed, get_allocator(),
+			control_code_e::pubrel, packet_id
 		);
 
 		send_pubrel(std::move(pubrel), false);
@@ -320,7 +467,7 @@ public:
 				ec, reason_codes::empty, packet_id, pubcomp_props {}
 			);
 
-		auto pubcomp = decoders::decode_pubcomp(std::distance(first, last), first);
+		auto pubcomp = decoders::fast::decode_pubcomp(std::distance(first, last), first);
 		if (!pubcomp.has_value()) {
 			on_malformed_packet("Malformed PUBCOMP: cannot decode");
 			return send_pubrel(std::move(pubrel), true);
@@ -339,6 +486,60 @@ public:
 
 
 private:
+	// Encodes the header using the Topic Alias of the Topic Name,
+	// or without one if every alias is in use.
+	auto encode_aliased_header() {
+		return [this](
+			uint16_t packet_id, size_t payload_size, dup_e dup,
+			const auto& alloc
+		) {
+			auto& aliases = _svc_ptr->topic_aliases();
+			aliases.release(_alias);
+			_alias = aliases.acquire(_topic);
+
+			if (_alias.alias)
+				_props[prop::topic_alias] = int16_t(_alias.alias);
+			else
+				_props[prop::topic_alias] = std::nullopt;
+
+			return encoders::encode_publish_header(
+				packet_id, payload_size,
+				_alias.alias_only ? std::string_view {} : _topic,
+				qos_type, _retain, dup, _props, alloc
+			);
+		};
+	}
+
+	void store_publish(const control_packet<allocator_type>& publish) {
+		if (_topic.empty())
+			return _svc_ptr->store_publish(publish);
+
+		if (!_svc_ptr->session_store_enabled())
+			return;
+
+		// Topic Aliases do not outlive the Network Connection
+		auto props = _props;
+		props[prop::topic_alias] = std::nullopt;
+		const auto& payload = publish.wire_data()[1];
+		auto header = encoders::encode_publish_header(
+			publish.packet_id(), payload.size(),
+			_topic, qos_type, _retain, dup_e::no, props
+		);
+		_svc_ptr->store_publish(
+			publish.packet_id(), header,
+			{ static_cast<const char*>(payload.data()), payload.size() }
+		);
+	}
+
+	void release_topic_alias(bool written) {
+		if (_topic.empty())
+			return;
+		auto& aliases = _svc_ptr->topic_aliases();
+		if (written)
+			aliases.established(_alias);
+		aliases.release(_alias);
+	}
+
 	void on_malformed_packet(const std::string& reason) {
 		auto props = disconnect_props {};
 		props[prop::reason_string] = reason;
@@ -367,9 +568,9 @@ private:
 	)
 	void complete(
 		error_code ec, reason_code rc,
-		uint16_t packet_id, Props&& props
+		uint16_t packet_id, Props&& props, bool was_throttled = true
 	) {
-		_svc_ptr->free_pid(packet_id, true);
+		_svc_ptr->free_pid(packet_id, was_throttled);
 		_handler.complete(ec, rc, std::forward<Props>(props));
 	}
 
@@ -9,11 +9,13 @@
 #include <async_mqtt5/types.hpp>
 
 #include <async_mqtt5/detail/control_packet.hpp>
+#include <async_mqtt5/detail/utf8_mqtt.hpp>
 
 #include <async_mqtt5/impl/disconnect_op.hpp>
 #include <async_mqtt5/impl/publish_rec_op.hpp>
 #include <async_mqtt5/impl/re_auth_op.hpp>
 
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
 
 namespace async_mqtt5::detail {
@@ -59,27 +61,57 @@ public:
 		uint8_t control_code,
 		byte_citer first, byte_citer last
 	) {
-		if (ec == client::error::malformed_packet)
-			return on_malformed_packet(
-				"Malformed Packet received from the Server"
+		// the packets left in the read buffer are handled in the same pass,
+		// instead of each taking a round trip through the executor
+		for (;;) {
+			if (!handle(ec, control_code, first, last))
+				return;
+
+			auto packet = _svc_ptr->assemble_buffered();
+			if (!packet)
+				return perform();
+
+			ec = packet->ec;
+			control_code = packet->control_byte;
+			first = packet->first;
+			last = packet->last;
+		}
+	}
+
+	void operator()(on_disconnect, error_code ec) {
+		if (!ec)
+			perform();
+	}
+
+private:
+	// Returns whether the next buffered packet can be handled.
+	bool handle(
+		error_code ec, uint8_t control_code,
+		byte_citer first, byte_citer last
+	) {
+		if (ec == client::error::malformed_packet) {
+			on_malformed_packet("Malformed Packet received from the Server");
+			return false;
+		}
+
+		if (ec == client::error::packet_too_large) {
+			on_protocol_error(
+				disconnect_rc_e::packet_too_large,
+				"Packet larger than the Maximum Packet Size received"
 			);
+			return false;
+		}
 
 		if (
 			ec == asio::error::operation_aborted ||
 			ec == asio::error::no_recovery
 		)
-			return;
-
-		dispatch(control_code, first, last);
-	}
+			return false;
 
-	void operator()(on_disconnect, error_code ec) {
-		if (!ec)
-			perform();
+		return dispatch(control_code, first, last);
 	}
 
-private:
-	void dispatch(
+	bool dispatch(
 		uint8_t control_byte,
 		byte_citer first, byte_citer last
 	) {
@@ -88,17 +120,23 @@ private:
 
 		switch (code) {
 			case publish: {
-				auto msg = decoders::decode_publish(
-					control_byte, std::distance(first, last), first
-				);
-				if (!msg.has_value())
-					return on_malformed_packet(
-						"Malformed PUBLISH received: cannot decode"
-					);
-
-				publish_rec_op { _svc_ptr }.perform(std::move(*msg));
+				bool zero_copy = _svc_ptr->zero_copy_receive() &&
+					!_svc_ptr->payload_stream_starting();
+				bool ok = zero_copy ?
+					on_publish(decoders::fast::decode_publish_view(
+						control_byte, std::distance(first, last), first,
+						_svc_ptr->share_read_buffer()
+					)) :
+					on_publish(decoders::fast::decode_publish(
+						control_byte, std::distance(first, last), first
+					));
+				if (!ok)
+					return false;
 			}
 			break;
+			case no_packet: // the payload of a streamed PUBLISH has been read
+				publish_rec_op { _svc_ptr }.end_stream();
+			break;
 			case disconnect: {
 				_svc_ptr->close_stream();
 				_svc_ptr->open_stream();
@@ -108,25 +146,72 @@ private:
 				auto rv = decoders::decode_auth(
 					std::distance(first, last), first
 				);
-				if (!rv.has_value())
-					return on_malformed_packet(
-						"Malformed AUTH received: cannot decode"
-					);
+				if (!rv.has_value()) {
+					on_malformed_packet("Malformed AUTH received: cannot decode");
+					return false;
+				}
 
 				re_auth_op { _svc_ptr }.perform(std::move(*rv));
 			}
 			break;
 		}
 
-		perform();
+		return true;
+	}
+
+	static bool valid_strings(const decoders::publish_message& msg) {
+		const auto& [topic, packet_id, flags, props, payload] = msg;
+		return is_valid_topic_name(topic) && is_valid_mqtt_utf8(props);
+	}
+
+	static bool valid_strings(const decoders::publish_message_view& msg) {
+		const auto& view = std::get<0>(msg);
+		return is_valid_topic_name(view.topic()) &&
+			is_valid_mqtt_utf8(view.props());
+	}
+
+	template <typename Message>
+	bool on_publish(std::optional<Message> msg) {
+		if (!msg.has_value()) {
+			on_malformed_packet("Malformed PUBLISH received: cannot decode");
+			return false;
+		}
+
+		if (_svc_ptr->utf8_validation() && !valid_strings(*msg)) {
+			on_malformed_packet("Malformed PUBLISH received: invalid string");
+			return false;
+		}
+
+		// resolved in the order of arrival, before any
+		// later PUBLISH can map the alias to another topic
+		auto rc = _svc_ptr->resolve_topic_alias(*msg);
+		if (rc) {
+			on_protocol_error(*rc, "Invalid Topic Alias received");
+			return false;
+		}
+
+		if constexpr (std::is_same_v<Message, decoders::publish_message>) {
+			if (_svc_ptr->payload_stream_starting()) {
+				publish_rec_op { _svc_ptr }.begin_stream(std::move(*msg));
+				return true;
+			}
+		}
+
+		publish_rec_op<client_service, Message> { _svc_ptr }
+			.perform(std::move(*msg));
+		return true;
 	}
 
 	void on_malformed_packet(const std::string& reason) {
+		on_protocol_error(disconnect_rc_e::malformed_packet, reason);
+	}
+
+	void on_protocol_error(disconnect_rc_e rc, const std::string& reason) {
 		auto props = disconnect_props {};
 		props[prop::reason_string] = reason;
 		auto svc_ptr = _svc_ptr; // copy before this is moved
 		async_disconnect(
-			disconnect_rc_e::malformed_packet, props, false, svc_ptr,
+			rc, props, false, svc_ptr,
 			asio::prepend(std::move(*this), on_disconnect {})
 		);
 	}
@@ -1,45 +1,66 @@
 #ifndef ASYNC_MQTT5_REPLIES_HPP
 #define ASYNC_MQTT5_REPLIES_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <optional>
+
 #include <boost/asio/any_completion_handler.hpp>
 #include <boost/asio/consign.hpp>
 #include <boost/asio/error.hpp>
 #include <boost/asio/post.hpp>
 
+#include <async_mqtt5/types.hpp>
+
 #include <async_mqtt5/detail/control_packet.hpp>
 #include <async_mqtt5/detail/internal_types.hpp>
+#include <async_mqtt5/detail/reply_table.hpp>
 
 namespace async_mqtt5::detail {
 
 namespace asio = boost::asio;
 
+struct reply_deadline {
+	std::chrono::steady_clock::time_point at;
+	control_code_e code;
+	uint16_t packet_id;
+
+	bool operator>(const reply_deadline& other) const noexcept {
+		return at > other.at;
+	}
+};
+
 class replies {
 	using signature = void (error_code, byte_citer, byte_citer);
-
-	static constexpr auto max_reply_time = std::chrono::seconds(20);
+	using clock = std::chrono::steady_clock;
 
 	class handler_type : public asio::any_completion_handler<signature> {
 		using base = asio::any_completion_handler<signature>;
 		control_code_e _code;
 		uint16_t _packet_id;
-		std::chrono::time_point<std::chrono::system_clock> _ts;
+		clock::time_point _deadline;
 	public:
 		template <typename H>
-		handler_type(control_code_e code, uint16_t pid, H&& handler) :
+		handler_type(
+			control_code_e code, uint16_t pid, clock::time_point deadline,
+			H&& handler
+		) :
 			base(std::forward<H>(handler)), _code(code), _packet_id(pid),
-			_ts(std::chrono::system_clock::now())
+			_deadline(deadline)
 		{}
 
 		handler_type(handler_type&& other) noexcept :
 			base(static_cast<base&&>(other)),
-			_code(other._code), _packet_id(other._packet_id), _ts(other._ts)
+			_code(other._code), _packet_id(other._packet_id),
+			_deadline(other._deadline)
 		{}
 
 		handler_type& operator=(handler_type&& other) noexcept {
 			base::operator=(static_cast<base&&>(other));
 			_code = other._code;
 			_packet_id = other._packet_id;
-			_ts = other._ts;
+			_deadline = other._deadline;
 			return *this;
 		}
 
@@ -51,20 +72,33 @@ class replies {
 			return _code;
 		}
 
-		auto time() const noexcept {
-			return _ts;
+		auto deadline() const noexcept {
+			return _deadline;
 		}
 	};
 
-	using handlers = std::vector<handler_type>;
+	using handlers = reply_table<handler_type>;
 	handlers _handlers;
 
+	// Min-heap of the deadlines of awaited replies. Deadlines of replies
+	// that have since arrived are discarded once they reach the top.
+	std::vector<reply_deadline> _deadlines;
+	reply_timeouts _timeouts;
+
 	struct fast_reply {
-		control_code_e code;
-		uint16_t packet_id;
+		control_code_e _code;
+		uint16_t _packet_id;
 		std::unique_ptr<std::string> packet;
+
+		uint16_t packet_id() const noexcept {
+			return _packet_id;
+		}
+
+		control_code_e code() const noexcept {
+			return _code;
+		}
 	};
-	using fast_replies = std::vector<fast_reply>;
+	using fast_replies = reply_table<fast_reply>;
 	fast_replies _fast_replies;
 
 public:
@@ -72,28 +106,29 @@ public:
 	decltype(auto) async_wait_reply(
 		control_code_e code, uint16_t packet_id, CompletionToken&& token
 	) {
-		auto dup_handler_ptr = find_handler(code, packet_id);
-		if (dup_handler_ptr != _handlers.end()) {
-			std::move(*dup_handler_ptr)(
+		auto dup_handler_ptr = _handlers.find(code, packet_id);
+		if (dup_handler_ptr) {
+			auto dup_handler = _handlers.take(dup_handler_ptr);
+			std::move(dup_handler)(
 				asio::error::operation_aborted, byte_citer {}, byte_citer {}
 			);
-			_handlers.erase(dup_handler_ptr);
 		}
 
-		auto freply = find_fast_reply(code, packet_id);
-		if (freply == _fast_replies.end()) {
+		auto freply = _fast_replies.find(code, packet_id);
+		if (!freply) {
 			auto initiate = [this](
 				auto handler, control_code_e code, uint16_t packet_id
 			) {
-				_handlers.emplace_back(code, packet_id, std::move(handler));
+				auto deadline = clock::now() + timeout(code);
+				_handlers.emplace(code, packet_id, deadline, std::move(handler));
+				push_deadline({ deadline, code, packet_id });
 			};
 			return asio::async_initiate<CompletionToken, signature>(
 				std::move(initiate), token, code, packet_id
 			);
 		}
 
-		auto fdata = std::move(*freply);
-		_fast_replies.erase(freply);
+		auto fdata = _fast_replies.take(freply);
 
 		byte_citer first = fdata.packet->cbegin(), last = fdata.packet->cend();
 		auto with_packet = asio::consign(
@@ -114,26 +149,38 @@ public:
 		error_code ec, control_code_e code, uint16_t packet_id,
 		byte_citer first, byte_citer last
 	) {
-		auto handler_ptr = find_handler(code, packet_id);
-		if (handler_ptr == _handlers.end()) {
-			_fast_replies.push_back({
+		auto handler_ptr = _handlers.find(code, packet_id);
+		if (!handler_ptr) {
+			_fast_replies.emplace(fast_reply {
 				code, packet_id, std::make_unique<std::string>(first, last)
 			});
 			return;
 		}
-		auto handler = std::move(*handler_ptr);
-		_handlers.erase(handler_ptr);
+		auto handler = _handlers.take(handler_ptr);
 		std::move(handler)(ec, first, last);
 	}
 
+	void timeouts(const reply_timeouts& timeouts) {
+		_timeouts = timeouts;
+	}
+
+	std::chrono::milliseconds shortest_timeout() const {
+		return std::min({
+			_timeouts.puback, _timeouts.pubrec, _timeouts.pubrel,
+			_timeouts.pubcomp, _timeouts.suback, _timeouts.unsuback
+		});
+	}
+
 	void resend_unanswered() {
-		auto ua = std::move(_handlers);
+		_deadlines.clear();
+		auto ua = _handlers.release();
 		for (auto& h : ua)
 			std::move(h)(asio::error::try_again, byte_citer {}, byte_citer {});
 	}
 
 	void cancel_unanswered() {
-		auto ua = std::move(_handlers);
+		_deadlines.clear();
+		auto ua = _handlers.release();
 		for (auto& h : ua)
 			std::move(h)(
 				asio::error::operation_aborted,
@@ -141,54 +188,68 @@ public:
 			);
 	}
 
-	bool any_expired() {
-		auto now = std::chrono::system_clock::now();
-		return std::any_of(
-			_handlers.begin(), _handlers.end(),
-			[now](const auto& h) {
-				return now - h.time() > max_reply_time;
-			}
-		);
+	// Returns the earliest deadline of the awaited replies, if any.
+	std::optional<reply_deadline> next_deadline() {
+		while (!_deadlines.empty()) {
+			const auto& top = _deadlines.front();
+			auto handler = _handlers.find(top.code, top.packet_id);
+			if (handler && handler->deadline() == top.at)
+				return top;
+			std::pop_heap(
+				_deadlines.begin(), _deadlines.end(), std::greater<> {}
+			);
+			_deadlines.pop_back();
+		}
+		return std::nullopt;
 	}
 
 	void clear_fast_replies() {
 		_fast_replies.clear();
 	}
 
-	void clear_pending_pubrels() {
-		for (auto it = _handlers.begin(); it != _handlers.end();) {
-			if (it->code() == control_code_e::pubrel) {
-				std::move(*it)(
-					asio::error::operation_aborted, byte_citer {}, byte_citer {}
-				);
-				it = _handlers.erase(it);
-			}
-			else
-				++it;
+	// Returns the Packet Identifiers of the aborted waits.
+	std::vector<uint16_t> clear_pending_pubrels() {
+		auto pubrels = _handlers.extract_if([](const auto& h) {
+			return h.code() == control_code_e::pubrel;
+		});
+
+		std::vector<uint16_t> packet_ids;
+		for (auto& h : pubrels) {
+			packet_ids.push_back(h.packet_id());
+			std::move(h)(
+				asio::error::operation_aborted, byte_citer {}, byte_citer {}
+			);
 		}
+		return packet_ids;
 	}
 
 private:
-	handlers::iterator find_handler(control_code_e code, uint16_t packet_id) {
-		return std::find_if(
-			_handlers.begin(), _handlers.end(),
-			[code, packet_id](const auto& h) {
-				return h.code() == code && h.packet_id() == packet_id;
-			}
-		);
+	std::chrono::milliseconds timeout(control_code_e code) const {
+		switch (code) {
+			case control_code_e::puback: return _timeouts.puback;
+			case control_code_e::pubrec: return _timeouts.pubrec;
+			case control_code_e::pubrel: return _timeouts.pubrel;
+			case control_code_e::pubcomp: return _timeouts.pubcomp;
+			case control_code_e::suback: return _timeouts.suback;
+			case control_code_e::unsuback: return _timeouts.unsuback;
+			default: return shortest_timeout();
+		}
 	}
 
-	fast_replies::iterator find_fast_reply(
-		control_code_e code, uint16_t packet_id
-	) {
-		return std::find_if(
-			_fast_replies.begin(), _fast_replies.end(),
-			[code, packet_id](const auto& f) {
-				return f.code == code && f.packet_id == packet_id;
-			}
-		);
+	void push_deadline(reply_deadline deadline) {
+		// rebuild the heap once discarded deadlines outnumber the live ones,
+		// the new deadline belongs to a handler that is already in the table
+		if (_deadlines.size() > 2 * _handlers.size() + 64) {
+			_deadlines.clear();
+			for (const auto& h : _handlers)
+				_deadlines.push_back({ h.deadline(), h.code(), h.packet_id() });
+			return std::make_heap(
+				_deadlines.begin(), _deadlines.end(), std::greater<> {}
+			);
+		}
+		_deadlines.push_back(deadline);
+		std::push_heap(_deadlines.begin(), _deadlines.end(), std::greater<> {});
 	}
-
 };
 
 } // end namespace async_mqtt5::detail
@@ -0,0 +1,77 @@
+#ifndef ASYNC_MQTT5_RESUME_SESSION_HPP
+#define ASYNC_MQTT5_RESUME_SESSION_HPP
+
+#include <memory>
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/detached.hpp>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/impl/publish_rec_op.hpp>
+#include <async_mqtt5/impl/publish_send_op.hpp>
+
+namespace async_mqtt5::detail {
+
+namespace asio = boost::asio;
+
+template <qos_e qos_type, typename ClientService, typename CompletionToken>
+decltype(auto) async_resume_publish(
+	session_entry entry, const std::shared_ptr<ClientService>& svc_ptr,
+	CompletionToken&& token
+) {
+	using Signature = on_publish_signature<qos_type>;
+
+	auto initiate = [](
+		auto handler, session_entry entry,
+		const std::shared_ptr<ClientService>& svc_ptr
+	) {
+		publish_send_op<
+			ClientService, decltype(handler), qos_type
+		> { svc_ptr, std::move(handler) }.resume(std::move(entry));
+	};
+
+	return asio::async_initiate<CompletionToken, Signature>(
+		std::move(initiate), token, std::move(entry), svc_ptr
+	);
+}
+
+// Resumes the exchanges of the in-flight packets restored from the
+// session store. Their Application Messages were published by
+// a previous run, so nobody waits for their completion.
+template <typename ClientService>
+void resume_session(const std::shared_ptr<ClientService>& svc_ptr) {
+	for (auto& entry : svc_ptr->restore_session()) {
+		switch (entry.kind) {
+			case session_entry_e::publish: {
+				auto qos = entry.header.empty() ?
+					qos_e::at_most_once :
+					qos_e((uint8_t(entry.header[0]) & 0b00000110) >> 1);
+
+				if (qos == qos_e::at_least_once)
+					async_resume_publish<qos_e::at_least_once>(
+						std::move(entry), svc_ptr, asio::detached
+					);
+				else if (qos == qos_e::exactly_once)
+					async_resume_publish<qos_e::exactly_once>(
+						std::move(entry), svc_ptr, asio::detached
+					);
+				else
+					svc_ptr->free_pid(entry.packet_id);
+			}
+			break;
+			case session_entry_e::pubrel:
+				async_resume_publish<qos_e::exactly_once>(
+					std::move(entry), svc_ptr, asio::detached
+				);
+			break;
+			case session_entry_e::inbound_publish:
+				publish_rec_op { svc_ptr }.resume(std::move(entry));
+			break;
+		}
+	}
+}
+
+} // end namespace async_mqtt5::detail
+
+#endif // !ASYNC_MQTT5_RESUME_SESSION_HPP
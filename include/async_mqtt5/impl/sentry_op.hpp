@@ -1,6 +1,11 @@
 #ifndef ASYNC_MQTT5_SENTRY_OP_HPP
 #define ASYNC_MQTT5_SENTRY_OP_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+
 #include <boost/asio/cancellation_signal.hpp>
 #include <boost/asio/error.hpp>
 #include <boost/asio/prepend.hpp>
@@ -54,7 +59,15 @@ public:
 	}
 
 	void perform() {
-		_sentry_timer->expires_after(check_interval);
+		// wake up no later than the earliest deadline of an awaited reply
+		auto check_after = std::min<std::chrono::steady_clock::duration>(
+			check_interval, _svc_ptr->_replies.shortest_timeout()
+		);
+		auto expires_at = std::chrono::steady_clock::now() + check_after;
+		if (auto next = _svc_ptr->_replies.next_deadline())
+			expires_at = std::min(expires_at, next->at);
+
+		_sentry_timer->expires_at(expires_at);
 		_sentry_timer->async_wait(
 			asio::prepend(std::move(*this), on_timer {})
 		);
@@ -66,10 +79,13 @@ public:
 		if (ec == asio::error::operation_aborted || !_svc_ptr->is_open())
 			return;
 
-		if (_svc_ptr->_replies.any_expired()) {
+		auto next = _svc_ptr->_replies.next_deadline();
+		if (next && next->at <= std::chrono::steady_clock::now()) {
 			auto props = disconnect_props{};
-			// TODO add what packet was expected?
-			props[prop::reason_string] = "No reply received within 20 seconds";
+			props[prop::reason_string] =
+				"No " + std::string(reply_name(next->code)) +
+				" received for Packet Identifier " +
+				std::to_string(next->packet_id);
 			auto svc_ptr = _svc_ptr;
 			return async_disconnect(
 				disconnect_rc_e::unspecified_error, props, false, svc_ptr,
@@ -86,6 +102,19 @@ public:
 		if (!ec)
 			perform();
 	}
+
+private:
+	static std::string_view reply_name(control_code_e code) {
+		switch (code) {
+			case control_code_e::puback: return "PUBACK";
+			case control_code_e::pubrec: return "PUBREC";
+			case control_code_e::pubrel: return "PUBREL";
+			case control_code_e::pubcomp: return "PUBCOMP";
+			case control_code_e::suback: return "SUBACK";
+			case control_code_e::unsuback: return "UNSUBACK";
+			default: return "reply";
+		}
+	}
 };
 
 
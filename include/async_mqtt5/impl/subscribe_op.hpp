@@ -8,7 +8,9 @@
 #include <async_mqtt5/detail/cancellable_handler.hpp>
 #include <async_mqtt5/detail/control_packet.hpp>
 #include <async_mqtt5/detail/internal_types.hpp>
+#include <async_mqtt5/detail/utf8_mqtt.hpp>
 
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
 
@@ -57,6 +59,10 @@ public:
 		const std::vector<subscribe_topic>& topics,
 		const subscribe_props& props
 	) {
+		auto ec = validate_subscribe(topics, props);
+		if (ec)
+			return complete_post(ec);
+
 		uint16_t packet_id = _svc_ptr->allocate_pid();
 		if (packet_id == 0)
 			return complete_post(client::error::pid_overrun);
@@ -70,6 +76,20 @@ public:
 		send_subscribe(std::move(subscribe));
 	}
 
+	error_code validate_subscribe(
+		const std::vector<subscribe_topic>& topics,
+		const subscribe_props& props
+	) const {
+		if (!_svc_ptr->utf8_validation())
+			return {};
+		for (const auto& topic : topics)
+			if (!is_valid_topic_filter(topic.topic_filter))
+				return client::error::invalid_topic;
+		if (!is_valid_mqtt_utf8(props))
+			return client::error::malformed_string;
+		return {};
+	}
+
 	void send_subscribe(control_packet<allocator_type> subscribe) {
 		if (_handler.empty()) // already cancelled
 			return _svc_ptr->free_pid(subscribe.packet_id());
@@ -114,7 +134,7 @@ public:
 		if (ec)
 			return complete(ec, packet_id, {}, {});
 
-		auto suback = decoders::decode_suback(std::distance(first, last), first);
+		auto suback = decoders::fast::decode_suback(std::distance(first, last), first);
 		if (!suback.has_value()) {
 			on_malformed_packet("Malformed SUBACK: cannot decode");
 			return send_subscribe(std::move(packet));
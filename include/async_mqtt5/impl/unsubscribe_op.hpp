@@ -9,6 +9,7 @@
 #include <async_mqtt5/detail/cancellable_handler.hpp>
 #include <async_mqtt5/detail/control_packet.hpp>
 #include <async_mqtt5/detail/internal_types.hpp>
+#include <async_mqtt5/detail/utf8_mqtt.hpp>
 
 #include <async_mqtt5/impl/disconnect_op.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
@@ -57,6 +58,10 @@ public:
 		const std::vector<std::string>& topics,
 		const unsubscribe_props& props
 	) {
+		auto ec = validate_unsubscribe(topics, props);
+		if (ec)
+			return complete_post(ec);
+
 		uint16_t packet_id = _svc_ptr->allocate_pid();
 		if (packet_id == 0)
 			return complete_post(client::error::pid_overrun);
@@ -70,6 +75,20 @@ public:
 		send_unsubscribe(std::move(unsubscribe));
 	}
 
+	error_code validate_unsubscribe(
+		const std::vector<std::string>& topics,
+		const unsubscribe_props& props
+	) const {
+		if (!_svc_ptr->utf8_validation())
+			return {};
+		for (const auto& topic : topics)
+			if (!is_valid_topic_filter(topic))
+				return client::error::invalid_topic;
+		if (!is_valid_mqtt_utf8(props))
+			return client::error::malformed_string;
+		return {};
+	}
+
 	void send_unsubscribe(control_packet<allocator_type> unsubscribe) {
 		if (_handler.empty()) // already cancelled
 			return _svc_ptr->free_pid(unsubscribe.packet_id());
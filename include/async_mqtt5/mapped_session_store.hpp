@@ -0,0 +1,325 @@
+#ifndef ASYNC_MQTT5_MAPPED_SESSION_STORE_HPP
+#define ASYNC_MQTT5_MAPPED_SESSION_STORE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/allocate_file.hpp>
+
+namespace async_mqtt5 {
+
+/**
+ * \brief A session store that keeps the in-flight state of a Client
+ * in a memory-mapped journal file.
+ *
+ * \details Every change of the in-flight state is appended to the journal as a record.
+ * When the journal is opened, its records are replayed to recover the entries.
+ * Once the journal is full, the records of the current entries are copied to a new file
+ * that replaces the journal, which doubles in size if it is more than half full.
+ *
+ * Records are written to the mapped pages of the file, so they survive a restart
+ * of the application. They survive a crash of the operating system only
+ * once they have been written to disk, see \ref flush.
+ *
+ * \see \ref mqtt_client::session_store
+ */
+class mapped_session_store {
+	static constexpr std::string_view magic = "AMQ5SES1";
+
+	// kind (1), Packet Identifier (2), header size (4), payload size (4)
+	static constexpr size_t record_header_size = 11;
+
+	// record kinds following those of session_entry_e
+	static constexpr uint8_t erase_outbound = 4;
+	static constexpr uint8_t erase_inbound = 5;
+
+	struct record {
+		uint8_t kind;
+		uint16_t packet_id;
+		uint32_t header_size;
+		uint32_t payload_size;
+
+		size_t size() const {
+			return record_header_size + header_size + payload_size;
+		}
+	};
+
+	std::filesystem::path _path;
+	boost::interprocess::mapped_region _region;
+	size_t _used { 0 };
+
+	// offsets of the records holding the current entries
+	std::map<uint16_t, size_t> _outbound;
+	std::map<uint16_t, size_t> _inbound;
+
+public:
+	/**
+	 * \brief Opens the journal at the given path, or creates it if it does not exist.
+	 *
+	 * \param path The path of the journal file.
+	 * \param capacity The size of a newly created journal file in bytes.
+	 *
+	 * \throws boost::interprocess::interprocess_exception or std::filesystem::filesystem_error
+	 * if the file cannot be created or mapped, and std::runtime_error if the file
+	 * is not a journal.
+	 */
+	explicit mapped_session_store(
+		std::string path, size_t capacity = 1024 * 1024
+	) :
+		_path(std::move(path))
+	{
+		std::error_code ec;
+		auto size = std::filesystem::file_size(_path, ec);
+		if (ec || size == 0) {
+			_region = create(
+				_path, std::max(capacity, magic.size() + record_header_size)
+			);
+			_used = magic.size();
+		}
+		else {
+			_region = map(_path);
+			recover();
+		}
+	}
+
+	mapped_session_store(mapped_session_store&&) noexcept = default;
+	mapped_session_store& operator=(mapped_session_store&&) noexcept = default;
+
+	/**
+	 * \brief Record an entry, replacing the entry with the same
+	 * Packet Identifier in the same direction.
+	 *
+	 * \throws boost::interprocess::interprocess_exception or std::filesystem::filesystem_error
+	 * if the full journal cannot be compacted into a new file.
+	 * The Client then stops using the store, see \__is_session_store\__.
+	 */
+	void store(
+		session_entry_e kind, uint16_t packet_id,
+		std::string_view header, std::string_view payload
+	) {
+		auto offset = append(uint8_t(kind), packet_id, header, payload);
+		entries(kind)[packet_id] = offset;
+	}
+
+	/**
+	 * \brief Remove the entry with the given Packet Identifier
+	 * in the direction of the given \ref session_entry_e.
+	 *
+	 * \throws The exceptions of \ref store.
+	 */
+	void erase(session_entry_e kind, uint16_t packet_id) {
+		if (!entries(kind).erase(packet_id))
+			return;
+		auto erase_kind = kind == session_entry_e::inbound_publish ?
+			erase_inbound : erase_outbound;
+		append(erase_kind, packet_id, {}, {});
+	}
+
+	/**
+	 * \brief Retrieve the current entries in the order in which they were recorded.
+	 */
+	std::vector<session_entry> load() const {
+		std::vector<size_t> offsets;
+		offsets.reserve(_outbound.size() + _inbound.size());
+		for (const auto& [packet_id, offset] : _outbound)
+			offsets.push_back(offset);
+		for (const auto& [packet_id, offset] : _inbound)
+			offsets.push_back(offset);
+		std::sort(offsets.begin(), offsets.end());
+
+		std::vector<session_entry> entries;
+		entries.reserve(offsets.size());
+		for (auto offset : offsets) {
+			auto rec = read(offset);
+			auto header = data() + offset + record_header_size;
+			auto payload = header + rec.header_size;
+			entries.push_back({
+				session_entry_e(rec.kind), rec.packet_id,
+				std::string(header, rec.header_size),
+				std::string(payload, rec.payload_size)
+			});
+		}
+		return entries;
+	}
+
+	/**
+	 * \brief Write the journal to disk, blocking until it has been written.
+	 */
+	void flush() {
+		_region.flush(0, _used, false);
+	}
+
+private:
+	using mapped_region = boost::interprocess::mapped_region;
+
+	static mapped_region map(const std::filesystem::path& path) {
+		namespace ipc = boost::interprocess;
+		ipc::file_mapping file(path.c_str(), ipc::read_write);
+		return mapped_region(file, ipc::read_write);
+	}
+
+	static mapped_region create(
+		const std::filesystem::path& path, size_t size
+	) {
+		detail::allocate_file(path, size);
+		auto region = map(path);
+		std::memcpy(region.get_address(), magic.data(), magic.size());
+		return region;
+	}
+
+	char* data() const {
+		return static_cast<char*>(_region.get_address());
+	}
+
+	std::map<uint16_t, size_t>& entries(session_entry_e kind) {
+		return kind == session_entry_e::inbound_publish ? _inbound : _outbound;
+	}
+
+	record read(size_t offset) const {
+		auto src = data() + offset;
+		record rec;
+		rec.kind = uint8_t(src[0]);
+		std::memcpy(&rec.packet_id, src + 1, 2);
+		std::memcpy(&rec.header_size, src + 3, 4);
+		std::memcpy(&rec.payload_size, src + 7, 4);
+		return rec;
+	}
+
+	static void write(
+		char* dst, uint8_t kind, uint16_t packet_id,
+		std::string_view header, std::string_view payload
+	) {
+		auto header_size = uint32_t(header.size());
+		auto payload_size = uint32_t(payload.size());
+		std::memcpy(dst + 1, &packet_id, 2);
+		std::memcpy(dst + 3, &header_size, 4);
+		std::memcpy(dst + 7, &payload_size, 4);
+		dst += record_header_size;
+		if (!header.empty())
+			std::memcpy(dst, header.data(), header.size());
+		if (!payload.empty())
+			std::memcpy(dst + header.size(), payload.data(), payload.size());
+		// the kind is written last: a record without one ends the journal
+		std::atomic_signal_fence(std::memory_order_release);
+		*(dst - record_header_size) = char(kind);
+	}
+
+	size_t append(
+		uint8_t kind, uint16_t packet_id,
+		std::string_view header, std::string_view payload
+	) {
+		auto size = record_header_size + header.size() + payload.size();
+		if (_region.get_size() - _used < size)
+			compact(size);
+
+		auto offset = _used;
+		write(data() + offset, kind, packet_id, header, payload);
+		_used += size;
+		return offset;
+	}
+
+	// Replays the records, stopping at the first incomplete one.
+	void recover() {
+		auto size = _region.get_size();
+		if (
+			size < magic.size() ||
+			std::memcmp(data(), magic.data(), magic.size()) != 0
+		)
+			throw std::runtime_error(
+				"async_mqtt5: " + _path.string() + " is not a session journal"
+			);
+
+		size_t offset = magic.size();
+		while (size - offset >= record_header_size) {
+			auto rec = read(offset);
+			if (
+				rec.kind == 0 || rec.kind > erase_inbound ||
+				size - offset < rec.size()
+			)
+				break;
+
+			if (rec.kind == erase_outbound)
+				_outbound.erase(rec.packet_id);
+			else if (rec.kind == erase_inbound)
+				_inbound.erase(rec.packet_id);
+			else
+				entries(session_entry_e(rec.kind))[rec.packet_id] = offset;
+
+			offset += rec.size();
+		}
+		_used = offset;
+	}
+
+	// Copies the records of the current entries to a new journal
+	// with room for at least reserve more bytes.
+	void compact(size_t reserve) {
+		std::vector<size_t*> offsets;
+		offsets.reserve(_outbound.size() + _inbound.size());
+		size_t live = 0;
+		for (auto* index : { &_outbound, &_inbound })
+			for (auto& [packet_id, offset] : *index) {
+				offsets.push_back(&offset);
+				live += read(offset).size();
+			}
+		std::sort(
+			offsets.begin(), offsets.end(),
+			[](const size_t* a, const size_t* b) { return *a < *b; }
+		);
+
+		auto capacity = _region.get_size();
+		while (magic.size() + live + reserve > capacity / 2)
+			capacity *= 2;
+
+		auto tmp_path = _path;
+		tmp_path += ".tmp";
+
+		auto region = create(tmp_path, capacity);
+		auto dst = static_cast<char*>(region.get_address());
+		std::vector<size_t> new_offsets;
+		new_offsets.reserve(offsets.size());
+		size_t used = magic.size();
+		for (auto* offset : offsets) {
+			auto size = read(*offset).size();
+			// the kind is copied last, as when the record was appended
+			std::memcpy(dst + used + 1, data() + *offset + 1, size - 1);
+			std::atomic_signal_fence(std::memory_order_release);
+			dst[used] = data()[*offset];
+			new_offsets.push_back(used);
+			used += size;
+		}
+		region.flush(0, used, false);
+
+		region = mapped_region {};
+		_region = mapped_region {};
+		try {
+			std::filesystem::rename(tmp_path, _path);
+		}
+		catch (...) {
+			_region = map(_path);
+			throw;
+		}
+		_region = map(_path);
+
+		for (size_t i = 0; i < offsets.size(); ++i)
+			*offsets[i] = new_offsets[i];
+		_used = used;
+	}
+};
+
+} // end namespace async_mqtt5
+
+#endif // !ASYNC_MQTT5_MAPPED_SESSION_STORE_HPP
@@ -0,0 +1,74 @@
+#ifndef ASYNC_MQTT5_MESSAGE_VIEW_HPP
+#define ASYNC_MQTT5_MESSAGE_VIEW_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <async_mqtt5/types.hpp>
+
+namespace async_mqtt5 {
+
+/**
+ * \brief An Application Message received without copying its Topic Name
+ * and Payload out of the Client's receive buffer.
+ *
+ * \details The Topic Name and the Payload refer to the block of the receive buffer
+ * into which the \__PUBLISH\__ packet was read. The block is shared by all the messages
+ * read into it and released when the last of them is destroyed. While a message
+ * refers to a block, the Client reads into a new block instead of reusing it,
+ * so messages should be released once they have been processed.
+ *
+ * \see mqtt_client::async_receive_view
+ */
+class message_view {
+	std::shared_ptr<const std::string> _block;
+	std::string_view _topic;
+	std::string_view _payload;
+	publish_props _props;
+	// the Topic Name the Topic Alias maps to, if the packet had no Topic Name
+	std::string _aliased_topic;
+
+public:
+	/// Constructs an empty message.
+	message_view() = default;
+
+	/// Get the Topic Name.
+	std::string_view topic() const {
+		return _aliased_topic.empty() ? _topic : std::string_view(_aliased_topic);
+	}
+
+	/// Get the Payload.
+	std::string_view payload() const {
+		return _payload;
+	}
+
+	/// Get the \__PUBLISH_PROPS\__.
+	const publish_props& props() const {
+		return _props;
+	}
+
+	/// \cond internal
+
+	message_view(
+		std::shared_ptr<const std::string> block,
+		std::string_view topic, std::string_view payload, publish_props props
+	) :
+		_block(std::move(block)), _topic(topic), _payload(payload),
+		_props(std::move(props))
+	{}
+
+	publish_props& props() {
+		return _props;
+	}
+
+	void aliased_topic(std::string topic) {
+		_aliased_topic = std::move(topic);
+	}
+
+	/// \endcond
+};
+
+} // end namespace async_mqtt5
+
+#endif // !ASYNC_MQTT5_MESSAGE_VIEW_HPP
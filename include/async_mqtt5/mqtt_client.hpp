@@ -4,11 +4,16 @@
 #include <boost/system/error_code.hpp>
 
 #include <async_mqtt5/error.hpp>
+#include <async_mqtt5/message_view.hpp>
+#include <async_mqtt5/prepared_publish.hpp>
+#include <async_mqtt5/publish_payload.hpp>
 #include <async_mqtt5/types.hpp>
 
 #include <async_mqtt5/impl/client_service.hpp>
+#include <async_mqtt5/impl/publish_batch_op.hpp>
 #include <async_mqtt5/impl/publish_send_op.hpp>
 #include <async_mqtt5/impl/read_message_op.hpp>
+#include <async_mqtt5/impl/resume_session.hpp>
 #include <async_mqtt5/impl/subscribe_op.hpp>
 #include <async_mqtt5/impl/unsubscribe_op.hpp>
 #include <async_mqtt5/impl/re_auth_op.hpp>
@@ -24,10 +29,13 @@ namespace asio = boost::asio;
  * the stream of bytes between the Client and the Broker. The transport must be
  * ordered and lossless.
  * \tparam \__TlsContext\__ Type of the context object used in TLS/SSL connections.
+ * \tparam ReceiveQueue The \ref receive_queue_e in which received Application Messages
+ * wait to be received. By default, the queue can be used from any thread.
  */
 template <
 	typename StreamType,
-	typename TlsContext = std::monostate
+	typename TlsContext = std::monostate,
+	receive_queue_e ReceiveQueue = receive_queue_e::concurrent
 >
 class mqtt_client {
 public:
@@ -40,7 +48,7 @@ private:
 	static constexpr auto read_timeout = std::chrono::seconds(5);
 
 	using client_service_type = detail::client_service<
-		stream_type, tls_context_type
+		stream_type, tls_context_type, ReceiveQueue
 	>;
 	using clisvc_ptr = std::shared_ptr<client_service_type>;
 	clisvc_ptr _svc_ptr;
@@ -144,6 +152,7 @@ public:
 	 */
 	void run() {
 		_svc_ptr->run();
+		detail::resume_session(_svc_ptr);
 		detail::ping_op { _svc_ptr }
 			.perform(read_timeout - std::chrono::seconds(1));
 		detail::read_message_op { _svc_ptr }.perform();
@@ -226,6 +235,453 @@ public:
 		return *this;
 	}
 
+	/**
+	 * \brief Enable write coalescing.
+	 *
+	 * \details By default, queued packets are written as soon as the previous
+	 * write completes. With write coalescing enabled, the Client holds queued
+	 * packets until either threshold is reached or the oldest
+	 * held packet has waited for `linger`, and then writes them together.
+	 * Packets that must not be delayed, such as \__DISCONNECT\__ and \__PUBREL\__,
+	 * flush the queue immediately.
+	 *
+	 * \param linger The maximum time a packet is held before it is written.
+	 * A value of zero disables write coalescing.
+	 * \param max_bytes The number of queued bytes that triggers a write.
+	 * A value of zero sets no byte threshold.
+	 * \param max_packets The number of queued packets that triggers a write.
+	 * A value of zero sets no packet threshold. If both thresholds are zero,
+	 * packets are held for `linger` every time.
+	 *
+	 * \note No timer is armed while every queued packet is waiting for the Broker
+	 * to acknowledge earlier ones because the Receive Maximum has been reached.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 *
+	 * \see \ref write_statistics
+	 */
+	mqtt_client& write_coalescing(
+		std::chrono::microseconds linger,
+		size_t max_bytes = 64 * 1024, size_t max_packets = 64
+	) {
+		_svc_ptr->coalescing({ linger, max_bytes, max_packets });
+		return *this;
+	}
+
+	/**
+	 * \brief Assign the weights of the \ref traffic_class_e classes.
+	 *
+	 * \details Control packets are always written first. The remaining
+	 * space in each write is shared among the traffic classes with queued
+	 * \__PUBLISH\__ packets in proportion to their weights.
+	 * Limiting the size of a single write bounds the time a newly queued
+	 * packet waits behind a large backlog of another traffic class.
+	 * The default weights are 4, 2 and 1, and a single write holds
+	 * \__PUBLISH\__ packets up to 256 KiB.
+	 *
+	 * \param alarm The weight of \ref traffic_class_e::alarm.
+	 * \param telemetry The weight of \ref traffic_class_e::telemetry.
+	 * \param bulk The weight of \ref traffic_class_e::bulk.
+	 * \param max_write_bytes The number of bytes after which no more
+	 * \__PUBLISH\__ packets are added to a single write. A value of zero means no limit.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& traffic_class_weights(
+		size_t alarm, size_t telemetry, size_t bulk,
+		size_t max_write_bytes = 256 * 1024
+	) {
+		_svc_ptr->traffic_class_weights(alarm, telemetry, bulk, max_write_bytes);
+		return *this;
+	}
+
+	/**
+	 * \brief Enable automatic Topic Aliases for outbound \__PUBLISH\__ packets.
+	 *
+	 * \details With automatic Topic Aliases, the Client assigns Topic Aliases
+	 * to Topic Names on its own, up to the Topic Alias Maximum the Broker
+	 * sent in its \__CONNACK\__. The Topic Name is sent in full only
+	 * on its first use after connecting, or after its alias has been reassigned
+	 * to another Topic Name. All further packets carry an empty Topic Name
+	 * and the Topic Alias.
+	 * Once all aliases are taken, the least recently used alias is reassigned.
+	 * Topic Aliases are forgotten whenever the Client reconnects.
+	 *
+	 * While enabled, the Client overrides the Topic Alias property of published
+	 * \__PUBLISH_PROPS\__. Packets published with \ref async_publish_batch or
+	 * with a \ref prepared_publish never use automatic Topic Aliases.
+	 *
+	 * \param enable Enables automatic Topic Aliases if true.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& topic_aliasing(bool enable = true) {
+		_svc_ptr->topic_aliasing(enable);
+		return *this;
+	}
+
+	/**
+	 * \brief Assign the Topic Alias Maximum sent to the Broker in the \__CONNECT\__ packet.
+	 *
+	 * \details The Topic Alias Maximum is the highest Topic Alias the Broker
+	 * may use in the \__PUBLISH\__ packets it sends to the Client.
+	 * The Client maps received Topic Aliases to Topic Names on its own,
+	 * so that every received Application Message carries its full Topic Name.
+	 * A value of zero, the default, means the Broker cannot use Topic Aliases.
+	 *
+	 * \param topic_alias_maximum The highest Topic Alias the Broker may use.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& topic_alias_maximum(uint16_t topic_alias_maximum) {
+		_svc_ptr->topic_alias_maximum(topic_alias_maximum);
+		return *this;
+	}
+
+	/**
+	 * \brief Assign the Maximum Packet Size sent to the Broker in the \__CONNECT\__ packet.
+	 *
+	 * \details The Maximum Packet Size is the size of the largest packet the Broker
+	 * may send to the Client. If the Broker sends a larger packet, the Client
+	 * disconnects with \ref disconnect_rc_e::packet_too_large.
+	 * By default, the Maximum Packet Size is 16 MiB. A value of zero means that
+	 * no limit is imposed beyond the limits of the protocol, in which case
+	 * the Broker can make the Client allocate up to 256 MiB for a packet.
+	 * When raising it, consider a \ref payload_sink, which receives large
+	 * Payloads without reserving memory for the whole packet.
+	 *
+	 * \param size The Maximum Packet Size in bytes.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 *
+	 * \see \ref receive_buffer_size
+	 */
+	mqtt_client& maximum_packet_size(uint32_t size) {
+		_svc_ptr->maximum_packet_size(size);
+		return *this;
+	}
+
+	/**
+	 * \brief Assign the size of the buffer into which the Client reads.
+	 *
+	 * \details Packets larger than the buffer grow it to fit them.
+	 * Once no such packet has been received for `shrink_delay`, the buffer
+	 * returns to its size the next time the Client reads from the stream.
+	 * By default, the buffer holds 64 KiB and shrinks after 30 seconds.
+	 * Sizes below 4 KiB are rounded up to 4 KiB.
+	 *
+	 * \param size The size of the buffer in bytes.
+	 * \param shrink_delay The time after the last packet larger than `size`
+	 * before the buffer shrinks back.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 *
+	 * \see \ref maximum_packet_size
+	 */
+	mqtt_client& receive_buffer_size(
+		size_t size,
+		std::chrono::milliseconds shrink_delay = std::chrono::seconds(30)
+	) {
+		_svc_ptr->receive_buffer(size, shrink_delay);
+		return *this;
+	}
+
+	/**
+	 * \brief Assign a payload sink to which the payloads of large
+	 * Application Messages are streamed.
+	 *
+	 * \details The payload of a \__PUBLISH\__ packet larger than `threshold` bytes
+	 * is not assembled in memory nor received with \ref async_receive.
+	 * Instead, the sink's `begin` is called with the Topic Name, the \__PUBLISH_PROPS\__
+	 * and the payload size once the packet's header has been read, `chunk` is called
+	 * with each part of the payload as it is read from the stream, and `end` is called
+	 * after the last part. The size of the parts is bounded by the receive buffer
+	 * (see \ref receive_buffer_size).
+	 *
+	 * The packet is acknowledged once `end` has been called.
+	 * If the connection is lost or the Client is cancelled before the whole payload
+	 * has been read, `end` is called with the error code, and the Broker resends the
+	 * payload of a QoS 1 or QoS 2 Application Message after the Client reconnects.
+	 * A QoS 2 payload resent by the Broker before the exchange completes
+	 * is streamed again.
+	 * The payloads of streamed Application Messages are not recorded in the
+	 * session store (see \ref session_store).
+	 *
+	 * \param sink Object that will be stored (move-constructed or by reference)
+	 * and receive the payloads. It needs to satisfy \__is_payload_sink\__ concept.
+	 * Its functions are invoked from the Client's executor.
+	 * \param threshold The size in bytes of the largest \__PUBLISH\__ packet received
+	 * whole with \ref async_receive.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	template <detail::is_payload_sink PayloadSink>
+	mqtt_client& payload_sink(
+		PayloadSink&& sink, size_t threshold = 1024 * 1024
+	) {
+		_svc_ptr->payload_sink(std::forward<PayloadSink>(sink), threshold);
+		return *this;
+	}
+
+	/**
+	 * \brief Receive Application Messages without copying them out of the receive buffer.
+	 *
+	 * \details When enabled, Application Messages are received with \ref async_receive_view
+	 * as \ref message_view objects whose Topic Name and Payload refer to the block of the
+	 * receive buffer the \__PUBLISH\__ packet was read into, instead of being copied into
+	 * new strings. The Client reads into a new block while a received message still refers
+	 * to the current one. By default, zero-copy receiving is disabled.
+	 *
+	 * \param enable Whether to receive Application Messages with \ref async_receive_view.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& zero_copy_receive(bool enable) {
+		_svc_ptr->zero_copy_receive(enable);
+		return *this;
+	}
+
+	/**
+	 * \brief Validate the Topic Names, Topic Filters and UTF-8 Encoded String properties.
+	 *
+	 * \details When enabled, the Client checks that the Topic Names, Topic Filters and
+	 * the UTF-8 Encoded String properties of the \__PUBLISH\__, \__SUBSCRIBE\__ and \__UNSUBSCRIBE\__
+	 * packets it sends are well-formed UTF-8 without the null character U+0000,
+	 * and that Topic Names contain no wildcard characters and Topic Filters use them
+	 * correctly. Invalid requests complete with \ref client::error::invalid_topic or
+	 * \ref client::error::malformed_string without being sent.
+	 * A \__PUBLISH\__ packet received with an invalid Topic Name or property is treated
+	 * as a Malformed Packet. By default, the validation is enabled.
+	 * It can be disabled when all the strings are known to be valid.
+	 *
+	 * \param enable Whether to validate the strings.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& utf8_validation(bool enable) {
+		_svc_ptr->utf8_validation(enable);
+		return *this;
+	}
+
+	/**
+	 * \brief Limit the size of the outbound queue.
+	 *
+	 * \details Packets are queued while the Client is not connected, and while
+	 * the Broker reads them slower than they are published. By default, the queue
+	 * is not limited. With limits in place, a new \__PUBLISH\__ packet that
+	 * would exceed either limit is handled according to the \ref overflow_policy_e.
+	 * Once the limits are reached, the queue is no longer writable until it drains
+	 * to the low watermarks (see \ref async_wait_writable).
+	 *
+	 * Only new \__PUBLISH\__ packets are subject to the limits. Control packets
+	 * and \__PUBLISH\__ packets resent after reconnecting are always queued.
+	 * A packet is always queued if the queue is empty, regardless of its size.
+	 * The packets of a batch (see \ref async_publish_batch) are admitted
+	 * or rejected together, as if they were a single packet.
+	 *
+	 * \param max_bytes The maximum number of queued bytes. A value of zero means no limit.
+	 * \param max_packets The maximum number of queued packets. A value of zero means no limit.
+	 * \param policy The \ref overflow_policy_e applied to packets that exceed the limits.
+	 * \param low_bytes The number of queued bytes below which the queue becomes writable
+	 * again. A value of zero means half of `max_bytes`.
+	 * \param low_packets The number of queued packets below which the queue becomes writable
+	 * again. A value of zero means half of `max_packets`.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& write_queue_limits(
+		size_t max_bytes, size_t max_packets,
+		overflow_policy_e policy = overflow_policy_e::reject_newest,
+		size_t low_bytes = 0, size_t low_packets = 0
+	) {
+		_svc_ptr->queue_limits({
+			max_bytes, max_packets,
+			low_bytes ? low_bytes : max_bytes / 2,
+			low_packets ? low_packets : max_packets / 2,
+			policy
+		});
+		return *this;
+	}
+
+	/**
+	 * \brief Assign the time the Client waits for each kind of reply.
+	 *
+	 * \details If a \__PUBACK\__, \__PUBREC\__, \__PUBREL\__, \__PUBCOMP\__,
+	 * \__SUBACK\__ or \__UNSUBACK\__ packet is not received within its
+	 * \ref reply_timeouts, the Client sends a \__DISCONNECT\__ packet whose
+	 * Reason String names the missing reply, and reconnects.
+	 * By default, the Client waits 20 seconds for every reply.
+	 * Timeouts are measured with a monotonic clock and must be positive.
+	 *
+	 * \param timeouts The \ref reply_timeouts.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& reply_timeouts(const async_mqtt5::reply_timeouts& timeouts) {
+		_svc_ptr->reply_timeouts(timeouts);
+		return *this;
+	}
+
+	/**
+	 * \brief Spill queued \__PUBLISH\__ packets to memory-mapped files.
+	 *
+	 * \details Once more than `memory_limit` bytes are queued, for instance during
+	 * a long disconnect, new \__PUBLISH\__ packets with \ref qos_e::at_least_once
+	 * or \ref qos_e::exactly_once are moved to append-only segment files in `directory`.
+	 * Spilled packets take up no memory of their own. They are written,
+	 * and resent after reconnecting, directly from the mapped files.
+	 * A segment file is removed once every packet in it has been acknowledged.
+	 *
+	 * Packets larger than a segment, packets using automatic Topic Aliases
+	 * (see \ref topic_aliasing), and packets that cannot be spilled because
+	 * a file cannot be created or allocated on the disk are kept in memory.
+	 * Spilled packets do not survive a restart of the application.
+	 * Segment files left in `directory` by a previous run that did not remove them,
+	 * for instance because the application crashed, are removed by this function.
+	 *
+	 * \param directory An existing directory in which the segment files are created.
+	 * Every Client needs a directory of its own.
+	 * \param memory_limit The number of queued bytes after which packets are spilled.
+	 * \param segment_size The size of a segment file.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	mqtt_client& offline_spill(
+		std::string directory, size_t memory_limit,
+		size_t segment_size = 64 * 1024 * 1024
+	) {
+		_svc_ptr->offline_spill(std::move(directory), memory_limit, segment_size);
+		return *this;
+	}
+
+	/**
+	 * \brief Assign a session store that keeps the in-flight state of the Client
+	 * across restarts of the application.
+	 *
+	 * \details The session store records every outgoing \__PUBLISH\__ packet with
+	 * \ref qos_e::at_least_once or \ref qos_e::exactly_once until it is acknowledged,
+	 * every outgoing \ref qos_e::exactly_once packet awaiting its \__PUBCOMP\__,
+	 * and every incoming \ref qos_e::exactly_once packet awaiting its \__PUBREL\__.
+	 * When \ref run is invoked, the recorded packets are resent and their Packet
+	 * Identifiers are reserved, so that the exchanges started by a previous run
+	 * complete once the Client reconnects to a Broker that kept the session.
+	 * An incoming Application Message restored this way is received with
+	 * \ref async_receive once its \__PUBREL\__ arrives.
+	 * No completion handler is invoked for restored outgoing packets.
+	 *
+	 * Operations cancelled with \ref cancel, including when the Client is destroyed,
+	 * keep their state in the session store.
+	 * Outgoing packets using automatic Topic Aliases (see \ref topic_aliasing)
+	 * are recorded with the full Topic Name and without the Topic Alias.
+	 * To keep the session on the Broker across restarts, assign a non-zero
+	 * Session Expiry Interval in \__CONNECT_PROPS\__.
+	 *
+	 * If an operation of the store throws an exception, the Client stops using
+	 * the store, keeps the in-flight state in memory only, and completes a pending
+	 * \ref async_receive with \ref client::error::session_store_failed.
+	 *
+	 * \param store Object that will be stored (move-constructed or by reference)
+	 * and used to record the in-flight state. It needs to satisfy \__is_session_store\__ concept.
+	 * \ref mapped_session_store is a session store backed by a memory-mapped journal file.
+	 *
+	 * \attention This function takes action when the client is in a non-operational state,
+	 * meaning the \ref run function has not been invoked.
+	 * Furthermore, you can use this function after the \ref cancel function has been called,
+	 * before the \ref run function is invoked again.
+	 */
+	template <detail::is_session_store SessionStore>
+	mqtt_client& session_store(SessionStore&& store) {
+		_svc_ptr->session_store(std::forward<SessionStore>(store));
+		return *this;
+	}
+
+	/**
+	 * \brief Wait until the outbound queue is writable.
+	 *
+	 * \details The queue stops being writable once it reaches the limits assigned
+	 * with \ref write_queue_limits and becomes writable again once it drains to the
+	 * low watermarks. Waiting before publishing lets the publisher slow down
+	 * instead of having its messages rejected or dropped.
+	 * If the queue is not limited, the operation completes immediately.
+	 *
+	 * \param token Completion token that will be used to produce a
+	 * completion handler. The handler will be invoked when the operation completes.
+	 * On immediate completion, invocation of the handler will be performed in a manner
+	 * equivalent to using \__POST\__.
+	 *
+	 * \par Handler signature
+	 * The handler signature for this operation:
+	 *	\code
+	 *		void (
+	 *			__ERROR_CODE__	// Result of operation.
+	 *		)
+	 *	\endcode
+	 *
+	 *	\par Completion condition
+	 *	The asynchronous operation will complete when one of the following conditions is true:\n
+	 *		- The outbound queue is writable. \n
+	 *		- The Client has been cancelled. This is indicated by an associated
+	 *		\__ERROR_CODE\__ in the handler.\n
+	 *
+	 *	\par Error codes
+	 *	The list of all possible error codes that this operation can finish with:\n
+	 *		- `boost::system::errc::errc_t::success` \n
+	 *		- `boost::asio::error::operation_aborted` \n
+	 */
+	template <typename CompletionToken>
+	decltype(auto) async_wait_writable(CompletionToken&& token) {
+		return _svc_ptr->async_wait_writable(
+			std::forward<CompletionToken>(token)
+		);
+	}
+
+	/**
+	 * \brief Retrieve the \ref write_stats describing the writes
+	 * the Client has issued so far.
+	 *
+	 * \attention This function is not thread-safe and must be invoked
+	 * from the executor associated with the Client.
+	 */
+	write_stats write_statistics() const {
+		return _svc_ptr->stats();
+	}
+
 	/**
 	 * \brief Assign a list of Brokers that the Client will attempt to connect to.
 	 *
@@ -295,7 +751,8 @@ public:
 	 * \tparam qos_type The \ref qos_e level of assurance for delivery.
 	 * \param topic Identification of the information channel to which
 	 * Payload data is published.
-	 * \param payload The Application Message that is being published.
+	 * \param payload The Application Message that is being published. A \ref publish_payload
+	 * can own, borrow or share the Payload bytes, which are never copied into the packet.
 	 * \param retain The \ref retain_e flag.
 	 * \param props An instance of \__PUBLISH_PROPS\__. 
 	 * \param token Completion token that will be used to produce a
@@ -351,34 +808,207 @@ public:
 	 *		- \link async_mqtt5::client::error::qos_not_supported \endlink
 	 *		- \link async_mqtt5::client::error::retain_not_available \endlink
 	 *		- \link async_mqtt5::client::error::topic_alias_maximum_reached \endlink
+	 *		- \link async_mqtt5::client::error::queue_full \endlink
+	 *		- \link async_mqtt5::client::error::message_dropped \endlink
+	 *		- \link async_mqtt5::client::error::invalid_topic \endlink
+	 *		- \link async_mqtt5::client::error::malformed_string \endlink
 	 *
 	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
 	 */
 	template <qos_e qos_type, typename CompletionToken>
 	decltype(auto) async_publish(
-		std::string topic, std::string payload,
+		std::string topic, publish_payload payload,
+		retain_e retain, const publish_props& props,
+		CompletionToken&& token
+	) {
+		return async_publish<qos_type>(
+			std::move(topic), std::move(payload), retain, props,
+			traffic_class_e::telemetry, std::forward<CompletionToken>(token)
+		);
+	}
+
+	/**
+	 * \brief Send a \__PUBLISH\__ packet of the given \ref traffic_class_e
+	 * to Broker to transport an Application Message.
+	 *
+	 * \details This overload behaves in the same way as the overload above,
+	 * except that the packet is queued in the given \ref traffic_class_e
+	 * instead of \ref traffic_class_e::telemetry.
+	 *
+	 * \see \ref traffic_class_weights
+	 */
+	template <qos_e qos_type, typename CompletionToken>
+	decltype(auto) async_publish(
+		std::string topic, publish_payload payload,
 		retain_e retain, const publish_props& props,
+		traffic_class_e traffic_class,
 		CompletionToken&& token
 	) {
 		using Signature = detail::on_publish_signature<qos_type>;
 
 		auto initiate = [] (
-			auto handler, std::string topic, std::string payload,
+			auto handler, std::string topic, publish_payload payload,
 			retain_e retain, const publish_props& props,
-			const clisvc_ptr& svc_ptr
+			traffic_class_e traffic_class, const clisvc_ptr& svc_ptr
 		) {
 			detail::publish_send_op<
 				client_service_type, decltype(handler), qos_type
 			> { svc_ptr, std::move(handler) }
 				.perform(
 					std::move(topic), std::move(payload),
-					retain, props
+					retain, props, traffic_class
 				);
 		};
 
 		return asio::async_initiate<CompletionToken, Signature>(
 			std::move(initiate), token,
-			std::move(topic), std::move(payload), retain, props, _svc_ptr
+			std::move(topic), std::move(payload), retain, props,
+			traffic_class, _svc_ptr
+		);
+	}
+
+	/**
+	 * \brief Create a \ref prepared_publish for the given Topic Name
+	 * and \__PUBLISH_PROPS\__.
+	 *
+	 * \tparam qos_type The \ref qos_e level of assurance for delivery.
+	 * \param topic Identification of the information channel to which
+	 * Payload data is published.
+	 * \param props An instance of \__PUBLISH_PROPS\__.
+	 * \param traffic_class The \ref traffic_class_e of the published messages.
+	 *
+	 * \see \ref async_publish
+	 */
+	template <qos_e qos_type>
+	prepared_publish<qos_type> prepare_publish(
+		std::string topic, publish_props props = {},
+		traffic_class_e traffic_class = traffic_class_e::telemetry
+	) const {
+		return prepared_publish<qos_type> {
+			std::move(topic), std::move(props), traffic_class
+		};
+	}
+
+	/**
+	 * \brief Send a \__PUBLISH\__ packet created from a \ref prepared_publish
+	 * to Broker to transport an Application Message.
+	 *
+	 * \details This overload behaves in the same way as the overloads above,
+	 * except that the Topic Name, the \__PUBLISH_PROPS\__ and the \ref traffic_class_e
+	 * are taken from the \ref prepared_publish whose encoded Variable Header
+	 * is reused.
+	 *
+	 * \param prepared The \ref prepared_publish used to create the packet.
+	 * \param payload The Application Message that is being published. A \ref publish_payload
+	 * can own, borrow or share the Payload bytes, which are never copied into the packet.
+	 * \param retain The \ref retain_e flag.
+	 * \param token Completion token that will be used to produce a
+	 * completion handler. The handler will be invoked when the operation completes.
+	 */
+	template <qos_e qos_type, typename CompletionToken>
+	decltype(auto) async_publish(
+		const prepared_publish<qos_type>& prepared,
+		publish_payload payload, retain_e retain,
+		CompletionToken&& token
+	) {
+		using Signature = detail::on_publish_signature<qos_type>;
+
+		auto initiate = [] (
+			auto handler, const prepared_publish<qos_type>& prepared,
+			publish_payload payload, retain_e retain,
+			const clisvc_ptr& svc_ptr
+		) {
+			detail::publish_send_op<
+				client_service_type, decltype(handler), qos_type
+			> { svc_ptr, std::move(handler) }
+				.perform(prepared, std::move(payload), retain);
+		};
+
+		return asio::async_initiate<CompletionToken, Signature>(
+			std::move(initiate), token,
+			prepared, std::move(payload), retain, _svc_ptr
+		);
+	}
+
+	/**
+	 * \brief Send a batch of \__PUBLISH\__ packets to Broker with a single
+	 * completion.
+	 *
+	 * \details All Packet Identifiers are reserved at once and all packets
+	 * are queued for writing at once, so that they are written together.
+	 * If any message is rejected before sending, no message is sent.
+	 * This includes the limits set by \ref write_queue_limits, which admit
+	 * or reject the batch as a whole.
+	 *
+	 * \tparam qos_type The \ref qos_e level of assurance for delivery,
+	 * common to all messages in the batch.
+	 * \param messages The \ref publish_message instances that are being published.
+	 * \param token Completion token that will be used to produce a
+	 * completion handler. The handler will be invoked when the operation completes.
+	 * On immediate completion, invocation of the handler will be performed in a manner
+	 * equivalent to using \__POST\__.
+	 *
+	 * \par Handler signature
+	 * The handler signature for this operation depends on the \ref qos_e specified:\n
+	 *
+	 *	`qos` == `qos_e::at_most_once`:
+	 *		\code
+	 *			void (
+	 *				__ERROR_CODE__	// Result of operation
+	 *			)
+	 *		\endcode
+	 *
+	 *	`qos` == `qos_e::at_least_once` or `qos` == `qos_e::exactly_once`:
+	 *		\code
+	 *			void (
+	 *				__ERROR_CODE__,	// Result of operation.
+	 *				std::vector<__REASON_CODE__>	// Reason Codes received from Broker,
+	 *									// one for each message in the batch.
+	 *			)
+	 *		\endcode
+	 *
+	 *	\par Completion condition
+	 *	The asynchronous operation will complete when one of the following conditions is true:\n
+	 *		- Every message in the batch has completed as described in \ref async_publish.
+	 *		- The batch was rejected before sending. This is indicated by
+	 *		an associated \__ERROR_CODE\__ in the handler.\n
+	 *
+	 *	\par Error codes
+	 *	The first error code any message in the batch has finished with,
+	 *	or one of the error codes indicating the batch was rejected:\n
+	 *		- `boost::system::errc::errc_t::success` \n
+	 *		- `boost::asio::error::operation_aborted` \n
+	 *		- `boost::asio::error::no_recovery` \n
+	 *		- \link async_mqtt5::client::error::pid_overrun \endlink
+	 *		- \link async_mqtt5::client::error::qos_not_supported \endlink
+	 *		- \link async_mqtt5::client::error::retain_not_available \endlink
+	 *		- \link async_mqtt5::client::error::topic_alias_maximum_reached \endlink
+	 *		- \link async_mqtt5::client::error::queue_full \endlink
+	 *		- \link async_mqtt5::client::error::message_dropped \endlink
+	 *		- \link async_mqtt5::client::error::invalid_topic \endlink
+	 *		- \link async_mqtt5::client::error::malformed_string \endlink
+	 *
+	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
+	 */
+	template <qos_e qos_type, typename CompletionToken>
+	decltype(auto) async_publish_batch(
+		std::vector<publish_message> messages,
+		CompletionToken&& token
+	) {
+		using Signature = detail::on_publish_batch_signature<qos_type>;
+
+		auto initiate = [] (
+			auto handler, std::vector<publish_message> messages,
+			const clisvc_ptr& svc_ptr
+		) {
+			detail::publish_batch_op<
+				client_service_type, decltype(handler), qos_type
+			> { svc_ptr, std::move(handler) }
+				.perform(std::move(messages));
+		};
+
+		return asio::async_initiate<CompletionToken, Signature>(
+			std::move(initiate), token, std::move(messages), _svc_ptr
 		);
 	}
 
@@ -422,6 +1052,8 @@ public:
 	 *		- `boost::asio::error::no_recovery` \n
 	 *		- `boost::asio::error::operation_aborted` \n
 	 *		- \link async_mqtt5::client::error::pid_overrun \endlink
+	 *		- \link async_mqtt5::client::error::invalid_topic \endlink
+	 *		- \link async_mqtt5::client::error::malformed_string \endlink
 	 *
 	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
 	 */
@@ -488,6 +1120,8 @@ public:
 	 *		- `boost::asio::error::no_recovery` \n
 	 *		- `boost::asio::error::operation_aborted` \n
 	 *		- \link async_mqtt5::client::error::pid_overrun \endlink
+	 *		- \link async_mqtt5::client::error::invalid_topic \endlink
+	 *		- \link async_mqtt5::client::error::malformed_string \endlink
 	 *
 	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
 	 */
@@ -542,6 +1176,8 @@ public:
 	 *		- `boost::asio::error::no_recovery` \n
 	 *		- `boost::asio::error::operation_aborted` \n
 	 *		- \link async_mqtt5::client::error::pid_overrun \endlink
+	 *		- \link async_mqtt5::client::error::invalid_topic \endlink
+	 *		- \link async_mqtt5::client::error::malformed_string \endlink
 	 *
 	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
 	 */
@@ -607,6 +1243,8 @@ public:
 	 *		- `boost::asio::error::no_recovery` \n
 	 *		- `boost::asio::error::operation_aborted` \n
 	 *		- \link async_mqtt5::client::error::pid_overrun \endlink
+	 *		- \link async_mqtt5::client::error::invalid_topic \endlink
+	 *		- \link async_mqtt5::client::error::malformed_string \endlink
 	 *
 	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
 	 */
@@ -661,6 +1299,7 @@ public:
 	 *		- `boost::system::errc::errc_t::success`\n
 	 *		- `boost::asio::error::operation_aborted`\n
 	 *		- \link async_mqtt5::client::error::session_expired \endlink
+	 *		- \link async_mqtt5::client::error::session_store_failed \endlink
 	 *
 	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
 	 */
@@ -672,6 +1311,53 @@ public:
 		);
 	}
 
+	/**
+	 * \brief Asynchronously receive an Application Message without copying
+	 * its Topic Name and Payload.
+	 *
+	 * \details Behaves like \ref async_receive, except that the Application Message
+	 * is received as a \ref message_view referring to the Client's receive buffer.
+	 * Application Messages are received with this function instead of
+	 * \ref async_receive once zero-copy receiving has been enabled with
+	 * \ref zero_copy_receive.
+	 *
+	 * \param token Completion token that will be used to produce a
+	 * completion handler. The handler will be invoked when the operation completes.
+	 * On immediate completion, invocation of the handler will be performed in a manner
+	 * equivalent to using \__POST\__.
+	 *
+	 * \par Handler signature
+	 * The handler signature for this operation:
+	 *	\code
+	 *		void (
+	 *			__ERROR_CODE__, // Result of operation.
+	 *			async_mqtt5::message_view, // The Application Message.
+	 *		)
+	 *	\endcode
+	 *
+	 * \par Completion condition
+	 *	The asynchronous operation will complete when one of the following conditions is true:\n
+	 *		- The Client has a pending Application Message in its internal storage
+	 *		ready to be received.
+	 *		- An error occurred. This is indicated by an associated \__ERROR_CODE\__ in the handler.\n
+	 *
+	 *	\par Error codes
+	 *	The list of all possible error codes that this operation can finish with:\n
+	 *		- `boost::system::errc::errc_t::success`\n
+	 *		- `boost::asio::error::operation_aborted`\n
+	 *		- \link async_mqtt5::client::error::session_expired \endlink
+	 *		- \link async_mqtt5::client::error::session_store_failed \endlink
+	 *
+	 * Refer to the section on \__ERROR_HANDLING\__ to find the underlying causes for each error code.
+	 */
+	template <typename CompletionToken>
+	decltype(auto) async_receive_view(CompletionToken&& token) {
+		// Sig = void (error_code, message_view)
+		return _svc_ptr->async_channel_receive_view(
+			std::forward<CompletionToken>(token)
+		);
+	}
+
 	/**
 	 * \brief Disconnect the Client by sending a \__DISCONNECT\__ packet
 	 * with a specified Reason Code. This function has terminal effects.
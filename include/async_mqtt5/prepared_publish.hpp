@@ -0,0 +1,96 @@
+#ifndef ASYNC_MQTT5_PREPARED_PUBLISH_HPP
+#define ASYNC_MQTT5_PREPARED_PUBLISH_HPP
+
+#include <string>
+#include <string_view>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/utf8_mqtt.hpp>
+
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+namespace async_mqtt5 {
+
+/**
+ * \brief A \__PUBLISH\__ packet template with a fixed Topic Name,
+ * \__PUBLISH_PROPS\__ and \ref qos_e.
+ *
+ * \details The Topic Name and the properties are encoded once, when the object
+ * is constructed. Publishing with a prepared_publish only copies the encoded
+ * Variable Header and sets the Packet Identifier and the flags of each packet.
+ * Prepared publishes are best suited for topics that are published to very often.
+ *
+ * \tparam qos_type The \ref qos_e level of assurance for delivery.
+ *
+ * \see mqtt_client::prepare_publish
+ */
+template <qos_e qos_type>
+class prepared_publish {
+	std::string _topic;
+	publish_props _props;
+	traffic_class_e _traffic_class;
+	std::string _var_header;
+	error_code _validation;
+
+public:
+	/// The \ref qos_e of the published messages.
+	static constexpr qos_e qos_value = qos_type;
+
+	/**
+	 * \brief Constructs a prepared_publish.
+	 *
+	 * \param topic Identification of the information channel to which
+	 * Payload data is published.
+	 * \param props An instance of \__PUBLISH_PROPS\__.
+	 * \param traffic_class The \ref traffic_class_e of the published messages.
+	 */
+	explicit prepared_publish(
+		std::string topic, publish_props props = {},
+		traffic_class_e traffic_class = traffic_class_e::telemetry
+	) :
+		_topic(std::move(topic)), _props(std::move(props)),
+		_traffic_class(traffic_class),
+		_var_header(encoders::encode_publish_var_header(
+			_topic, qos_type, _props
+		)),
+		_validation(detail::validate_publish_strings(_topic, _props))
+	{}
+
+	/// Get the Topic Name.
+	const std::string& topic() const {
+		return _topic;
+	}
+
+	/// Get the \__PUBLISH_PROPS\__.
+	const publish_props& props() const {
+		return _props;
+	}
+
+	/// Get the \ref traffic_class_e.
+	traffic_class_e traffic_class() const {
+		return _traffic_class;
+	}
+
+	/// \cond internal
+
+	std::string_view var_header() const {
+		return _var_header;
+	}
+
+	size_t packet_id_offset() const {
+		// the Topic Name is encoded as a two byte length followed by the string
+		return 2 + _topic.size();
+	}
+
+	// The Topic Name and the properties are checked once, here.
+	error_code validation() const {
+		return _validation;
+	}
+
+	/// \endcond
+};
+
+} // end namespace async_mqtt5
+
+#endif // !ASYNC_MQTT5_PREPARED_PUBLISH_HPP
@@ -0,0 +1,89 @@
+#ifndef ASYNC_MQTT5_PUBLISH_PAYLOAD_HPP
+#define ASYNC_MQTT5_PUBLISH_PAYLOAD_HPP
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <boost/asio/buffer.hpp>
+
+namespace async_mqtt5 {
+
+namespace asio = boost::asio;
+
+/**
+ * \brief The Payload of a published Application Message.
+ *
+ * \details The Client writes the Payload to the transport as a buffer of its own,
+ * after the encoded header of the \__PUBLISH\__ packet, so the Payload bytes
+ * are not copied into the packet. The bytes can be:
+ *	- Owned: a `std::string` moved into the publish_payload.
+ *	- Borrowed: a `boost::asio::const_buffer` referring to memory owned by the caller,
+ *	which must stay valid until the publish operation completes.
+ *	- Shared: a `std::shared_ptr` to a contiguous container of bytes,
+ *	or to any object that owns the bytes. The Client keeps a reference
+ *	until the publish operation completes.
+ *
+ * \see mqtt_client::async_publish
+ */
+class publish_payload {
+	std::string _owned;
+	std::shared_ptr<const void> _owner;
+	asio::const_buffer _buffer;
+	bool _external { false };
+
+public:
+	/// Constructs an empty Payload.
+	publish_payload() = default;
+
+	/// Constructs a Payload that owns the given bytes.
+	publish_payload(std::string payload) :
+		_owned(std::move(payload))
+	{}
+
+	/// Constructs a Payload that owns a copy of the given string.
+	publish_payload(const char* payload) :
+		_owned(payload)
+	{}
+
+	/// Constructs a Payload that refers to bytes owned by the caller.
+	publish_payload(asio::const_buffer payload) :
+		_buffer(payload), _external(true)
+	{}
+
+	/**
+	 * \brief Constructs a Payload that shares ownership of a contiguous
+	 * container of bytes, such as `std::string` or `std::vector<char>`.
+	 */
+	template <typename Container>
+	requires requires (const Container& c) { asio::buffer(c); }
+	publish_payload(std::shared_ptr<Container> payload) :
+		_buffer(asio::buffer(std::as_const(*payload))),
+		_external(true)
+	{
+		_owner = std::move(payload);
+	}
+
+	/**
+	 * \brief Constructs a Payload that refers to the given bytes, which are kept
+	 * valid by the object owner refers to.
+	 */
+	publish_payload(std::shared_ptr<const void> owner, asio::const_buffer payload) :
+		_owner(std::move(owner)), _buffer(payload), _external(true)
+	{}
+
+	/// Get a pointer to the Payload bytes.
+	const char* data() const noexcept {
+		return _external ?
+			static_cast<const char*>(_buffer.data()) : _owned.data();
+	}
+
+	/// Get the size of the Payload in bytes.
+	size_t size() const noexcept {
+		return _external ? _buffer.size() : _owned.size();
+	}
+};
+
+} // end namespace async_mqtt5
+
+#endif // !ASYNC_MQTT5_PUBLISH_PAYLOAD_HPP
@@ -1,12 +1,14 @@
 #ifndef ASYNC_MQTT5_TYPES_HPP
 #define ASYNC_MQTT5_TYPES_HPP
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 
 #include <boost/system/error_code.hpp>
 
 #include <async_mqtt5/property_types.hpp>
+#include <async_mqtt5/publish_payload.hpp>
 
 namespace async_mqtt5 {
 
@@ -57,6 +59,80 @@ enum class retain_e : std::uint8_t {
 };
 
 
+/**
+ * \brief Represents the traffic class of an outgoing \__PUBLISH\__ packet.
+ *
+ * \details Packets of different traffic classes are queued separately
+ * and written in proportion to the weights assigned to their classes
+ * (see \ref mqtt_client::traffic_class_weights).
+ * Packets of the same traffic class are written in the order in which they were published.
+ * Control packets, such as acknowledgements and \__PINGREQ\__, always take precedence.
+ */
+enum class traffic_class_e : std::uint8_t {
+	/** Latency-sensitive messages, such as alarms. */
+	alarm = 1,
+
+	/** Regular messages. This is the default traffic class. */
+	telemetry = 2,
+
+	/** Large, latency-tolerant messages, such as bulk uploads. */
+	bulk = 3,
+};
+
+/**
+ * \brief Represents what the Client does with a \__PUBLISH\__ packet
+ * that would exceed the limits of its outbound queue.
+ *
+ * \see \ref mqtt_client::write_queue_limits
+ */
+enum class overflow_policy_e : std::uint8_t {
+	/** The new message is rejected with \ref client::error::queue_full. */
+	reject_newest = 0,
+
+	/** The oldest queued messages with \ref qos_e::at_most_once are dropped
+	 to make room for the new message. Dropped messages complete with
+	 \ref client::error::message_dropped. If there is still no room,
+	 the new message is rejected with \ref client::error::queue_full. */
+	drop_oldest_qos0,
+
+	/** The new message is held back, and its completion handler is not
+	 invoked, until the queue drains below the low watermark. */
+	block,
+};
+
+/**
+ * \brief Represents the queue in which received Application Messages wait
+ * to be received with \ref mqtt_client::async_receive or
+ * \ref mqtt_client::async_receive_view.
+ *
+ * \see \ref mqtt_client
+ */
+enum class receive_queue_e : std::uint8_t {
+	/** A channel that can be used from any thread, taking a lock on every
+	 send and receive. This is the default receive queue.
+	 It holds up to 65535 Application Messages and, when full, drops
+	 the oldest one to make room for the one being received. */
+	concurrent = 0,
+
+	/** A channel without locking. Application Messages must be received
+	 from the thread or strand on which the Client runs.
+	 It holds up to 65535 Application Messages and, when full, drops
+	 the oldest one to make room for the one being received. */
+	strand_local,
+
+	/** A lock-free ring of 4096 Application Messages, for receiving them
+	 from a thread other than the one on which the Client runs.
+	 Only one receive can be outstanding at a time.
+	 Unlike the other receive queues, which drop the oldest of 65535
+	 Application Messages, the ring drops the Application Message being
+	 received when it is full.
+	 \attention The Client acknowledges \__PUBLISH\__ packets before
+	 queueing their Application Messages, so QoS 1 and QoS 2 messages dropped
+	 by any receive queue are lost. With this queue, that happens once
+	 the consumer falls 4096 Application Messages behind. */
+	lock_free,
+};
+
 enum class dup_e : std::uint8_t {
 	yes = 0b1, no = 0b0
 };
@@ -410,6 +486,125 @@ public:
 	}
 };
 
+/**
+ * \brief Counters describing the writes the Client has issued
+ * to the underlying transport.
+ *
+ * \details The average number of packets written together is
+ * `packets / writes`.
+ */
+struct write_stats {
+	/// The number of write operations issued.
+	std::uint64_t writes = 0;
+
+	/// The number of packets written.
+	std::uint64_t packets = 0;
+
+	/// The number of bytes written.
+	std::uint64_t bytes = 0;
+
+	/// The number of writes issued because the linger time expired
+	/// before the coalescing thresholds were reached.
+	std::uint64_t linger_expirations = 0;
+
+	/// The number of messages rejected because the outbound queue was full.
+	std::uint64_t rejected = 0;
+
+	/// The number of \ref qos_e::at_most_once messages dropped
+	/// to make room in the outbound queue.
+	std::uint64_t dropped = 0;
+};
+
+/**
+ * \brief The time the Client waits for each kind of reply before it
+ * closes the connection with a \__DISCONNECT\__ naming the missing reply
+ * (see \ref mqtt_client::reply_timeouts).
+ */
+struct reply_timeouts {
+	/// The time to wait for the \__PUBACK\__ to a \__PUBLISH\__ packet.
+	std::chrono::milliseconds puback = std::chrono::seconds(20);
+
+	/// The time to wait for the \__PUBREC\__ to a \__PUBLISH\__ packet.
+	std::chrono::milliseconds pubrec = std::chrono::seconds(20);
+
+	/// The time to wait for the \__PUBREL\__ to a \__PUBREC\__ packet.
+	std::chrono::milliseconds pubrel = std::chrono::seconds(20);
+
+	/// The time to wait for the \__PUBCOMP\__ to a \__PUBREL\__ packet.
+	std::chrono::milliseconds pubcomp = std::chrono::seconds(20);
+
+	/// The time to wait for the \__SUBACK\__ to a \__SUBSCRIBE\__ packet.
+	std::chrono::milliseconds suback = std::chrono::seconds(20);
+
+	/// The time to wait for the \__UNSUBACK\__ to an \__UNSUBSCRIBE\__ packet.
+	std::chrono::milliseconds unsuback = std::chrono::seconds(20);
+};
+
+/**
+ * \brief A representation of an Application Message published
+ * as part of a batch (see \ref mqtt_client::async_publish_batch).
+ */
+struct publish_message {
+	/// The Topic Name to which the Application Message is published.
+	std::string topic;
+
+	/// The Application Message. It is moved into the \__PUBLISH\__ packet,
+	/// see \ref publish_payload for the ways to supply it without a copy.
+	publish_payload payload;
+
+	/// The \ref retain_e flag.
+	retain_e retain = retain_e::no;
+
+	/// The \__PUBLISH_PROPS\__ associated with the Application Message.
+	publish_props props;
+
+	/// The \ref traffic_class_e of the Application Message.
+	traffic_class_e traffic_class = traffic_class_e::telemetry;
+};
+
+/**
+ * \brief Represents the kind of in-flight state kept in a session store
+ * (see \ref mqtt_client::session_store).
+ */
+enum class session_entry_e : std::uint8_t {
+	/** An outgoing \__PUBLISH\__ packet with \ref qos_e::at_least_once
+	 or \ref qos_e::exactly_once that has not been acknowledged. */
+	publish = 1,
+
+	/** An outgoing \ref qos_e::exactly_once \__PUBLISH\__ packet that has
+	 been received by the Broker and awaits its \__PUBCOMP\__. It replaces
+	 the \ref session_entry_e::publish entry with the same Packet Identifier. */
+	pubrel = 2,
+
+	/** An incoming \ref qos_e::exactly_once \__PUBLISH\__ packet whose
+	 \__PUBREL\__ has not been received. */
+	inbound_publish = 3,
+};
+
+/**
+ * \brief A representation of the in-flight state of a single
+ * Packet Identifier, as kept in a session store.
+ *
+ * \details Outgoing entries (\ref session_entry_e::publish and \ref session_entry_e::pubrel)
+ * and incoming entries (\ref session_entry_e::inbound_publish) have separate
+ * Packet Identifier spaces.
+ */
+struct session_entry {
+	/// The kind of the entry.
+	session_entry_e kind = session_entry_e::publish;
+
+	/// The Packet Identifier.
+	std::uint16_t packet_id = 0;
+
+	/// The encoded Fixed Header and Variable Header of the \__PUBLISH\__ packet.
+	/// Empty for \ref session_entry_e::pubrel.
+	std::string header;
+
+	/// The Payload of the \__PUBLISH\__ packet.
+	/// Empty for \ref session_entry_e::pubrel.
+	std::string payload;
+};
+
 
 } // end namespace async_mqtt5
 
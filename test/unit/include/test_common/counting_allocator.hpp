@@ -0,0 +1,55 @@
+#ifndef ASYNC_MQTT5_TEST_COUNTING_ALLOCATOR_HPP
+#define ASYNC_MQTT5_TEST_COUNTING_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace async_mqtt5::test {
+
+// Counts the allocations and, if given a second counter,
+// the deallocations made through it.
+template <typename T>
+class counting_allocator {
+	template <typename U>
+	friend class counting_allocator;
+
+	size_t* _count;
+	size_t* _freed { nullptr };
+
+public:
+	using value_type = T;
+
+	explicit counting_allocator(size_t& count) noexcept : _count(&count) {}
+
+	counting_allocator(size_t& count, size_t& freed) noexcept :
+		_count(&count), _freed(&freed)
+	{}
+
+	template <typename U>
+	counting_allocator(const counting_allocator<U>& other) noexcept :
+		_count(other._count), _freed(other._freed)
+	{}
+
+	T* allocate(size_t n) {
+		++*_count;
+		if (void* p = std::malloc(n * sizeof(T)))
+			return static_cast<T*>(p);
+		throw std::bad_alloc {};
+	}
+
+	void deallocate(T* p, size_t) noexcept {
+		if (_freed)
+			++*_freed;
+		std::free(p);
+	}
+
+	template <typename U>
+	bool operator==(const counting_allocator<U>& other) const noexcept {
+		return _count == other._count && _freed == other._freed;
+	}
+};
+
+} // end namespace async_mqtt5::test
+
+#endif // ASYNC_MQTT5_TEST_COUNTING_ALLOCATOR_HPP
@@ -42,6 +42,14 @@ public:
 			CompletionToken, void (error_code)
 		> (std::move(initiation), token);
 	}
+
+	template <typename Allocator>
+	void send_batch(std::vector<detail::write_req, Allocator> write_reqs) {
+		for (auto& req : write_reqs)
+			asio::post(_ex, [req = std::move(req)]() mutable {
+				req.complete(error_code {});
+			});
+	}
 };
 
 
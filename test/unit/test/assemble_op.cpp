@@ -0,0 +1,209 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/asio/completion_condition.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <async_mqtt5/impl/assemble_op.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(assemble_op/*, *boost::unit_test::disabled()*/)
+
+// A service whose stream returns the queued chunks one read at a time,
+// and then end of file.
+struct burst_service {
+	using executor_type = asio::io_context::executor_type;
+
+	struct stream {
+		asio::io_context& ioc;
+		std::deque<std::string> chunks;
+		size_t reads = 0;
+
+		template <typename Handler>
+		void async_read_some(
+			asio::mutable_buffer buff, detail::duration, Handler&& handler
+		) {
+			++reads;
+			size_t num_bytes = 0;
+			if (!chunks.empty()) {
+				auto& chunk = chunks.front();
+				num_bytes = std::min(buff.size(), chunk.size());
+				std::memcpy(buff.data(), chunk.data(), num_bytes);
+				chunk.erase(0, num_bytes);
+				if (chunk.empty())
+					chunks.pop_front();
+			}
+			error_code ec = num_bytes ? error_code {} : asio::error::eof;
+			asio::post(ioc, [h = std::move(handler), ec, num_bytes]() mutable {
+				std::move(h)(ec, num_bytes);
+			});
+		}
+	};
+
+	struct replies {
+		size_t dispatched = 0;
+
+		void dispatch(
+			error_code, control_code_e, uint16_t,
+			detail::byte_citer, detail::byte_citer
+		) {
+			++dispatched;
+		}
+	};
+
+	struct sender {
+		void resend() {}
+	};
+
+	asio::io_context& ioc;
+	stream _stream { ioc };
+	detail::read_buffer _read_buff;
+	detail::payload_stream _payload_stream;
+	replies _replies;
+	sender _async_sender;
+
+	explicit burst_service(asio::io_context& ioc) : ioc(ioc) {}
+
+	executor_type get_executor() const { return ioc.get_executor(); }
+	size_t max_recv_packet_size() const { return 1024 * 1024; }
+	void update_session_state() {}
+	void reset_inbound_topic_aliases() {}
+};
+
+// Receives the packets for read_message_op the way it does.
+struct receiver {
+	burst_service& svc;
+	std::vector<uint8_t>& received;
+
+	void perform() {
+		detail::assemble_op<burst_service, receiver> {
+			svc, receiver { *this }, svc._read_buff
+		}.perform(std::chrono::seconds(20), asio::transfer_at_least(0));
+	}
+
+	void operator()(
+		error_code ec, uint8_t control_byte,
+		detail::byte_citer, detail::byte_citer
+	) {
+		for (;;) {
+			if (ec)
+				return;
+			received.push_back(control_byte);
+
+			auto packet = detail::packet_assembler { svc }.next();
+			if (!packet)
+				return perform();
+			ec = packet->ec;
+			control_byte = packet->control_byte;
+		}
+	}
+};
+
+std::string pubacks(size_t num_acks) {
+	std::string rv;
+	for (size_t i = 1; i <= num_acks; ++i)
+		rv += encoders::encode_puback(uint16_t(i), 0x00, puback_props {});
+	return rv;
+}
+
+std::string publish(const std::string& payload) {
+	return encoders::encode_publish(
+		0, "t", payload, qos_e::at_most_once, retain_e::no, dup_e::no, {}
+	);
+}
+
+BOOST_AUTO_TEST_CASE(drains_one_read) {
+	asio::io_context ioc;
+	burst_service svc(ioc);
+	svc._stream.chunks.push_back(
+		pubacks(100) + encoders::encode_pingresp() +
+		publish("p_1") + pubacks(50) + publish("p_2")
+	);
+
+	std::vector<uint8_t> received;
+	receiver { svc, received }.perform();
+	auto handlers = ioc.run();
+
+	BOOST_CHECK_EQUAL(svc._replies.dispatched, 150u);
+	BOOST_CHECK_EQUAL(received.size(), 2u);
+	// one read with the packets, and the one ending the stream
+	BOOST_CHECK_EQUAL(svc._stream.reads, 2u);
+	BOOST_CHECK_EQUAL(handlers, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(packets_split_across_reads) {
+	auto packets = pubacks(20) + publish(std::string(300, 'p')) + pubacks(20);
+
+	for (size_t split : { 1, 3, 7, 64, 311 }) {
+		asio::io_context ioc;
+		burst_service svc(ioc);
+		for (size_t pos = 0; pos < packets.size(); pos += split)
+			svc._stream.chunks.push_back(packets.substr(pos, split));
+
+		std::vector<uint8_t> received;
+		receiver { svc, received }.perform();
+		ioc.run();
+
+		BOOST_CHECK_EQUAL(svc._replies.dispatched, 40u);
+		BOOST_CHECK_EQUAL(received.size(), 1u);
+		BOOST_CHECK(svc._read_buff.size() == 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(malformed_packet_ends_the_pass) {
+	asio::io_context ioc;
+	burst_service svc(ioc);
+	// PUBACK with invalid flags
+	svc._stream.chunks.push_back(pubacks(3) + "\x41\x02\x00\x01" + pubacks(3));
+
+	error_code result;
+	detail::assemble_op {
+		svc,
+		[&result](error_code ec, uint8_t, detail::byte_citer, detail::byte_citer) {
+			result = ec;
+		},
+		svc._read_buff
+	}.perform(std::chrono::seconds(20), asio::transfer_at_least(0));
+	ioc.run();
+
+	BOOST_CHECK_EQUAL(svc._replies.dispatched, 3u);
+	BOOST_CHECK(result == client::error::malformed_packet);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_ack_bursts, *boost::unit_test::disabled()) {
+	// bursts of 2000 PUBACKs, each returned by a single read
+	constexpr size_t num_acks = 2000;
+	constexpr size_t num_bursts = 500;
+
+	asio::io_context ioc;
+	burst_service svc(ioc);
+	auto burst = pubacks(num_acks);
+	for (size_t i = 0; i < num_bursts; ++i)
+		svc._stream.chunks.push_back(burst);
+
+	std::vector<uint8_t> received;
+	receiver { svc, received }.perform();
+
+	auto start = std::chrono::steady_clock::now();
+	auto handlers = ioc.run();
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK_EQUAL(svc._replies.dispatched, num_acks * num_bursts);
+	BOOST_TEST_MESSAGE(
+		num_acks << " PUBACKs (" << burst.size() << " bytes) per read: " <<
+		double(handlers) / num_bursts << " executor handlers per read, " <<
+		std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+			(num_acks * num_bursts) << " ns per packet"
+	);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
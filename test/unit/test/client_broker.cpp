@@ -14,6 +14,13 @@
 
 using namespace async_mqtt5;
 
+// the Client sends its default Maximum Packet Size in every CONNECT
+connect_props default_connect_props() {
+	connect_props props;
+	props[prop::maximum_packet_size] = 16 * 1024 * 1024;
+	return props;
+}
+
 BOOST_AUTO_TEST_SUITE(framework, *boost::unit_test::disabled())
 
 BOOST_AUTO_TEST_CASE(publish_qos_0) {
@@ -25,7 +32,8 @@ BOOST_AUTO_TEST_CASE(publish_qos_0) {
 
 	// packets
 	auto connect = encoders::encode_connect(
-		"", std::nullopt, std::nullopt, 10, false, {}, std::nullopt
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
 	);
 	auto connack = encoders::encode_connack(
 		false, reason_codes::success.value(), {}
@@ -72,6 +80,76 @@ BOOST_AUTO_TEST_CASE(publish_qos_0) {
 }
 
 
+BOOST_AUTO_TEST_CASE(write_coalescing) {
+	using test::after;
+	using std::chrono_literals::operator ""ms;
+
+	constexpr int expected_handlers_called = 3;
+	int handlers_called = 0;
+
+	// packets
+	auto connect = encoders::encode_connect(
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
+	);
+	auto connack = encoders::encode_connack(
+		false, reason_codes::success.value(), {}
+	);
+	auto publish_1 = encoders::encode_publish(
+		0, "t", "p_1", qos_e::at_most_once, retain_e::no, dup_e::no, {}
+	);
+	auto publish_2 = encoders::encode_publish(
+		0, "t", "p_2", qos_e::at_most_once, retain_e::no, dup_e::no, {}
+	);
+	auto publish_3 = encoders::encode_publish(
+		0, "t", "p_3", qos_e::at_most_once, retain_e::no, dup_e::no, {}
+	);
+
+	test::msg_exchange broker_side;
+	error_code success {};
+
+	broker_side
+		.expect(connect)
+			.complete_with(success, after(10ms))
+			.reply_with(connack, after(20ms))
+		.expect(publish_1, publish_2, publish_3)
+			.complete_with(success, after(10ms));
+
+	asio::io_context ioc;
+	auto executor = ioc.get_executor();
+	asio::make_service<test::test_broker>(ioc, executor, std::move(broker_side));
+
+	using client_type = mqtt_client<test::test_stream>;
+	client_type c(executor, "");
+	c.brokers("127.0.0.1")
+		.write_coalescing(std::chrono::milliseconds(200), 64 * 1024, 3)
+		.run();
+
+	for (auto payload : { "p_1", "p_2", "p_3" })
+		c.async_publish<qos_e::at_most_once>(
+			"t", payload, retain_e::no, publish_props{},
+			[&](error_code ec) {
+				BOOST_CHECK_MESSAGE(!ec, ec.message());
+				++handlers_called;
+			}
+		);
+
+	asio::steady_timer timer(c.get_executor());
+	timer.expires_after(std::chrono::seconds(1));
+	timer.async_wait([&](auto) {
+		auto stats = c.write_statistics();
+		BOOST_CHECK_EQUAL(stats.writes, 1u);
+		BOOST_CHECK_EQUAL(stats.packets, 3u);
+		BOOST_CHECK_EQUAL(stats.linger_expirations, 0u);
+		c.cancel();
+	});
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(
+		handlers_called, expected_handlers_called
+	);
+}
+
 BOOST_AUTO_TEST_CASE(two_publishes_qos_1_with_fail_on_write) {
 	using test::after;
 	using std::chrono_literals::operator ""ms;
@@ -81,7 +159,8 @@ BOOST_AUTO_TEST_CASE(two_publishes_qos_1_with_fail_on_write) {
 
 	// packets
 	auto connect = encoders::encode_connect(
-		"", std::nullopt, std::nullopt, 10, false, {}, std::nullopt
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
 	);
 	auto connack = encoders::encode_connack(
 		false, reason_codes::success.value(), {}
@@ -164,7 +243,8 @@ BOOST_AUTO_TEST_CASE(receive_publish_qos_2) {
 
 	// packets
 	auto connect = encoders::encode_connect(
-		"", std::nullopt, std::nullopt, 10, false, {}, std::nullopt
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
 	);
 	auto connack = encoders::encode_connack(
 		false, reason_codes::success.value(), {}
@@ -235,7 +315,8 @@ BOOST_AUTO_TEST_CASE(send_publish_qos_2_with_fail_on_read) {
 
 	// packets
 	auto connect = encoders::encode_connect(
-		"", std::nullopt, std::nullopt, 10, false, {}, std::nullopt
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
 	);
 	auto connack = encoders::encode_connack(
 		false, reason_codes::success.value(), {}
@@ -312,7 +393,8 @@ BOOST_AUTO_TEST_CASE(test_ordering_after_reconnect) {
 
 	// packets
 	auto connect = encoders::encode_connect(
-		"", std::nullopt, std::nullopt, 10, false, {}, std::nullopt
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
 	);
 	auto connack = encoders::encode_connack(
 		false, reason_codes::success.value(), {}
@@ -409,7 +491,8 @@ BOOST_AUTO_TEST_CASE(throttling) {
 
 	//packets
 	auto connect = encoders::encode_connect(
-		"", std::nullopt, std::nullopt, 10, false, {}, std::nullopt
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
 	);
 	auto connack = encoders::encode_connack(
 		false, reason_codes::success.value(), props
@@ -513,7 +596,8 @@ BOOST_AUTO_TEST_CASE(cancel_multiple_ops) {
 
 	// packets
 	auto connect = encoders::encode_connect(
-		"", std::nullopt, std::nullopt, 10, false, {}, std::nullopt
+		"", std::nullopt, std::nullopt, 10, false,
+		default_connect_props(), std::nullopt
 	);
 	auto connack = encoders::encode_connack(
 		false, reason_codes::success.value(), {}
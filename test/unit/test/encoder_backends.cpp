@@ -0,0 +1,216 @@
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(encoder_backends/*, *boost::unit_test::disabled()*/)
+
+namespace basic = encoders::basic;
+namespace eprop = encoders::prop;
+
+struct test_messages {
+	std::string client_id = "async_mqtt_client_id";
+	std::string user_name = "username";
+	std::string password = "password";
+	std::string topic = "sensors/floor_3/room_12/temperature";
+	std::string payload = std::string(256, 'x');
+
+	connect_props cprops;
+	publish_props pprops;
+	subscribe_props sprops;
+	subscribe_options sub_opts;
+
+	test_messages() {
+		cprops[prop::session_expiry_interval] = 60;
+		cprops[prop::receive_maximum] = int16_t(100);
+		cprops[prop::user_property].emplace_back("connect user prop");
+		pprops[prop::content_type] = "application/json";
+		pprops[prop::message_expiry_interval] = 300;
+		sprops[prop::user_property].emplace_back("subscribe user prop");
+	}
+
+	template <typename Backend>
+	std::string connect(Backend&& backend) const {
+		auto packet_type_ =
+			basic::flag<4>(0b0001) |
+			basic::flag<4>(0);
+
+		auto conn_flags_ =
+			basic::flag<1>(1) |
+			basic::flag<1>(1) |
+			basic::flag<5>(0) |
+			basic::flag<1>(1) |
+			basic::flag<1>(0);
+
+		auto var_header_ =
+			basic::utf8_("MQTT") &
+			basic::byte_(uint8_t(5)) &
+			conn_flags_ &
+			basic::int16_(uint16_t(60)) &
+			eprop::props_(cprops);
+
+		auto payload_ =
+			basic::utf8_(client_id) &
+			basic::utf8_(user_name) &
+			basic::utf8_(password);
+
+		auto message_body_ = var_header_ & payload_;
+
+		auto connect_message_ =
+			packet_type_ &
+			basic::varlen_(message_body_.byte_size()) &
+			message_body_;
+
+		return backend(connect_message_);
+	}
+
+	template <typename Backend>
+	std::string publish(Backend&& backend) const {
+		auto packet_type_ =
+			basic::flag<4>(0b0011) |
+			basic::flag<1>(dup_e::no) |
+			basic::flag<2>(qos_e::at_least_once) |
+			basic::flag<1>(retain_e::no);
+
+		auto var_header_ =
+			basic::utf8_(topic) &
+			basic::int16_(uint16_t(1234)) &
+			eprop::props_(pprops);
+
+		auto publish_message_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size() + payload.size()) &
+			var_header_ &
+			basic::verbatim_(payload);
+
+		return backend(publish_message_);
+	}
+
+	template <typename Backend>
+	std::string subscribe(Backend&& backend) const {
+		auto packet_type_ =
+			basic::flag<4>(0b1000) |
+			basic::flag<4>(0b0010);
+
+		auto var_header_ =
+			basic::int16_(uint16_t(1234)) &
+			eprop::props_(sprops);
+
+		auto opts_ =
+			basic::flag<2>(sub_opts.retain_handling) |
+			basic::flag<1>(sub_opts.retain_as_published) |
+			basic::flag<1>(sub_opts.no_local) |
+			basic::flag<2>(sub_opts.max_qos);
+
+		auto payload_ = basic::utf8_(topic) & opts_;
+
+		auto subscribe_message_ =
+			packet_type_ &
+			basic::varlen_(var_header_.byte_size() + payload_.byte_size()) &
+			var_header_ &
+			payload_;
+
+		return backend(subscribe_message_);
+	}
+};
+
+constexpr auto raw_backend = [](const auto& e) {
+	return encoders::encode(e);
+};
+
+constexpr auto appending_backend = [](const auto& e) {
+	return encoders::encode_appending(e);
+};
+
+BOOST_AUTO_TEST_CASE(backends_encode_equally) {
+	test_messages msgs;
+
+	BOOST_CHECK_EQUAL(msgs.connect(raw_backend), msgs.connect(appending_backend));
+	BOOST_CHECK_EQUAL(msgs.publish(raw_backend), msgs.publish(appending_backend));
+	BOOST_CHECK_EQUAL(msgs.subscribe(raw_backend), msgs.subscribe(appending_backend));
+
+	auto subscribe = encoders::encode_subscribe(
+		1234, { { msgs.topic, msgs.sub_opts } }, msgs.sprops
+	);
+	BOOST_CHECK_EQUAL(subscribe, msgs.subscribe(appending_backend));
+}
+
+BOOST_AUTO_TEST_CASE(encode_into_span) {
+	test_messages msgs;
+	auto expected = msgs.publish(appending_backend);
+
+	std::vector<uint8_t> buffer(expected.size());
+	auto written = msgs.publish([&buffer](const auto& e) {
+		auto size = encoders::encode_into(e, std::span<uint8_t>(buffer));
+		return std::string(buffer.begin(), buffer.begin() + size);
+	});
+	BOOST_CHECK_EQUAL(written, expected);
+
+	std::vector<uint8_t> small(expected.size() - 1);
+	auto size = msgs.publish([&small](const auto& e) {
+		return std::to_string(encoders::encode_into(e, std::span<uint8_t>(small)));
+	});
+	BOOST_CHECK_EQUAL(size, "0");
+}
+
+BOOST_AUTO_TEST_CASE(long_strings) {
+	// lengths above 32767 must not be treated as negative
+	test_messages msgs;
+	msgs.topic = std::string(40000, 't');
+
+	auto raw = msgs.publish(raw_backend);
+	BOOST_CHECK_EQUAL(raw, msgs.publish(appending_backend));
+	BOOST_CHECK_EQUAL(
+		raw.size(),
+		size_t(1 + 3 + 2 + 40000 + 2) + msgs.pprops[prop::content_type]->size() +
+			2 + 1 + 1 + 4 + 1 + msgs.payload.size()
+	);
+}
+
+template <typename Encode>
+std::chrono::nanoseconds time_per_message(Encode&& encode) {
+	constexpr int num_messages = 1'000'000;
+	size_t total_size = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_messages; ++i)
+		total_size += encode().size();
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK(total_size > 0);
+	return elapsed / num_messages;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_backends, *boost::unit_test::disabled()) {
+	test_messages msgs;
+
+	auto report = [](std::string_view name, auto raw, auto appending) {
+		BOOST_TEST_MESSAGE(
+			name << ": raw " << raw.count() << " ns, appending " <<
+			appending.count() << " ns"
+		);
+	};
+
+	report(
+		"CONNECT",
+		time_per_message([&] { return msgs.connect(raw_backend); }),
+		time_per_message([&] { return msgs.connect(appending_backend); })
+	);
+	report(
+		"PUBLISH",
+		time_per_message([&] { return msgs.publish(raw_backend); }),
+		time_per_message([&] { return msgs.publish(appending_backend); })
+	);
+	report(
+		"SUBSCRIBE",
+		time_per_message([&] { return msgs.subscribe(raw_backend); }),
+		time_per_message([&] { return msgs.subscribe(appending_backend); })
+	);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
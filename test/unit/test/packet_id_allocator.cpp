@@ -0,0 +1,165 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <async_mqtt5/detail/control_packet.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(packet_id_allocator/*, *boost::unit_test::disabled()*/)
+
+BOOST_AUTO_TEST_CASE(lowest_free_pid) {
+	async_mqtt5::packet_id_allocator pid_allocator;
+
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 1);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 2);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 3);
+
+	pid_allocator.free(2);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 2);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 4);
+
+	// freeing 0 must not make it allocatable
+	pid_allocator.free(0);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(exhausted) {
+	async_mqtt5::packet_id_allocator pid_allocator;
+
+	for (uint32_t i = 1; i <= 65535; ++i)
+		BOOST_REQUIRE_EQUAL(pid_allocator.allocate(), i);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 0);
+
+	pid_allocator.free(40000);
+	pid_allocator.free(130);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 130);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 40000);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 0);
+
+	pid_allocator.free(65535);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 65535);
+}
+
+BOOST_AUTO_TEST_CASE(allocate_all_or_none) {
+	async_mqtt5::packet_id_allocator pid_allocator;
+
+	for (uint32_t i = 1; i <= 65530; ++i)
+		pid_allocator.allocate();
+
+	std::vector<uint16_t> pids(10);
+	BOOST_CHECK(!pid_allocator.allocate(pids));
+	// the partially allocated identifiers were released
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 65531);
+
+	pids.resize(4);
+	BOOST_CHECK(pid_allocator.allocate(pids));
+	BOOST_CHECK(pids == std::vector<uint16_t>({ 65532, 65533, 65534, 65535 }));
+}
+
+BOOST_AUTO_TEST_CASE(random_order_frees) {
+	async_mqtt5::packet_id_allocator pid_allocator;
+
+	std::vector<uint16_t> pids;
+	for (uint32_t i = 1; i <= 65535; ++i)
+		pids.push_back(pid_allocator.allocate());
+
+	std::mt19937 rng(42);
+	std::shuffle(pids.begin(), pids.end(), rng);
+
+	// free the first half in random order, then allocate them again
+	auto half = pids.begin() + pids.size() / 2;
+	for (auto it = pids.begin(); it != half; ++it)
+		pid_allocator.free(*it);
+
+	std::vector<uint16_t> freed(pids.begin(), half);
+	std::sort(freed.begin(), freed.end());
+	for (auto pid : freed)
+		BOOST_REQUIRE_EQUAL(pid_allocator.allocate(), pid);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_allocations) {
+	constexpr int num_threads = 4;
+	constexpr int num_rounds = 200;
+	constexpr int pids_per_round = 500;
+
+	async_mqtt5::packet_id_allocator pid_allocator;
+	std::array<std::atomic<bool>, 65536> in_use {};
+	std::atomic<int> duplicates { 0 };
+
+	// publishes are initiated from several threads while
+	// their identifiers are released in random order
+	auto allocate_and_free = [&](int seed) {
+		std::mt19937 rng(seed);
+		std::vector<uint16_t> pids;
+		for (int round = 0; round < num_rounds; ++round) {
+			for (int i = 0; i < pids_per_round; ++i) {
+				auto pid = pid_allocator.allocate();
+				if (pid == 0 || in_use[pid].exchange(true))
+					++duplicates;
+				pids.push_back(pid);
+			}
+			std::shuffle(pids.begin(), pids.end(), rng);
+			for (auto pid : pids) {
+				in_use[pid] = false;
+				pid_allocator.free(pid);
+			}
+			pids.clear();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < num_threads; ++t)
+		threads.emplace_back(allocate_and_free, t);
+	for (auto& thread : threads)
+		thread.join();
+
+	BOOST_CHECK_EQUAL(duplicates.load(), 0);
+
+	// every identifier was released
+	for (uint32_t i = 1; i <= 65535; ++i)
+		BOOST_REQUIRE_EQUAL(pid_allocator.allocate(), i);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_random_order_frees, *boost::unit_test::disabled()) {
+	constexpr int num_rounds = 100;
+	async_mqtt5::packet_id_allocator pid_allocator;
+
+	std::vector<uint16_t> pids;
+	for (uint32_t i = 1; i <= 65535; ++i)
+		pids.push_back(pid_allocator.allocate());
+
+	std::mt19937 rng(42);
+	std::chrono::nanoseconds elapsed {};
+	size_t num_ops = 0;
+
+	for (int round = 0; round < num_rounds; ++round) {
+		// acks for half of the 65535 in-flight publishes arrive
+		// in random order before their identifiers are reused
+		std::shuffle(pids.begin(), pids.end(), rng);
+		auto half = pids.begin() + pids.size() / 2;
+
+		auto start = std::chrono::steady_clock::now();
+		for (auto it = pids.begin(); it != half; ++it)
+			pid_allocator.free(*it);
+		for (auto it = pids.begin(); it != half; ++it)
+			*it = pid_allocator.allocate();
+		elapsed += std::chrono::steady_clock::now() - start;
+		num_ops += half - pids.begin();
+	}
+
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 0);
+	BOOST_TEST_MESSAGE(
+		"free + allocate: " << (elapsed / num_ops).count() << " ns"
+	);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
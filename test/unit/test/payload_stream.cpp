@@ -0,0 +1,215 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/asio/error.hpp>
+
+#include <async_mqtt5/detail/payload_stream.hpp>
+#include <async_mqtt5/detail/read_buffer.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(payload_stream/*, *boost::unit_test::disabled()*/)
+
+struct recording_sink {
+	struct record {
+		std::string topic;
+		size_t payload_size = 0;
+		std::string payload;
+		size_t num_chunks = 0;
+		error_code ec;
+		bool ended = false;
+	};
+	std::vector<record>& records;
+
+	void begin(std::string_view topic, const publish_props&, size_t payload_size) {
+		records.push_back({ std::string(topic), payload_size });
+	}
+	void chunk(std::string_view data) {
+		records.back().payload += data;
+		++records.back().num_chunks;
+	}
+	void end(error_code ec) {
+		records.back().ec = ec;
+		records.back().ended = true;
+	}
+};
+
+std::string publish(size_t payload_size, qos_e qos, publish_props props = {}) {
+	return encoders::encode_publish(
+		qos == qos_e::at_most_once ? 0 : 42, "sensors/1",
+		std::string(payload_size, 'x'), qos, retain_e::no, dup_e::no, props
+	);
+}
+
+// Splits the stream into packets the way assemble_op does, streaming
+// the payloads of large PUBLISH packets.
+void receive(
+	detail::read_buffer& buff, detail::payload_stream& stream,
+	const std::string& data, size_t max_read
+) {
+	size_t pos = 0;
+	for (;;) {
+		for (;;) {
+			if (stream.active()) {
+				buff.consume(stream.consume(buff.begin(), buff.end()));
+				if (!stream.finished())
+					break;
+				stream.finish();
+				continue;
+			}
+
+			if (buff.size() < 2)
+				break;
+			auto control_byte = uint8_t(*buff.begin());
+			auto first = buff.begin() + 1;
+			auto varlen = decoders::type_parse(
+				first, buff.end(), decoders::basic::varint_
+			);
+			if (!varlen)
+				break;
+
+			size_t header_size = std::distance(buff.begin(), first);
+			if (stream.streams(header_size + *varlen)) {
+				auto var_header_size = detail::payload_stream::variable_header_size(
+					control_byte, first, buff.end()
+				);
+				if (!var_header_size)
+					break;
+				auto msg = decoders::decode_publish(
+					control_byte, *var_header_size, first
+				);
+				BOOST_REQUIRE(msg);
+				buff.consume(header_size + *var_header_size);
+				stream.start(*varlen - *var_header_size);
+				stream.begin(std::move(*msg));
+				continue;
+			}
+
+			if (std::distance(first, buff.end()) < *varlen) {
+				buff.make_room(header_size + *varlen);
+				break;
+			}
+			buff.consume(header_size + *varlen);
+		}
+
+		if (pos == data.size())
+			return;
+
+		auto store = buff.prepare();
+		auto num_bytes = std::min({ store.size(), max_read, data.size() - pos });
+		std::memcpy(store.data(), data.data() + pos, num_bytes);
+		buff.commit(num_bytes);
+		pos += num_bytes;
+	}
+}
+
+BOOST_AUTO_TEST_CASE(variable_header_size) {
+	publish_props props;
+	props[prop::content_type] = "application/octet-stream";
+
+	for (auto qos : { qos_e::at_most_once, qos_e::at_least_once }) {
+		auto packet = publish(1000, qos, props);
+		auto control_byte = uint8_t(packet[0]);
+		detail::byte_citer first = packet.cbegin() + 1;
+		auto varlen = decoders::type_parse(
+			first, packet.cend(), decoders::basic::varint_
+		);
+		BOOST_REQUIRE(varlen);
+
+		auto size = detail::payload_stream::variable_header_size(
+			control_byte, first, packet.cend()
+		);
+		BOOST_REQUIRE(size);
+		BOOST_CHECK_EQUAL(*varlen - *size, 1000u);
+
+		// the whole variable header must be available
+		for (size_t available = 0; available < *size; ++available)
+			BOOST_CHECK(!detail::payload_stream::variable_header_size(
+				control_byte, first, first + available
+			));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(chunks_and_abort) {
+	std::vector<recording_sink::record> records;
+	detail::payload_stream stream;
+	stream.configure(recording_sink { records }, 100);
+	BOOST_CHECK(!stream.streams(100));
+	BOOST_CHECK(stream.streams(101));
+
+	std::string payload = "0123456789";
+	stream.start(payload.size());
+	BOOST_CHECK(stream.starting());
+	stream.begin({ "topic", 42, 0b0010, publish_props {}, std::string {} });
+	BOOST_CHECK(!stream.starting());
+
+	std::string more = payload + "next packet";
+	BOOST_CHECK_EQUAL(stream.consume(more.cbegin(), more.cbegin() + 4), 4u);
+	BOOST_CHECK(!stream.finished());
+	BOOST_CHECK_EQUAL(stream.consume(more.cbegin() + 4, more.cend()), 6u);
+	BOOST_CHECK(stream.finished());
+
+	auto msg = stream.finish();
+	BOOST_REQUIRE(msg);
+	BOOST_CHECK_EQUAL(*std::get<1>(*msg), 42);
+	BOOST_CHECK(!stream.active());
+
+	// a stream aborted before the sink was told about it is discarded
+	stream.start(payload.size());
+	stream.consume(payload.cbegin(), payload.cend());
+	BOOST_CHECK(!stream.finish());
+
+	stream.start(payload.size());
+	stream.begin({ "topic", std::nullopt, 0, publish_props {}, std::string {} });
+	stream.consume(payload.cbegin(), payload.cbegin() + 3);
+	stream.abort(asio::error::connection_aborted);
+	stream.abort(asio::error::operation_aborted);
+	BOOST_CHECK(!stream.active());
+
+	BOOST_REQUIRE_EQUAL(records.size(), 2u);
+	BOOST_CHECK_EQUAL(records[0].payload, payload);
+	BOOST_CHECK_EQUAL(records[0].num_chunks, 2u);
+	BOOST_CHECK(records[0].ended && !records[0].ec);
+	BOOST_CHECK_EQUAL(records[1].payload, "012");
+	BOOST_CHECK(records[1].ec == asio::error::connection_aborted);
+}
+
+BOOST_AUTO_TEST_CASE(large_payloads_in_small_buffer) {
+	std::vector<std::string> packets {
+		publish(10, qos_e::at_most_once),
+		publish(16 * 1024 * 1024, qos_e::at_least_once),
+		publish(10, qos_e::at_least_once),
+		publish(1024 * 1024, qos_e::exactly_once),
+		publish(10, qos_e::at_most_once)
+	};
+
+	std::string data;
+	for (const auto& packet : packets)
+		data += packet;
+
+	std::vector<recording_sink::record> records;
+	detail::payload_stream stream;
+	stream.configure(recording_sink { records }, 65536);
+
+	for (size_t max_read : { 1000, 65536 }) {
+		records.clear();
+		detail::read_buffer buff;
+		receive(buff, stream, data, max_read);
+
+		BOOST_REQUIRE_EQUAL(records.size(), 2u);
+		BOOST_CHECK_EQUAL(records[0].payload_size, 16u * 1024 * 1024);
+		BOOST_CHECK(records[0].payload == std::string(16 * 1024 * 1024, 'x'));
+		BOOST_CHECK_EQUAL(records[1].payload.size(), 1024u * 1024);
+		BOOST_CHECK(records[1].ended);
+		BOOST_CHECK_EQUAL(buff.size(), 0u);
+		// the payloads never had to fit into the buffer
+		BOOST_CHECK_EQUAL(buff.storage_size(), buff.capacity());
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/control_packet.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+#include "test_common/counting_allocator.hpp"
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(pooled_packets/*, *boost::unit_test::disabled()*/)
+
+using allocator_type = test::counting_allocator<char>;
+using packet_type = control_packet<allocator_type>;
+
+std::string wire_bytes(const packet_type& packet) {
+	std::string bytes;
+	for (const auto& buffer : packet.wire_data())
+		bytes.append(static_cast<const char*>(buffer.data()), buffer.size());
+	return bytes;
+}
+
+BOOST_AUTO_TEST_CASE(fixed_packets_encode_as_encoders) {
+	size_t count = 0;
+	allocator_type alloc(count);
+	uint16_t packet_id = 0xABCD;
+
+	auto pingreq = packet_type::of(fixed, alloc, fixed_packets::pingreq);
+	BOOST_CHECK_EQUAL(wire_bytes(pingreq), encoders::encode_pingreq());
+	BOOST_CHECK(pingreq.control_code() == control_code_e::pingreq);
+
+	auto puback = packet_type::of(fixed, alloc, control_code_e::puback, packet_id);
+	BOOST_CHECK_EQUAL(
+		wire_bytes(puback), encoders::encode_puback(packet_id, 0, puback_props {})
+	);
+	BOOST_CHECK_EQUAL(puback.packet_id(), packet_id);
+	BOOST_CHECK(puback.control_code() == control_code_e::puback);
+
+	auto pubrec = packet_type::of(fixed, alloc, control_code_e::pubrec, packet_id);
+	BOOST_CHECK_EQUAL(
+		wire_bytes(pubrec), encoders::encode_pubrec(packet_id, 0, pubrec_props {})
+	);
+
+	auto pubrel = packet_type::of(fixed, alloc, control_code_e::pubrel, packet_id);
+	BOOST_CHECK_EQUAL(
+		wire_bytes(pubrel), encoders::encode_pubrel(packet_id, 0, pubrel_props {})
+	);
+
+	auto pubcomp = packet_type::of(fixed, alloc, control_code_e::pubcomp, packet_id);
+	BOOST_CHECK_EQUAL(
+		wire_bytes(pubcomp), encoders::encode_pubcomp(packet_id, 0, pubcomp_props {})
+	);
+
+	auto disconnect = packet_type::of(fixed, alloc, uint8_t(0x04));
+	BOOST_CHECK_EQUAL(
+		wire_bytes(disconnect), encoders::encode_disconnect(0x04, disconnect_props {})
+	);
+
+	BOOST_CHECK_EQUAL(count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(exhausted_pool_allocates) {
+	size_t count = 0;
+	allocator_type alloc(count);
+	auto& pool = fixed_packet_pool::instance();
+	const auto available = pool.available();
+
+	std::vector<packet_type> packets;
+	for (int i = 0; i < available; ++i)
+		packets.push_back(
+			packet_type::of(fixed, alloc, control_code_e::puback, uint16_t(i + 1))
+		);
+	BOOST_CHECK_EQUAL(pool.available(), 0);
+	BOOST_CHECK_EQUAL(count, 0u);
+
+	auto allocated = packet_type::of(fixed, alloc, control_code_e::puback, 1000);
+	BOOST_CHECK_GT(count, 0u);
+	BOOST_CHECK_EQUAL(
+		wire_bytes(allocated), encoders::encode_puback(1000, 0, puback_props {})
+	);
+
+	// moved-from packets do not release their slots
+	auto moved = std::move(packets.back());
+	packets.pop_back();
+	BOOST_CHECK_EQUAL(pool.available(), 0);
+	BOOST_CHECK_EQUAL(moved.packet_id(), uint16_t(available));
+
+	packets.clear();
+	BOOST_CHECK_EQUAL(pool.available(), available - 1);
+}
+
+BOOST_AUTO_TEST_CASE(ack_flood_allocation_free) {
+	constexpr int num_acks = 100'000;
+	size_t count = 0;
+	allocator_type alloc(count);
+
+	// a window of in-flight acknowledgements
+	std::vector<packet_type> in_flight;
+	in_flight.reserve(16);
+
+	for (int i = 0; i < num_acks; ++i) {
+		if (in_flight.size() == 16)
+			in_flight.clear();
+		in_flight.push_back(packet_type::of(
+			fixed, alloc, control_code_e::puback, uint16_t(i % 65535 + 1)
+		));
+	}
+
+	BOOST_CHECK_EQUAL(count, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
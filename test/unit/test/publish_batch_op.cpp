@@ -0,0 +1,206 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <async_mqtt5/error.hpp>
+
+#include <async_mqtt5/impl/client_service.hpp>
+#include <async_mqtt5/impl/publish_batch_op.hpp>
+
+#include "test_common/test_service.hpp"
+
+using namespace async_mqtt5;
+
+namespace async_mqtt5::client {
+
+inline std::ostream& operator<<(std::ostream& os, const error& err) {
+	os << client_error_to_string(err);
+	return os;
+}
+
+} // end namespace async_mqtt5::client
+
+
+BOOST_AUTO_TEST_SUITE(publish_batch_op/*, *boost::unit_test::disabled()*/)
+
+template <
+	typename StreamType,
+	typename TlsContext = std::monostate
+>
+class overrun_client : public detail::client_service<StreamType, TlsContext> {
+public:
+	overrun_client(const asio::any_io_executor& ex, const std::string& cnf) :
+		detail::client_service<StreamType, TlsContext>(ex, cnf)
+	{}
+
+	bool allocate_pids(std::span<uint16_t>) {
+		return false;
+	}
+};
+
+std::vector<publish_message> make_batch(size_t num_messages) {
+	std::vector<publish_message> messages;
+	for (size_t i = 0; i < num_messages; ++i)
+		messages.push_back({ "test", "payload " + std::to_string(i) });
+	return messages;
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_pid_overrun) {
+	constexpr int expected_handlers_called = 1;
+	int handlers_called = 0;
+
+	asio::io_context ioc;
+	using client_service_type = overrun_client<asio::ip::tcp::socket>;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor(), "");
+
+	auto handler = [&](error_code ec, std::vector<reason_code> rcs) {
+		++handlers_called;
+		BOOST_CHECK_EQUAL(ec, client::error::pid_overrun);
+		BOOST_CHECK(rcs.empty());
+	};
+
+	detail::publish_batch_op<
+		client_service_type, decltype(handler), qos_e::at_least_once
+	> { svc_ptr, std::move(handler) }
+		.perform(make_batch(10));
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(
+		handlers_called, expected_handlers_called
+	);
+}
+
+BOOST_AUTO_TEST_CASE(test_empty_batch) {
+	constexpr int expected_handlers_called = 1;
+	int handlers_called = 0;
+
+	asio::io_context ioc;
+	using client_service_type = test::test_service<asio::ip::tcp::socket>;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+
+	auto handler = [&](error_code ec, std::vector<reason_code> rcs) {
+		++handlers_called;
+		BOOST_CHECK(!ec);
+		BOOST_CHECK(rcs.empty());
+	};
+
+	detail::publish_batch_op<
+		client_service_type, decltype(handler), qos_e::exactly_once
+	> { svc_ptr, std::move(handler) }
+		.perform({});
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(
+		handlers_called, expected_handlers_called
+	);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_single_completion) {
+	constexpr int expected_handlers_called = 1;
+	int handlers_called = 0;
+
+	asio::io_context ioc;
+	using client_service_type = test::test_service<asio::ip::tcp::socket>;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+
+	auto handler = [&](error_code ec) {
+		++handlers_called;
+		BOOST_CHECK(!ec);
+	};
+
+	detail::publish_batch_op<
+		client_service_type, decltype(handler), qos_e::at_most_once
+	> { svc_ptr, std::move(handler) }
+		.perform(make_batch(100));
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(
+		handlers_called, expected_handlers_called
+	);
+}
+
+// Records where the Payload of each queued packet is written from.
+class payload_recording_service :
+	public test::test_service<asio::ip::tcp::socket>
+{
+public:
+	using test::test_service<asio::ip::tcp::socket>::test_service;
+
+	std::vector<const void*> payloads;
+
+	template <typename Allocator>
+	void send_batch(std::vector<detail::write_req, Allocator> write_reqs) {
+		for (const auto& req : write_reqs)
+			payloads.push_back(req.buffers()[1].data());
+		test_service::send_batch(std::move(write_reqs));
+	}
+};
+
+BOOST_AUTO_TEST_CASE(test_batch_payload_not_copied) {
+	asio::io_context ioc;
+	using client_service_type = payload_recording_service;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+
+	auto shared = std::make_shared<std::string>(1024, 'x');
+	std::vector<publish_message> messages;
+	messages.push_back({ "test", publish_payload(shared) });
+	messages.push_back({ "test", publish_payload(asio::buffer(*shared)) });
+
+	int handlers_called = 0;
+	auto handler = [&](error_code ec) {
+		++handlers_called;
+		BOOST_CHECK(!ec);
+	};
+
+	detail::publish_batch_op<
+		client_service_type, decltype(handler), qos_e::at_most_once
+	> { svc_ptr, std::move(handler) }
+		.perform(std::move(messages));
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(handlers_called, 1);
+	BOOST_REQUIRE_EQUAL(svc_ptr->payloads.size(), 2u);
+	BOOST_CHECK(svc_ptr->payloads[0] == shared->data());
+	BOOST_CHECK(svc_ptr->payloads[1] == shared->data());
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_cancellation) {
+	constexpr int expected_handlers_called = 1;
+	int handlers_called = 0;
+
+	asio::io_context ioc;
+	using client_service_type = test::test_service<asio::ip::tcp::socket>;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+	asio::cancellation_signal cancel_signal;
+
+	auto h = [&](error_code ec, std::vector<reason_code> rcs) {
+		++handlers_called;
+		BOOST_CHECK_EQUAL(ec, asio::error::operation_aborted);
+		BOOST_CHECK(rcs.empty());
+	};
+
+	auto handler = asio::bind_cancellation_slot(cancel_signal.slot(), std::move(h));
+
+	asio::steady_timer timer(ioc.get_executor());
+	timer.expires_after(std::chrono::milliseconds(60));
+	timer.async_wait(
+		[&cancel_signal](error_code) {
+			cancel_signal.emit(asio::cancellation_type::terminal);
+		}
+	);
+
+	detail::publish_batch_op<
+		client_service_type, decltype(handler), qos_e::at_least_once
+	> { svc_ptr, std::move(handler) }
+		.perform(make_batch(10));
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(
+		handlers_called, expected_handlers_called
+	);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,14 @@
 #include <boost/test/unit_test.hpp>
 
+#include <cstdlib>
+#include <new>
+
+#include <boost/asio/bind_allocator.hpp>
 #include <boost/asio/bind_cancellation_slot.hpp>
 #include <boost/asio/cancellation_signal.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/prepend.hpp>
 #include <boost/asio/steady_timer.hpp>
 
 #include <async_mqtt5/error.hpp>
@@ -10,7 +16,9 @@
 #include <async_mqtt5/impl/client_service.hpp>
 #include <async_mqtt5/impl/publish_send_op.hpp>
 
+#include "test_common/counting_allocator.hpp"
 #include "test_common/test_service.hpp"
+#include "test_common/test_stream.hpp"
 
 using namespace async_mqtt5;
 
@@ -23,6 +31,42 @@ inline std::ostream& operator<<(std::ostream& os, const error& err) {
 
 } // end namespace async_mqtt5::client
 
+namespace {
+
+thread_local size_t* global_bytes_counted = nullptr;
+
+// Counts the bytes this thread allocates with the global operator new
+// while the counter is alive.
+class global_allocation_counter {
+public:
+	explicit global_allocation_counter(size_t& bytes) {
+		global_bytes_counted = &bytes;
+	}
+
+	global_allocation_counter(const global_allocation_counter&) = delete;
+
+	~global_allocation_counter() {
+		global_bytes_counted = nullptr;
+	}
+};
+
+} // end anonymous namespace
+
+void* operator new(std::size_t size) {
+	if (global_bytes_counted)
+		*global_bytes_counted += size;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc {};
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
 
 BOOST_AUTO_TEST_SUITE(publish_send_op/*, *boost::unit_test::disabled()*/)
 
@@ -137,4 +181,108 @@ BOOST_AUTO_TEST_CASE(test_publish_cancellation) {
 	);
 }
 
+// Completes every write at once, as a connected socket with room
+// in its send buffer would, without a Broker on the other end.
+class sink_stream : public test::test_stream {
+	bool _open { false };
+
+public:
+	using test_stream::test_stream;
+
+	void open(const protocol_type&, error_code& ec) {
+		_open = true;
+		ec = {};
+	}
+
+	void close(error_code& ec) {
+		_open = false;
+		ec = {};
+	}
+
+	bool is_open() const {
+		return _open;
+	}
+
+	endpoint_type remote_endpoint(error_code& ec) {
+		ec = {};
+		return { asio::ip::address_v4::loopback(), 1883 };
+	}
+
+	template <typename ConstBufferSequence, typename WriteToken>
+	decltype(auto) async_write_some(
+		const ConstBufferSequence& buffers, WriteToken&& token
+	) {
+		auto initiation = [this](auto handler, size_t bytes) {
+			asio::post(
+				get_executor(),
+				asio::prepend(std::move(handler), error_code {}, bytes)
+			);
+		};
+
+		return asio::async_initiate<WriteToken, void (error_code, size_t)>(
+			std::move(initiation), token, asio::buffer_size(buffers)
+		);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(test_qos0_publish_allocations) {
+	constexpr int num_publishes = 100;
+	int handlers_called = 0;
+	size_t allocations = 0, deallocations = 0;
+
+	asio::io_context ioc;
+	// the publishes go through the Client's async_sender to the stream
+	using client_service_type = detail::client_service<sink_stream>;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor(), "");
+	svc_ptr->open_stream();
+
+	// long enough not to fit into the small string buffer
+	const std::string topic = "async-mqtt5/test/allocations/qos0/topic";
+	const std::string payload(64 * 1024, 'x');
+
+	auto publish = [&](std::string topic, std::string payload) {
+		auto handler = asio::bind_allocator(
+			test::counting_allocator<void>(allocations, deallocations),
+			[&handlers_called](error_code ec) {
+				++handlers_called;
+				BOOST_CHECK(!ec);
+			}
+		);
+
+		detail::publish_send_op<
+			client_service_type, decltype(handler), qos_e::at_most_once
+		> { svc_ptr, std::move(handler) }
+			.perform(std::move(topic), std::move(payload), retain_e::no, {});
+
+		ioc.restart();
+		ioc.run();
+	};
+
+	// warm up the queues of the sender and the caches of the io_context
+	publish(topic, payload);
+
+	std::vector<std::pair<std::string, std::string>> messages(
+		num_publishes, { topic, payload }
+	);
+	allocations = deallocations = 0;
+
+	size_t global_bytes = 0;
+	{
+		global_allocation_counter counter(global_bytes);
+		for (auto& [t, p] : messages)
+			publish(std::move(t), std::move(p));
+	}
+
+	BOOST_CHECK_EQUAL(handlers_called, num_publishes + 1);
+	// the handler's allocator governs the op state, the packet and
+	// the queued write request, and gets back all it allocated
+	BOOST_CHECK_GE(allocations, size_t(2 * num_publishes));
+	BOOST_CHECK_EQUAL(deallocations, allocations);
+	// the payloads are written from where they were moved to; the sender
+	// and the io_context allocate small blocks their caches cannot hold
+	BOOST_CHECK_LT(global_bytes, num_publishes * payload.size() / 8);
+
+	svc_ptr->cancel();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,252 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include <async_mqtt5/detail/read_buffer.hpp>
+#include <async_mqtt5/impl/internal/codecs/base_decoders.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(read_buffer/*, *boost::unit_test::disabled()*/)
+
+// The scheme read_buffer replaced: the consumed prefix is erased and
+// the storage is resized back to its capacity after every packet.
+struct erase_resize_buffer {
+	std::string buff;
+	size_t first = 0, last = 0;
+
+	detail::byte_citer begin() const { return buff.cbegin() + first; }
+	detail::byte_citer end() const { return buff.cbegin() + last; }
+	size_t size() const { return last - first; }
+
+	asio::mutable_buffer prepare() {
+		compact();
+		return asio::buffer(buff.data() + last, buff.size() - last);
+	}
+	void commit(size_t num_bytes) { last += num_bytes; }
+	void consume(size_t num_bytes) { first += num_bytes; compact(); }
+	void make_room(size_t) {}
+
+	void compact() {
+		buff.erase(0, first);
+		buff.resize(65536);
+		last -= first;
+		first = 0;
+	}
+};
+
+// Splits the stream into packets the way assemble_op does,
+// reading at most max_read bytes at a time.
+template <typename Buffer, typename OnPacket>
+void receive(
+	Buffer& buff, const std::string& stream, size_t max_read,
+	OnPacket&& on_packet
+) {
+	size_t pos = 0;
+	for (;;) {
+		while (buff.size() > 1) {
+			auto first = buff.begin() + 1;
+			auto varlen = decoders::type_parse(
+				first, buff.end(), decoders::basic::varint_
+			);
+			if (!varlen)
+				break;
+
+			size_t header_size = std::distance(buff.begin(), first);
+			if (std::distance(first, buff.end()) < *varlen) {
+				buff.make_room(header_size + *varlen);
+				break;
+			}
+			on_packet(buff.begin(), first + *varlen);
+			buff.consume(header_size + *varlen);
+		}
+
+		if (pos == stream.size())
+			return;
+
+		auto store = buff.prepare();
+		auto num_bytes = std::min({ store.size(), max_read, stream.size() - pos });
+		std::memcpy(store.data(), stream.data() + pos, num_bytes);
+		buff.commit(num_bytes);
+		pos += num_bytes;
+	}
+}
+
+std::string qos0_publish(size_t payload_size) {
+	return encoders::encode_publish(
+		0, "sensors/1", std::string(payload_size, 'x'),
+		qos_e::at_most_once, retain_e::no, dup_e::no, publish_props {}
+	);
+}
+
+BOOST_AUTO_TEST_CASE(packets_across_reads) {
+	std::vector<std::string> packets;
+	for (size_t payload_size : { 0, 5, 127, 128, 3000, 16383, 16384, 60000, 1 })
+		packets.push_back(qos0_publish(payload_size));
+
+	std::string stream;
+	for (const auto& packet : packets)
+		stream += packet;
+
+	for (size_t max_read : { 1, 7, 1000, 4096, 65536 }) {
+		detail::read_buffer buff;
+		std::vector<std::string> received;
+		receive(buff, stream, max_read, [&](auto first, auto last) {
+			received.emplace_back(first, last);
+		});
+		BOOST_CHECK(received == packets);
+		BOOST_CHECK_EQUAL(buff.size(), 0u);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(rewind_without_moving) {
+	detail::read_buffer buff(8192);
+
+	auto store = buff.prepare();
+	BOOST_CHECK_EQUAL(store.size(), 8192u);
+	auto storage = static_cast<char*>(store.data());
+
+	// consuming everything rewinds the buffer
+	buff.commit(100);
+	buff.consume(100);
+	BOOST_CHECK(buff.prepare().data() == storage);
+
+	// unconsumed bytes stay in place while there is room after them
+	std::memcpy(storage, "abcdef", 6);
+	buff.commit(6);
+	buff.consume(2);
+	BOOST_CHECK(buff.prepare().data() == storage + 6);
+	BOOST_CHECK_EQUAL(std::string(buff.begin(), buff.end()), "cdef");
+
+	// and are moved to the front when a packet would not fit
+	buff.make_room(8191);
+	BOOST_CHECK_EQUAL(std::string(buff.begin(), buff.end()), "cdef");
+	BOOST_CHECK(buff.prepare().data() == storage + 4);
+}
+
+BOOST_AUTO_TEST_CASE(large_packets) {
+	std::vector<std::string> packets {
+		qos0_publish(10), qos0_publish(1024 * 1024),
+		qos0_publish(10), qos0_publish(16 * 1024 * 1024), qos0_publish(10)
+	};
+
+	std::string stream;
+	for (const auto& packet : packets)
+		stream += packet;
+
+	detail::read_buffer buff;
+	std::vector<std::string> received;
+	receive(buff, stream, 65536, [&](auto first, auto last) {
+		received.emplace_back(first, last);
+	});
+	BOOST_CHECK(received == packets);
+	BOOST_CHECK_EQUAL(buff.capacity(), 65536u);
+	BOOST_CHECK(buff.storage_size() >= packets[3].size());
+}
+
+BOOST_AUTO_TEST_CASE(shrink_after_delay) {
+	auto large = qos0_publish(1024 * 1024);
+	auto small = qos0_publish(10);
+	auto on_packet = [](auto, auto) {};
+
+	detail::read_buffer kept(65536, std::chrono::hours(1));
+	receive(kept, large, 65536, on_packet);
+	receive(kept, small, 65536, on_packet);
+	BOOST_CHECK(kept.storage_size() >= large.size());
+
+	detail::read_buffer shrunk(65536, std::chrono::milliseconds(0));
+	receive(shrunk, large, 65536, on_packet);
+	BOOST_CHECK(shrunk.storage_size() >= large.size());
+	receive(shrunk, small, 65536, on_packet);
+	BOOST_CHECK_EQUAL(shrunk.storage_size(), 65536u);
+}
+
+BOOST_AUTO_TEST_CASE(shared_block_kept_intact) {
+	std::vector<std::string> packets;
+	for (size_t payload_size : { 10, 3000, 100, 60000, 5 })
+		packets.push_back(qos0_publish(payload_size));
+
+	std::string stream;
+	for (int i = 0; i < 10; ++i)
+		for (const auto& packet : packets)
+			stream += packet;
+
+	// every packet keeps the block it was read into, as a message_view does
+	struct shared_packet {
+		std::shared_ptr<const std::string> block;
+		std::string_view data;
+	};
+
+	for (size_t max_read : { 7, 4096, 65536 }) {
+		detail::read_buffer buff;
+		std::vector<shared_packet> received;
+		receive(buff, stream, max_read, [&](auto first, auto last) {
+			received.push_back({
+				buff.share(), std::string_view(&*first, std::distance(first, last))
+			});
+		});
+
+		BOOST_REQUIRE_EQUAL(received.size(), 10 * packets.size());
+		for (size_t i = 0; i < received.size(); ++i)
+			BOOST_CHECK(received[i].data == packets[i % packets.size()]);
+	}
+
+	// an unshared block is reused
+	detail::read_buffer buff;
+	buff.prepare();
+	auto block = buff.share().get();
+	receive(buff, stream, 65536, [](auto, auto) {});
+	BOOST_CHECK(buff.share().get() == block);
+}
+
+template <typename Buffer>
+std::chrono::nanoseconds time_per_packet(const std::string& stream) {
+	Buffer buff;
+	size_t num_packets = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	receive(buff, stream, 65536, [&num_packets](auto, auto) {
+		++num_packets;
+	});
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK(num_packets > 0);
+	return elapsed / num_packets;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_small_packets, *boost::unit_test::disabled()) {
+	std::string stream;
+	auto packet = qos0_publish(16);
+	for (int i = 0; i < 1'000'000; ++i)
+		stream += packet;
+
+	BOOST_TEST_MESSAGE(
+		packet.size() << " byte packets: read_buffer " <<
+		time_per_packet<detail::read_buffer>(stream).count() <<
+		" ns, erase and resize " <<
+		time_per_packet<erase_resize_buffer>(stream).count() << " ns"
+	);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_large_packets, *boost::unit_test::disabled()) {
+	for (size_t payload_size : { 1024 * 1024, 16 * 1024 * 1024 }) {
+		std::string stream;
+		for (int i = 0; i < 16; ++i)
+			stream += qos0_publish(payload_size);
+
+		auto elapsed = time_per_packet<detail::read_buffer>(stream);
+		BOOST_TEST_MESSAGE(
+			payload_size << " byte payloads: " <<
+			elapsed.count() / 1000 << " us per packet"
+		);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
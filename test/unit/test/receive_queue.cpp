@@ -0,0 +1,311 @@
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <async_mqtt5/error.hpp>
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/lock_free_channel.hpp>
+#include <async_mqtt5/detail/receive_queue.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(receive_queue/*, *boost::unit_test::disabled()*/)
+
+using signature = void (error_code, std::string, std::string, publish_props);
+using lock_free_channel = detail::lock_free_channel<signature>;
+
+struct received {
+	std::vector<error_code> ecs;
+	std::vector<std::string> payloads;
+
+	auto handler() {
+		return [this](error_code ec, std::string, std::string payload, publish_props) {
+			ecs.push_back(ec);
+			payloads.push_back(std::move(payload));
+		};
+	}
+};
+
+BOOST_AUTO_TEST_CASE(send_then_receive) {
+	asio::io_context ioc;
+	lock_free_channel ch(ioc.get_executor(), 0);
+	received r;
+
+	BOOST_CHECK(ch.try_send(error_code {}, "t", "p_1", publish_props {}));
+	BOOST_CHECK(ch.try_send(error_code {}, "t", "p_2", publish_props {}));
+	ch.async_receive(r.handler());
+	ch.async_receive(r.handler());
+	// completes as if by post
+	BOOST_CHECK(r.payloads.empty());
+
+	ioc.run();
+	BOOST_CHECK(r.payloads == std::vector<std::string>({ "p_1", "p_2" }));
+}
+
+BOOST_AUTO_TEST_CASE(receive_then_send) {
+	asio::io_context ioc;
+	lock_free_channel ch(ioc.get_executor(), 0);
+	received r;
+
+	ch.async_receive(r.handler());
+	asio::post(ioc, [&ch] {
+		ch.try_send(client::error::session_expired, "", "", publish_props {});
+	});
+
+	ioc.run();
+	BOOST_REQUIRE_EQUAL(r.ecs.size(), 1u);
+	BOOST_CHECK(r.ecs[0] == client::error::session_expired);
+}
+
+BOOST_AUTO_TEST_CASE(close_and_reset) {
+	asio::io_context ioc;
+	lock_free_channel ch(ioc.get_executor(), 0);
+	received r;
+
+	ch.async_receive(r.handler());
+	ch.close();
+	BOOST_CHECK(!ch.try_send(error_code {}, "t", "p", publish_props {}));
+	ch.async_receive(r.handler());
+	ioc.run();
+
+	BOOST_REQUIRE_EQUAL(r.ecs.size(), 2u);
+	BOOST_CHECK(r.ecs[0] == asio::error::operation_aborted);
+	BOOST_CHECK(r.ecs[1] == asio::error::operation_aborted);
+
+	ch.reset();
+	BOOST_CHECK(ch.try_send(error_code {}, "t", "p", publish_props {}));
+	ch.async_receive(r.handler());
+	ioc.restart();
+	ioc.run();
+	BOOST_CHECK_EQUAL(r.payloads.back(), "p");
+}
+
+BOOST_AUTO_TEST_CASE(cancel_waiting_receive) {
+	asio::io_context ioc;
+	lock_free_channel ch(ioc.get_executor(), 0);
+	received r;
+	asio::cancellation_signal signal;
+
+	ch.async_receive(asio::bind_cancellation_slot(signal.slot(), r.handler()));
+	asio::post(ioc, [&signal] {
+		signal.emit(asio::cancellation_type::terminal);
+	});
+	ioc.run();
+	BOOST_REQUIRE_EQUAL(r.ecs.size(), 1u);
+	BOOST_CHECK(r.ecs[0] == asio::error::operation_aborted);
+
+	// a receive completed with a value is no longer cancelled by the signal
+	ch.async_receive(asio::bind_cancellation_slot(signal.slot(), r.handler()));
+	BOOST_CHECK(ch.try_send(error_code {}, "t", "p_1", publish_props {}));
+	ioc.restart();
+	ioc.run();
+	signal.emit(asio::cancellation_type::terminal);
+
+	ch.async_receive(r.handler());
+	BOOST_CHECK(ch.try_send(error_code {}, "t", "p_2", publish_props {}));
+	ioc.restart();
+	ioc.run();
+
+	BOOST_REQUIRE_EQUAL(r.ecs.size(), 3u);
+	BOOST_CHECK(!r.ecs[1] && !r.ecs[2]);
+	BOOST_CHECK_EQUAL(r.payloads[1], "p_1");
+	BOOST_CHECK_EQUAL(r.payloads[2], "p_2");
+}
+
+BOOST_AUTO_TEST_CASE(full_ring_rejects) {
+	asio::io_context ioc;
+	lock_free_channel ch(ioc.get_executor(), 0);
+
+	size_t sent = 0;
+	while (ch.try_send(error_code {}, "t", "p", publish_props {}))
+		++sent;
+	BOOST_CHECK_EQUAL(sent, 4096u);
+
+	received r;
+	ch.async_receive(r.handler());
+	ioc.run();
+	BOOST_CHECK(ch.try_send(error_code {}, "t", "p", publish_props {}));
+}
+
+template <receive_queue_e queue>
+void full_channel_drops_oldest() {
+	using channel_type = detail::receive_queue_t<queue, signature>;
+
+	asio::io_context ioc;
+	channel_type ch(ioc.get_executor(), std::numeric_limits<size_t>::max());
+
+	bool all_sent = true;
+	for (size_t i = 0; i <= 65535; ++i)
+		all_sent &= ch.try_send(
+			error_code {}, "t", std::to_string(i), publish_props {}
+		);
+	BOOST_CHECK(all_sent);
+
+	received r;
+	ch.async_receive(r.handler());
+	ioc.run();
+	BOOST_REQUIRE_EQUAL(r.payloads.size(), 1u);
+	BOOST_CHECK_EQUAL(r.payloads[0], "1");
+}
+
+BOOST_AUTO_TEST_CASE(full_channels_drop_oldest) {
+	// unlike the lock-free ring, which rejects the newest message
+	full_channel_drops_oldest<receive_queue_e::concurrent>();
+	full_channel_drops_oldest<receive_queue_e::strand_local>();
+}
+
+// Receives total messages, or stops at the first error.
+template <typename Channel>
+struct receive_loop {
+	Channel& ch;
+	std::atomic<size_t>& num_received;
+	size_t total;
+	std::vector<std::string>* payloads = nullptr;
+
+	void operator()(error_code ec, std::string, std::string payload, publish_props) {
+		if (ec)
+			return;
+		if (payloads)
+			payloads->push_back(std::move(payload));
+		if (num_received.fetch_add(1, std::memory_order_release) + 1 < total)
+			ch.async_receive(std::move(*this));
+	}
+};
+
+// Sends total messages from another thread, keeping at most
+// 1024 of them in the channel.
+template <typename Channel>
+std::thread producer_thread(
+	Channel& ch, const std::atomic<size_t>& num_received, size_t total,
+	bool numbered
+) {
+	return std::thread([&ch, &num_received, total, numbered] {
+		for (size_t i = 0; i < total;) {
+			// yields to the consumer, which may share the core
+			if (i - num_received.load(std::memory_order_acquire) >= 1024) {
+				std::this_thread::yield();
+				continue;
+			}
+			i += ch.try_send(
+				error_code {}, "t",
+				numbered ? std::to_string(i) : std::string("payload"),
+				publish_props {}
+			);
+		}
+	});
+}
+
+BOOST_AUTO_TEST_CASE(cross_thread_order) {
+	constexpr size_t num_messages = 200'000;
+
+	asio::io_context ioc;
+	lock_free_channel ch(ioc.get_executor(), 0);
+
+	std::atomic<size_t> num_received = 0;
+	std::vector<std::string> payloads;
+	ch.async_receive(receive_loop<lock_free_channel> {
+		ch, num_received, num_messages, &payloads
+	});
+
+	auto producer = producer_thread(ch, num_received, num_messages, true);
+	ioc.run();
+	producer.join();
+
+	BOOST_REQUIRE_EQUAL(payloads.size(), num_messages);
+	bool in_order = true;
+	for (size_t i = 0; i < num_messages; ++i)
+		in_order &= payloads[i] == std::to_string(i);
+	BOOST_CHECK(in_order);
+}
+
+constexpr size_t num_benchmark_messages = 1'000'000;
+
+// The Client and the consumer run on the same thread.
+template <receive_queue_e queue>
+double same_thread_rate() {
+	using channel_type = detail::receive_queue_t<queue, signature>;
+
+	asio::io_context ioc;
+	channel_type ch(ioc.get_executor(), std::numeric_limits<size_t>::max());
+	std::atomic<size_t> num_received = 0;
+	ch.async_receive(receive_loop<channel_type> {
+		ch, num_received, num_benchmark_messages
+	});
+
+	// sends in batches, as if read from the stream,
+	// keeping at most 1024 messages in the channel
+	size_t num_sent = 0;
+	std::function<void ()> send_batch = [&] {
+		for (
+			int i = 0;
+			i < 256 && num_sent < num_benchmark_messages &&
+				num_sent - num_received < 1024;
+			++i
+		)
+			num_sent += ch.try_send(
+				error_code {}, "t", "payload", publish_props {}
+			);
+		if (num_sent < num_benchmark_messages)
+			asio::post(ioc, send_batch);
+	};
+	asio::post(ioc, send_batch);
+
+	auto start = std::chrono::steady_clock::now();
+	ioc.run();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK_EQUAL(num_received.load(), num_benchmark_messages);
+	return num_received / elapsed.count() / 1e6;
+}
+
+// The consumer runs on another thread than the Client.
+template <receive_queue_e queue>
+double cross_thread_rate() {
+	using channel_type = detail::receive_queue_t<queue, signature>;
+
+	asio::io_context ioc;
+	channel_type ch(ioc.get_executor(), std::numeric_limits<size_t>::max());
+	std::atomic<size_t> num_received = 0;
+	ch.async_receive(receive_loop<channel_type> {
+		ch, num_received, num_benchmark_messages
+	});
+
+	auto start = std::chrono::steady_clock::now();
+	auto producer = producer_thread(
+		ch, num_received, num_benchmark_messages, false
+	);
+	ioc.run();
+	producer.join();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK_EQUAL(num_received.load(), num_benchmark_messages);
+	return num_received / elapsed.count() / 1e6;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_receive_queues, *boost::unit_test::disabled()) {
+	using enum receive_queue_e;
+
+	BOOST_TEST_MESSAGE(
+		"same thread: concurrent " << same_thread_rate<concurrent>() <<
+		" M/s, strand_local " << same_thread_rate<strand_local>() <<
+		" M/s, lock_free " << same_thread_rate<lock_free>() << " M/s"
+	);
+	BOOST_TEST_MESSAGE(
+		"cross thread: concurrent " << cross_thread_rate<concurrent>() <<
+		" M/s, lock_free " << cross_thread_rate<lock_free>() << " M/s"
+	);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
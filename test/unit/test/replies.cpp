@@ -0,0 +1,80 @@
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/impl/replies.hpp>
+
+using namespace async_mqtt5;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(replies/*, *boost::unit_test::disabled()*/)
+
+using byte_citer = detail::byte_citer;
+
+BOOST_AUTO_TEST_CASE(deadlines_per_reply) {
+	detail::replies replies;
+
+	reply_timeouts timeouts;
+	timeouts.puback = 10s;
+	timeouts.suback = 5s;
+	replies.timeouts(timeouts);
+	BOOST_CHECK(replies.shortest_timeout() == 5s);
+	BOOST_CHECK(!replies.next_deadline());
+
+	int handlers_called = 0;
+	auto handler = [&handlers_called](error_code, byte_citer, byte_citer) {
+		++handlers_called;
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	replies.async_wait_reply(control_code_e::puback, 1, handler);
+	replies.async_wait_reply(control_code_e::suback, 2, handler);
+
+	auto next = replies.next_deadline();
+	BOOST_REQUIRE(next);
+	BOOST_CHECK(next->code == control_code_e::suback);
+	BOOST_CHECK_EQUAL(next->packet_id, 2);
+	BOOST_CHECK(next->at >= start + 5s);
+	BOOST_CHECK(next->at < start + 10s);
+
+	// the deadline of an answered reply is discarded
+	std::string suback(4, '\0');
+	replies.dispatch(
+		error_code {}, control_code_e::suback, 2, suback.cbegin(), suback.cend()
+	);
+	next = replies.next_deadline();
+	BOOST_REQUIRE(next);
+	BOOST_CHECK(next->code == control_code_e::puback);
+	BOOST_CHECK_EQUAL(next->packet_id, 1);
+	BOOST_CHECK(next->at >= start + 10s);
+
+	replies.cancel_unanswered();
+	BOOST_CHECK(!replies.next_deadline());
+	BOOST_CHECK_EQUAL(handlers_called, 2);
+}
+
+BOOST_AUTO_TEST_CASE(many_answered_replies) {
+	detail::replies replies;
+	auto handler = [](error_code, byte_citer, byte_citer) {};
+	std::string puback(3, '\0');
+
+	// only every hundredth reply is left unanswered
+	for (uint16_t pid = 1; pid <= 10000; ++pid) {
+		replies.async_wait_reply(control_code_e::puback, pid, handler);
+		if (pid % 100)
+			replies.dispatch(
+				error_code {}, control_code_e::puback, pid,
+				puback.cbegin(), puback.cend()
+			);
+	}
+
+	auto next = replies.next_deadline();
+	BOOST_REQUIRE(next);
+	BOOST_CHECK_EQUAL(next->packet_id % 100, 0);
+	replies.cancel_unanswered();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,150 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <async_mqtt5/detail/reply_table.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(reply_table/*, *boost::unit_test::disabled()*/)
+
+struct test_entry {
+	control_code_e _code;
+	uint16_t _packet_id;
+	int value;
+
+	control_code_e code() const { return _code; }
+	uint16_t packet_id() const { return _packet_id; }
+};
+
+using table_type = detail::reply_table<test_entry>;
+
+BOOST_AUTO_TEST_CASE(find_and_take) {
+	table_type table;
+	BOOST_CHECK(!table.find(control_code_e::puback, 1));
+
+	table.emplace(test_entry { control_code_e::puback, 1, 10 });
+	table.emplace(test_entry { control_code_e::pubrec, 1, 20 });
+	table.emplace(test_entry { control_code_e::puback, 2, 30 });
+	BOOST_CHECK_EQUAL(table.size(), 3u);
+
+	// the same Packet Identifier is awaited with different control codes
+	BOOST_REQUIRE(table.find(control_code_e::pubrec, 1));
+	BOOST_CHECK_EQUAL(table.find(control_code_e::pubrec, 1)->value, 20);
+	BOOST_CHECK(!table.find(control_code_e::pubcomp, 1));
+
+	auto entry = table.take(table.find(control_code_e::puback, 1));
+	BOOST_CHECK_EQUAL(entry.value, 10);
+	BOOST_CHECK(!table.find(control_code_e::puback, 1));
+
+	// the entry moved into the vacated position is still found
+	BOOST_REQUIRE(table.find(control_code_e::puback, 2));
+	BOOST_CHECK_EQUAL(table.find(control_code_e::puback, 2)->value, 30);
+	BOOST_CHECK_EQUAL(table.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(duplicate_keys) {
+	table_type table;
+	table.emplace(test_entry { control_code_e::puback, 7, 1 });
+	table.emplace(test_entry { control_code_e::puback, 7, 2 });
+
+	auto first = table.take(table.find(control_code_e::puback, 7));
+	BOOST_REQUIRE(table.find(control_code_e::puback, 7));
+	auto second = table.take(table.find(control_code_e::puback, 7));
+	BOOST_CHECK_EQUAL(first.value + second.value, 3);
+	BOOST_CHECK(table.empty());
+}
+
+BOOST_AUTO_TEST_CASE(release_and_extract) {
+	table_type table;
+	for (uint16_t pid = 1; pid <= 100; ++pid)
+		table.emplace(test_entry {
+			pid % 2 ? control_code_e::pubrel : control_code_e::pubcomp,
+			pid, pid
+		});
+
+	auto pubrels = table.extract_if([](const test_entry& e) {
+		return e.code() == control_code_e::pubrel;
+	});
+	BOOST_CHECK_EQUAL(pubrels.size(), 50u);
+	BOOST_CHECK_EQUAL(table.size(), 50u);
+	BOOST_CHECK(!table.find(control_code_e::pubrel, 1));
+	BOOST_REQUIRE(table.find(control_code_e::pubcomp, 100));
+	BOOST_CHECK_EQUAL(table.find(control_code_e::pubcomp, 100)->value, 100);
+
+	auto rest = table.release();
+	BOOST_CHECK_EQUAL(rest.size(), 50u);
+	BOOST_CHECK(table.empty());
+	BOOST_CHECK(!table.find(control_code_e::pubcomp, 100));
+
+	table.emplace(test_entry { control_code_e::suback, 4, 4 });
+	BOOST_CHECK(table.find(control_code_e::suback, 4));
+}
+
+BOOST_AUTO_TEST_CASE(random_operations) {
+	table_type table;
+	std::map<std::pair<control_code_e, uint16_t>, int> expected;
+
+	const control_code_e codes[] = {
+		control_code_e::puback, control_code_e::pubrec,
+		control_code_e::pubcomp, control_code_e::suback
+	};
+
+	std::mt19937 rng(7);
+	for (int i = 0; i < 200'000; ++i) {
+		auto code = codes[rng() % 4];
+		auto pid = uint16_t(1 + rng() % 2000);
+		auto entry = table.find(code, pid);
+		auto it = expected.find({ code, pid });
+
+		BOOST_REQUIRE_EQUAL(entry != nullptr, it != expected.end());
+		if (entry) {
+			BOOST_REQUIRE_EQUAL(entry->value, it->second);
+			table.take(entry);
+			expected.erase(it);
+		}
+		else {
+			table.emplace(test_entry { code, pid, i });
+			expected[{ code, pid }] = i;
+		}
+	}
+	BOOST_CHECK_EQUAL(table.size(), expected.size());
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_acks, *boost::unit_test::disabled()) {
+	constexpr int num_rounds = 20;
+	std::mt19937 rng(42);
+
+	for (uint16_t in_flight : { 1'000, 10'000, 60'000 }) {
+		table_type table;
+		std::vector<uint16_t> pids(in_flight);
+		for (uint16_t i = 0; i < in_flight; ++i)
+			pids[i] = uint16_t(i + 1);
+
+		std::chrono::nanoseconds elapsed {};
+		for (int round = 0; round < num_rounds; ++round) {
+			std::shuffle(pids.begin(), pids.end(), rng);
+
+			auto start = std::chrono::steady_clock::now();
+			for (auto pid : pids)
+				table.emplace(test_entry { control_code_e::puback, pid, pid });
+			// PUBACKs arrive in random order
+			std::shuffle(pids.begin(), pids.end(), rng);
+			for (auto pid : pids)
+				table.take(table.find(control_code_e::puback, pid));
+			elapsed += std::chrono::steady_clock::now() - start;
+		}
+
+		BOOST_CHECK(table.empty());
+		BOOST_TEST_MESSAGE(
+			in_flight << " in flight: " <<
+			(elapsed / (num_rounds * in_flight)).count() << " ns per PUBACK"
+		);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,7 +1,16 @@
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <async_mqtt5/prepared_publish.hpp>
 #include <async_mqtt5/types.hpp>
 
+#include <async_mqtt5/detail/control_packet.hpp>
+
+#include <async_mqtt5/impl/internal/codecs/fast_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_decoders.hpp>
 #include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
 
@@ -121,6 +130,231 @@ BOOST_AUTO_TEST_CASE(test_publish) {
 	BOOST_CHECK_EQUAL(pprops[prop::user_property][1], publish_prop_2);
 }
 
+BOOST_AUTO_TEST_CASE(test_publish_view) {
+	// testing variables
+	uint16_t packet_id = 31283;
+	std::string_view topic = "publish_topic";
+	std::string_view payload = "This is some payload I am publishing!";
+	std::string content_type = "application/octet-stream";
+
+	publish_props pp;
+	pp[prop::content_type] = content_type;
+
+	auto block = std::make_shared<const std::string>(encoders::encode_publish(
+		packet_id, topic, payload,
+		qos_e::at_least_once, retain_e::yes, dup_e::no,
+		pp
+	));
+
+	byte_citer it = block->cbegin(), last = block->cend();
+	auto header = decoders::decode_fixed_header(it, last);
+	BOOST_CHECK_MESSAGE(header, "Parsing PUBLISH fixed header failed.");
+
+	const auto& [control_byte, remain_length] = *header;
+	auto rv = decoders::fast::decode_publish_view(control_byte, remain_length, it, block);
+	BOOST_REQUIRE_MESSAGE(rv, "Parsing PUBLISH failed.");
+	BOOST_CHECK(it == last);
+
+	const auto& [view, packet_id_, flags] = *rv;
+	BOOST_CHECK_EQUAL(*packet_id_, packet_id);
+	BOOST_CHECK_EQUAL(view.topic(), topic);
+	BOOST_CHECK_EQUAL(view.payload(), payload);
+	BOOST_CHECK_EQUAL(*view.props()[prop::content_type], content_type);
+
+	// the Topic Name and Payload refer to the block
+	BOOST_CHECK(view.payload().data() + view.payload().size() == block->data() + block->size());
+	BOOST_CHECK_EQUAL(block.use_count(), 2);
+
+	// truncated packets are rejected
+	for (uint32_t length : { 0u, 1u, 10u })	{
+		it = block->cbegin() + 2;
+		BOOST_CHECK(!decoders::fast::decode_publish_view(control_byte, length, it, block));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_publish_header) {
+	// testing variables
+	uint16_t packet_id = 42;
+	std::string topic = "publish_topic";
+	std::string payload(500 * 1024, 'p');
+
+	publish_props pp;
+	pp[prop::content_type] = "application/octet-stream";
+
+	auto header = encoders::encode_publish_header(
+		packet_id, payload.size(), topic,
+		qos_e::exactly_once, retain_e::no, dup_e::no, pp
+	);
+	auto msg = encoders::encode_publish(
+		packet_id, topic, payload,
+		qos_e::exactly_once, retain_e::no, dup_e::no, pp
+	);
+	BOOST_CHECK_EQUAL(header + payload, msg);
+
+	byte_citer it = msg.cbegin(), last = msg.cend();
+	auto fixed_header = decoders::decode_fixed_header(it, last);
+	BOOST_CHECK_MESSAGE(fixed_header, "Parsing PUBLISH fixed header failed.");
+
+	const auto& [control_byte, remain_length] = *fixed_header;
+	BOOST_CHECK_EQUAL(size_t(std::distance(it, last)), remain_length);
+
+	auto rv = decoders::decode_publish(control_byte, remain_length, it);
+	BOOST_CHECK_MESSAGE(rv, "Parsing PUBLISH failed.");
+
+	const auto& [topic_, packet_id_, flags, pprops, payload_] = *rv;
+	BOOST_CHECK_EQUAL(*packet_id_, packet_id);
+	BOOST_CHECK_EQUAL(topic_, topic);
+	BOOST_CHECK(payload_ == payload);
+}
+
+BOOST_AUTO_TEST_CASE(test_publish_packet_payload_not_copied) {
+	std::string topic = "publish_topic";
+	std::string payload(64 * 1024, 'p');
+	const char* payload_data = payload.data();
+
+	auto publish = control_packet<std::allocator<char>>::of(
+		with_pid, std::allocator<char> {},
+		encoders::encode_publish_header, uint16_t(1),
+		with_payload, std::move(payload),
+		topic, qos_e::at_least_once, retain_e::no, dup_e::no,
+		publish_props {}
+	);
+	BOOST_CHECK(publish.control_code() == control_code_e::publish);
+	BOOST_CHECK(publish.qos() == qos_e::at_least_once);
+
+	auto wire_data = publish.wire_data();
+	const auto& [header_buff, payload_buff] = wire_data;
+
+	// only the header is encoded, the payload is moved into the packet
+	BOOST_CHECK(payload_buff.data() == payload_data);
+	BOOST_CHECK_EQUAL(payload_buff.size(), 64u * 1024);
+	BOOST_CHECK_EQUAL(header_buff.size(), 1u + 3u + 2u + topic.size() + 2u + 1u);
+	BOOST_TEST_MESSAGE(
+		"PUBLISH bytes encoded: " << header_buff.size() <<
+		" of " << header_buff.size() + payload_buff.size()
+	);
+}
+
+template <typename Payload>
+auto publish_packet(Payload&& payload) {
+	return control_packet<std::allocator<char>>::of(
+		with_pid, std::allocator<char> {},
+		encoders::encode_publish_header, uint16_t(1),
+		with_payload, std::forward<Payload>(payload),
+		"publish_topic", qos_e::at_least_once, retain_e::no, dup_e::no,
+		publish_props {}
+	);
+}
+
+BOOST_AUTO_TEST_CASE(test_publish_packet_borrowed_and_shared_payload) {
+	std::vector<char> blob(64 * 1024, 'p');
+
+	auto borrowed = publish_packet(asio::buffer(blob));
+	BOOST_CHECK(borrowed.wire_data()[1].data() == blob.data());
+	BOOST_CHECK_EQUAL(borrowed.wire_data()[1].size(), blob.size());
+
+	auto shared_blob = std::make_shared<const std::vector<char>>(blob);
+	std::weak_ptr<const std::vector<char>> observer = shared_blob;
+	const void* shared_data = shared_blob->data();
+	{
+		auto shared = publish_packet(std::move(shared_blob));
+		BOOST_CHECK(shared.wire_data()[1].data() == shared_data);
+		// the packet keeps the payload alive
+		BOOST_CHECK(!observer.expired());
+	}
+	BOOST_CHECK(observer.expired());
+
+	auto owned = publish_packet("payload");
+	BOOST_CHECK_EQUAL(owned.wire_data()[1].size(), 7u);
+
+	auto expected = encoders::encode_publish_header(
+		1, blob.size(), "publish_topic",
+		qos_e::at_least_once, retain_e::no, dup_e::no, publish_props {}
+	);
+	auto header = borrowed.wire_data()[0];
+	BOOST_CHECK_EQUAL(
+		std::string_view(static_cast<const char*>(header.data()), header.size()),
+		expected
+	);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_publish_payload, *boost::unit_test::disabled()) {
+	// a telemetry blob the caller already holds
+	auto blob = std::make_shared<const std::vector<char>>(256 * 1024, 'p');
+	constexpr size_t num_publishes = 2000;
+
+	// bytes written into memory the caller did not provide, per publish,
+	// including the copy of the blob into a std::string if one is made
+	auto run = [&](const char* name, size_t string_copy, auto make_packet) {
+		size_t copied = string_copy * num_publishes;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < num_publishes; ++i) {
+			auto [header, payload] = make_packet();
+			// the payload buffer is the blob or the std::string copy of it
+			copied += header.size();
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		BOOST_TEST_MESSAGE(
+			name << ": " << copied / num_publishes << " bytes copied, " <<
+			std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+				num_publishes << " ns per publish"
+		);
+	};
+
+	std::string full_packet;
+	run("payload encoded into the packet", blob->size(), [&] {
+		full_packet = encoders::encode_publish(
+			1, "publish_topic", std::string(blob->begin(), blob->end()),
+			qos_e::at_least_once, retain_e::no, dup_e::no, publish_props {}
+		);
+		return std::array<asio::const_buffer, 2> {
+			asio::buffer(full_packet), asio::const_buffer {}
+		};
+	});
+
+	std::optional<control_packet<std::allocator<char>>> packet;
+	run("owned payload", blob->size(), [&] {
+		packet.emplace(publish_packet(std::string(blob->begin(), blob->end())));
+		return packet->wire_data();
+	});
+	run("borrowed payload", 0, [&] {
+		packet.emplace(publish_packet(asio::buffer(*blob)));
+		return packet->wire_data();
+	});
+	run("shared payload", 0, [&] {
+		packet.emplace(publish_packet(blob));
+		return packet->wire_data();
+	});
+}
+
+BOOST_AUTO_TEST_CASE(test_prepared_publish) {
+	// testing variables
+	std::string topic = "sensors/floor_3/temperature";
+	std::string payload = "21.5";
+
+	publish_props pp;
+	pp[prop::content_type] = "text/plain";
+	pp[prop::message_expiry_interval] = 60;
+
+	auto check_prepared = [&](auto prepared, uint16_t packet_id, retain_e retain) {
+		constexpr auto qos = decltype(prepared)::qos_value;
+		auto header = encoders::encode_prepared_publish_header(
+			packet_id, payload.size(),
+			prepared.var_header(), prepared.packet_id_offset(),
+			qos, retain, dup_e::no
+		);
+		auto expected = encoders::encode_publish_header(
+			packet_id, payload.size(), topic, qos, retain, dup_e::no, pp
+		);
+		BOOST_CHECK_EQUAL(header, expected);
+	};
+
+	check_prepared(prepared_publish<qos_e::at_most_once>(topic, pp), 0, retain_e::yes);
+	check_prepared(prepared_publish<qos_e::at_least_once>(topic, pp), 1, retain_e::no);
+	check_prepared(prepared_publish<qos_e::exactly_once>(topic, pp), 65535, retain_e::no);
+	check_prepared(prepared_publish<qos_e::exactly_once>(topic, pp), 258, retain_e::yes);
+}
+
 BOOST_AUTO_TEST_CASE(test_puback) {
 	// testing variables
 	uint16_t packet_id = 9199;
@@ -296,4 +530,245 @@ BOOST_AUTO_TEST_CASE(test_auth) {
 	BOOST_CHECK_EQUAL(props_[prop::user_property][0], user_property);
 }
 
+// Differential tests of the hand-written decoders against the X3 decoders.
+// Each packet is also decoded with every shorter Remaining Length.
+
+template <typename Decode, typename Reencode>
+void check_decoders_agree(
+	const std::string& packet, Decode&& decode, Reencode&& reencode
+) {
+	byte_citer it = packet.cbegin(), it_fast = it, last = packet.cend();
+	auto header = decoders::decode_fixed_header(it, last);
+	auto header_fast = decoders::fast::decode_fixed_header(it_fast, last);
+	BOOST_REQUIRE(header && header_fast);
+	BOOST_CHECK(*header == *header_fast);
+	BOOST_CHECK(it == it_fast);
+
+	const auto [control_byte, remain_length] = *header;
+	auto var_header = packet.cbegin() + (packet.size() - remain_length);
+
+	for (uint32_t length = 0; length <= remain_length; ++length) {
+		auto [rv, rv_fast, end, end_fast] = decode(control_byte, length, var_header);
+		BOOST_REQUIRE_EQUAL(bool(rv), bool(rv_fast));
+		if (!rv)
+			continue;
+		BOOST_CHECK(end == end_fast);
+		BOOST_CHECK(reencode(*rv) == reencode(*rv_fast));
+	}
+}
+
+template <auto x3_decoder, auto fast_decoder>
+auto decode_both(uint8_t, uint32_t length, byte_citer var_header) {
+	auto it = var_header, it_fast = var_header;
+	auto rv = x3_decoder(length, it);
+	auto rv_fast = fast_decoder(length, it_fast);
+	return std::make_tuple(std::move(rv), std::move(rv_fast), it, it_fast);
+}
+
+std::vector<publish_props> test_publish_props() {
+	publish_props with_props;
+	with_props[prop::content_type] = "application/octet-stream";
+	with_props[prop::user_property].emplace_back("user property");
+	with_props[prop::message_expiry_interval] = 70;
+
+	publish_props with_alias;
+	with_alias[prop::topic_alias] = int16_t(3);
+
+	return { publish_props {}, with_props, with_alias };
+}
+
+BOOST_AUTO_TEST_CASE(fast_decode_publish) {
+	auto decode = [](uint8_t control_byte, uint32_t length, byte_citer var_header) {
+		auto it = var_header, it_fast = var_header;
+		auto rv = decoders::decode_publish(control_byte, length, it);
+		auto rv_fast = decoders::fast::decode_publish(control_byte, length, it_fast);
+		return std::make_tuple(std::move(rv), std::move(rv_fast), it, it_fast);
+	};
+	auto reencode = [](const decoders::publish_message& msg) {
+		const auto& [topic, packet_id, flags, props, payload] = msg;
+		return encoders::encode_publish(
+			packet_id.value_or(0), topic, payload,
+			qos_e((flags >> 1) & 0b11), retain_e(flags & 0b0001),
+			dup_e((flags & 0b1000) >> 3), props
+		);
+	};
+
+	for (auto qos : { qos_e::at_most_once, qos_e::at_least_once, qos_e::exactly_once })
+		for (size_t topic_size : { 0, 1, 30, 300 })
+			for (size_t payload_size : { 0, 16, 1000 })
+				for (const auto& props : test_publish_props()) {
+					auto packet = encoders::encode_publish(
+						qos == qos_e::at_most_once ? 0 : 4321,
+						std::string(topic_size, 't'), std::string(payload_size, 'p'),
+						qos, retain_e::yes, dup_e::no, props
+					);
+					check_decoders_agree(packet, decode, reencode);
+				}
+}
+
+BOOST_AUTO_TEST_CASE(fast_decode_pub_replies) {
+	puback_props puback_pp;
+	puback_pp[prop::reason_string] = "PUBACK reason string";
+	pubrec_props pubrec_pp;
+	pubrec_pp[prop::user_property].emplace_back("PUBREC user prop");
+	pubrel_props pubrel_pp;
+	pubrel_pp[prop::reason_string] = "PUBREL reason string";
+	pubcomp_props pubcomp_pp;
+	pubcomp_pp[prop::user_property].emplace_back("PUBCOMP user prop");
+
+	auto reencode = [](const auto& msg) {
+		const auto& [reason_code, props] = msg;
+		using props_type = std::decay_t<decltype(props)>;
+		if constexpr (std::is_same_v<props_type, puback_props>)
+			return encoders::encode_puback(0, reason_code, props);
+		else if constexpr (std::is_same_v<props_type, pubrec_props>)
+			return encoders::encode_pubrec(0, reason_code, props);
+		else if constexpr (std::is_same_v<props_type, pubrel_props>)
+			return encoders::encode_pubrel(0, reason_code, props);
+		else
+			return encoders::encode_pubcomp(0, reason_code, props);
+	};
+
+	for (uint8_t reason_code : { 0x00, 0x10, 0x93 }) {
+		check_decoders_agree(
+			encoders::encode_puback(1, reason_code, puback_props {}),
+			decode_both<decoders::decode_puback, decoders::fast::decode_puback>,
+			reencode
+		);
+		check_decoders_agree(
+			encoders::encode_puback(1, reason_code, puback_pp),
+			decode_both<decoders::decode_puback, decoders::fast::decode_puback>,
+			reencode
+		);
+		check_decoders_agree(
+			encoders::encode_pubrec(1, reason_code, pubrec_pp),
+			decode_both<decoders::decode_pubrec, decoders::fast::decode_pubrec>,
+			reencode
+		);
+		check_decoders_agree(
+			encoders::encode_pubrel(1, reason_code, pubrel_pp),
+			decode_both<decoders::decode_pubrel, decoders::fast::decode_pubrel>,
+			reencode
+		);
+		check_decoders_agree(
+			encoders::encode_pubcomp(1, reason_code, pubcomp_pp),
+			decode_both<decoders::decode_pubcomp, decoders::fast::decode_pubcomp>,
+			reencode
+		);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(fast_decode_suback) {
+	suback_props sp;
+	sp[prop::reason_string] = "SUBACK reason string";
+
+	auto reencode = [](decoders::suback_message msg) {
+		auto& [props, reason_codes] = msg;
+		return encoders::encode_suback(0, reason_codes, props);
+	};
+
+	for (const auto& props : { suback_props {}, sp }) {
+		std::vector<uint8_t> reason_codes { 0x00, 0x01, 0x02, 0x80 };
+		check_decoders_agree(
+			encoders::encode_suback(1, reason_codes, props),
+			decode_both<decoders::decode_suback, decoders::fast::decode_suback>,
+			reencode
+		);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(fast_decode_varint) {
+	for (size_t payload_size : { 0, 120, 16380, 16390, 2097140, 2097160 }) {
+		auto packet = encoders::encode_publish(
+			0, "t", std::string(payload_size, 'p'), qos_e::at_most_once,
+			retain_e::no, dup_e::no, publish_props {}
+		);
+		byte_citer it = packet.cbegin() + 1, it_fast = it;
+		auto rv = decoders::type_parse(it, packet.cend(), decoders::basic::varint_);
+		auto rv_fast = decoders::fast::decode_varint(it_fast, packet.cend());
+		BOOST_REQUIRE(rv && rv_fast);
+		BOOST_CHECK_EQUAL(*rv, *rv_fast);
+		BOOST_CHECK(it == it_fast);
+		BOOST_CHECK_EQUAL(*rv_fast, size_t(std::distance(it_fast, packet.cend())));
+	}
+
+	// at most four bytes
+	std::string overlong = "\xff\xff\xff\xff\x01";
+	byte_citer it = overlong.cbegin();
+	BOOST_CHECK(!decoders::fast::decode_varint(it, overlong.cend()));
+	BOOST_CHECK(it == overlong.cbegin());
+	it = overlong.cbegin();
+	BOOST_CHECK(!decoders::type_parse(it, overlong.cend(), decoders::basic::varint_));
+
+	// incomplete
+	std::string truncated = "\xff\xff";
+	it = truncated.cbegin();
+	BOOST_CHECK(!decoders::fast::decode_varint(it, truncated.cend()));
+}
+
+template <typename Decode>
+std::chrono::nanoseconds time_per_packet(const std::string& packet, Decode&& decode) {
+	constexpr int num_packets = 1'000'000;
+	byte_citer it = packet.cbegin(), last = packet.cend();
+	auto header = decoders::fast::decode_fixed_header(it, last);
+	BOOST_REQUIRE(header);
+	const auto [control_byte, remain_length] = *header;
+
+	size_t decoded = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_packets; ++i) {
+		auto first = it;
+		decoded += decode(control_byte, remain_length, first);
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	BOOST_CHECK_EQUAL(decoded, size_t(num_packets));
+	return elapsed / num_packets;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_decoders, *boost::unit_test::disabled()) {
+	auto publish = encoders::encode_publish(
+		42, "sensors/building-1/floor-2/temperature", std::string(16, 'p'),
+		qos_e::at_least_once, retain_e::no, dup_e::no, publish_props {}
+	);
+	auto publish_x3 = [](uint8_t control_byte, uint32_t length, byte_citer& it) {
+		return decoders::decode_publish(control_byte, length, it).has_value();
+	};
+	auto publish_fast = [](uint8_t control_byte, uint32_t length, byte_citer& it) {
+		return decoders::fast::decode_publish(control_byte, length, it).has_value();
+	};
+	BOOST_TEST_MESSAGE(
+		"PUBLISH: X3 " << time_per_packet(publish, publish_x3).count() <<
+		" ns, hand-written " << time_per_packet(publish, publish_fast).count() << " ns"
+	);
+
+	auto puback = encoders::encode_puback(42, 0x10, puback_props {});
+	auto puback_x3 = [](uint8_t, uint32_t length, byte_citer& it) {
+		auto packet_id = decoders::decode_packet_id(it);
+		return packet_id && decoders::decode_puback(length - 2, it);
+	};
+	auto puback_fast = [](uint8_t, uint32_t length, byte_citer& it) {
+		decoders::fast::decode_packet_id(it);
+		return decoders::fast::decode_puback(length - 2, it).has_value();
+	};
+	BOOST_TEST_MESSAGE(
+		"PUBACK: X3 " << time_per_packet(puback, puback_x3).count() <<
+		" ns, hand-written " << time_per_packet(puback, puback_fast).count() << " ns"
+	);
+
+	std::vector<uint8_t> reason_codes { 0x01 };
+	auto suback = encoders::encode_suback(42, reason_codes, suback_props {});
+	auto suback_x3 = [](uint8_t, uint32_t length, byte_citer& it) {
+		auto packet_id = decoders::decode_packet_id(it);
+		return packet_id && decoders::decode_suback(length - 2, it);
+	};
+	auto suback_fast = [](uint8_t, uint32_t length, byte_citer& it) {
+		decoders::fast::decode_packet_id(it);
+		return decoders::fast::decode_suback(length - 2, it).has_value();
+	};
+	BOOST_TEST_MESSAGE(
+		"SUBACK: X3 " << time_per_packet(suback, suback_x3).count() <<
+		" ns, hand-written " << time_per_packet(suback, suback_fast).count() << " ns"
+	);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,374 @@
+#include <boost/test/unit_test.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <async_mqtt5/mapped_session_store.hpp>
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/control_packet.hpp>
+#include <async_mqtt5/impl/client_service.hpp>
+#include <async_mqtt5/impl/publish_rec_op.hpp>
+#include <async_mqtt5/impl/publish_send_op.hpp>
+#include <async_mqtt5/impl/resume_session.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+#include "test_common/test_service.hpp"
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(session_store/*, *boost::unit_test::disabled()*/)
+
+struct journal_path {
+	std::filesystem::path path;
+
+	journal_path() {
+		static int n = 0;
+		path = std::filesystem::temp_directory_path() /
+			("async_mqtt5_session_test_" + std::to_string(n++));
+		std::filesystem::remove(path);
+	}
+
+	~journal_path() {
+		std::filesystem::remove(path);
+	}
+};
+
+// Keeps the entries in memory, in the order in which they were stored.
+struct memory_store {
+	std::vector<session_entry> entries;
+
+	void store(
+		session_entry_e kind, uint16_t packet_id,
+		std::string_view header, std::string_view payload
+	) {
+		erase(kind, packet_id);
+		entries.push_back({
+			kind, packet_id, std::string(header), std::string(payload)
+		});
+	}
+
+	void erase(session_entry_e kind, uint16_t packet_id) {
+		auto inbound = kind == session_entry_e::inbound_publish;
+		std::erase_if(entries, [&](const session_entry& e) {
+			return e.packet_id == packet_id &&
+				(e.kind == session_entry_e::inbound_publish) == inbound;
+		});
+	}
+
+	std::vector<session_entry> load() {
+		return entries;
+	}
+};
+
+// Fails like a journal on a full disk.
+struct failing_store {
+	void store(session_entry_e, uint16_t, std::string_view, std::string_view) {
+		throw std::runtime_error("disk full");
+	}
+
+	void erase(session_entry_e, uint16_t) {
+		throw std::runtime_error("disk full");
+	}
+
+	std::vector<session_entry> load() {
+		return {};
+	}
+};
+
+static_assert(detail::is_session_store<mapped_session_store>);
+static_assert(detail::is_session_store<memory_store&>);
+
+std::string encoded_header(uint16_t packet_id, size_t payload_size) {
+	return encoders::encode_publish_header(
+		packet_id, payload_size, "session/topic",
+		qos_e::at_least_once, retain_e::no, dup_e::no, publish_props {}
+	);
+}
+
+BOOST_AUTO_TEST_CASE(journal_entries) {
+	journal_path jp;
+	mapped_session_store store(jp.path.string());
+
+	store.store(session_entry_e::publish, 1, encoded_header(1, 3), "one");
+	store.store(session_entry_e::publish, 2, encoded_header(2, 3), "two");
+	store.store(session_entry_e::inbound_publish, 1, encoded_header(1, 2), "in");
+	store.store(session_entry_e::pubrel, 2, {}, {});
+	store.erase(session_entry_e::publish, 1);
+
+	auto entries = store.load();
+	BOOST_REQUIRE_EQUAL(entries.size(), 2u);
+
+	BOOST_CHECK(entries[0].kind == session_entry_e::inbound_publish);
+	BOOST_CHECK_EQUAL(entries[0].packet_id, 1);
+	BOOST_CHECK_EQUAL(entries[0].header, encoded_header(1, 2));
+	BOOST_CHECK_EQUAL(entries[0].payload, "in");
+
+	// the PUBREL entry replaces the PUBLISH entry
+	BOOST_CHECK(entries[1].kind == session_entry_e::pubrel);
+	BOOST_CHECK_EQUAL(entries[1].packet_id, 2);
+	BOOST_CHECK(entries[1].header.empty());
+	BOOST_CHECK(entries[1].payload.empty());
+}
+
+BOOST_AUTO_TEST_CASE(journal_recovered) {
+	journal_path jp;
+	{
+		mapped_session_store store(jp.path.string());
+		store.store(session_entry_e::publish, 7, encoded_header(7, 5), "seven");
+		store.store(session_entry_e::publish, 8, encoded_header(8, 5), "eight");
+		store.store(session_entry_e::inbound_publish, 7, encoded_header(7, 2), "in");
+		store.erase(session_entry_e::publish, 8);
+	}
+
+	mapped_session_store store(jp.path.string());
+	auto entries = store.load();
+	BOOST_REQUIRE_EQUAL(entries.size(), 2u);
+	BOOST_CHECK(entries[0].kind == session_entry_e::publish);
+	BOOST_CHECK_EQUAL(entries[0].packet_id, 7);
+	BOOST_CHECK_EQUAL(entries[0].header, encoded_header(7, 5));
+	BOOST_CHECK_EQUAL(entries[0].payload, "seven");
+	BOOST_CHECK(entries[1].kind == session_entry_e::inbound_publish);
+
+	// recovered entries can be erased
+	store.erase(session_entry_e::publish, 7);
+	BOOST_CHECK_EQUAL(store.load().size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(journal_compacted) {
+	journal_path jp;
+	std::string payload(100, 'p');
+	{
+		mapped_session_store store(jp.path.string(), 4096);
+
+		// far more records than fit into the initial journal
+		for (uint16_t i = 1; i <= 1000; ++i) {
+			store.store(
+				session_entry_e::publish, i, encoded_header(i, 100), payload
+			);
+			if (i % 10)
+				store.erase(session_entry_e::publish, i);
+		}
+
+		auto entries = store.load();
+		BOOST_REQUIRE_EQUAL(entries.size(), 100u);
+		for (size_t i = 0; i < entries.size(); ++i)
+			BOOST_CHECK_EQUAL(entries[i].packet_id, (i + 1) * 10);
+	}
+
+	BOOST_CHECK(!std::filesystem::exists(jp.path.string() + ".tmp"));
+
+	mapped_session_store store(jp.path.string());
+	auto entries = store.load();
+	BOOST_REQUIRE_EQUAL(entries.size(), 100u);
+	BOOST_CHECK_EQUAL(entries.back().packet_id, 1000);
+	BOOST_CHECK_EQUAL(entries.back().header, encoded_header(1000, 100));
+	BOOST_CHECK_EQUAL(entries.back().payload, payload);
+}
+
+BOOST_AUTO_TEST_CASE(incomplete_record_ignored) {
+	journal_path jp;
+	{
+		mapped_session_store store(jp.path.string());
+		store.store(session_entry_e::publish, 1, encoded_header(1, 3), "one");
+	}
+
+	// a record whose kind was never written, as after a crash
+	{
+		std::fstream file(jp.path, std::ios::binary | std::ios::in | std::ios::out);
+		auto header = encoded_header(1, 3);
+		file.seekp(8 + 11 + header.size() + 3 + 1);
+		file.write("\x02\x00\x10\x00\x00\x00", 6);
+	}
+
+	mapped_session_store store(jp.path.string());
+	BOOST_CHECK_EQUAL(store.load().size(), 1u);
+
+	store.store(session_entry_e::publish, 2, encoded_header(2, 3), "two");
+	mapped_session_store reopened(jp.path.string());
+	BOOST_CHECK_EQUAL(reopened.load().size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(not_a_journal) {
+	journal_path jp;
+	{
+		std::ofstream file(jp.path);
+		file << "something else entirely";
+	}
+	BOOST_CHECK_THROW(
+		mapped_session_store(jp.path.string()), std::runtime_error
+	);
+}
+
+BOOST_AUTO_TEST_CASE(reserve_pids) {
+	packet_id_allocator pid_allocator;
+
+	BOOST_CHECK(pid_allocator.reserve(3));
+	BOOST_CHECK(!pid_allocator.reserve(3));
+	BOOST_CHECK(pid_allocator.reserve(1));
+	BOOST_CHECK(pid_allocator.reserve(65535));
+
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 2);
+	BOOST_CHECK_EQUAL(pid_allocator.allocate(), 4);
+
+	pid_allocator.free(3);
+	BOOST_CHECK(pid_allocator.reserve(3));
+	BOOST_CHECK(!pid_allocator.reserve(0));
+}
+
+using client_service_type = test::test_service<asio::ip::tcp::socket>;
+
+BOOST_AUTO_TEST_CASE(outbound_publish_stored) {
+	asio::io_context ioc;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+
+	memory_store store;
+	svc_ptr->session_store(store);
+
+	int handlers_called = 0;
+	auto handler = [&handlers_called](error_code ec, reason_code, puback_props) {
+		++handlers_called;
+		BOOST_CHECK(ec == asio::error::operation_aborted);
+	};
+
+	detail::publish_send_op<
+		client_service_type, decltype(handler), qos_e::at_least_once
+	> { svc_ptr, std::move(handler) }
+		.perform("session/topic", "payload", retain_e::no, {});
+
+	asio::steady_timer timer(ioc.get_executor());
+	timer.expires_after(std::chrono::milliseconds(50));
+	timer.async_wait([&](error_code) {
+		BOOST_REQUIRE_EQUAL(store.entries.size(), 1u);
+		const auto& entry = store.entries.front();
+		BOOST_CHECK(entry.kind == session_entry_e::publish);
+		BOOST_CHECK_EQUAL(entry.header, encoded_header(entry.packet_id, 7));
+		BOOST_CHECK_EQUAL(entry.payload, "payload");
+
+		// the cancelled publish stays in the store
+		svc_ptr->cancel();
+	});
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(handlers_called, 1);
+	BOOST_CHECK_EQUAL(store.entries.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(store_failure_reported) {
+	asio::io_context ioc;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+	svc_ptr->session_store(failing_store {});
+
+	int handlers_called = 0;
+	auto handler = [&handlers_called](error_code ec, reason_code, puback_props) {
+		++handlers_called;
+		BOOST_CHECK(ec == asio::error::operation_aborted);
+	};
+
+	// two failing stores, reported once
+	for (int i = 0; i < 2; ++i)
+		detail::publish_send_op<
+			client_service_type, decltype(handler), qos_e::at_least_once
+		> { svc_ptr, handler }
+			.perform("session/topic", "payload", retain_e::no, {});
+
+	svc_ptr->async_channel_receive(
+		[&](error_code ec, std::string, std::string, publish_props) {
+			++handlers_called;
+			BOOST_CHECK(ec == client::error::session_store_failed);
+			// the Client continues without the store
+			BOOST_CHECK(!svc_ptr->session_store_enabled());
+			svc_ptr->cancel();
+		}
+	);
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(handlers_called, 3);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_publish_resumed) {
+	asio::io_context ioc;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+
+	memory_store store;
+	store.store(session_entry_e::publish, 1, encoded_header(1, 3), "one");
+	store.store(session_entry_e::pubrel, 2, {}, {});
+	svc_ptr->session_store(store);
+
+	detail::resume_session(svc_ptr);
+
+	// the restored Packet Identifiers are in use
+	BOOST_CHECK_EQUAL(svc_ptr->allocate_pid(), 3);
+
+	asio::steady_timer timer(ioc.get_executor());
+	timer.expires_after(std::chrono::milliseconds(50));
+	timer.async_wait([&](error_code) {
+		// both wait for a reply
+		BOOST_CHECK_EQUAL(svc_ptr.use_count(), 3);
+		svc_ptr->cancel();
+	});
+
+	ioc.run();
+	BOOST_CHECK_EQUAL(store.entries.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(inbound_publish_stored) {
+	asio::io_context ioc;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+
+	memory_store store;
+	svc_ptr->session_store(store);
+
+	decoders::publish_message pub_msg = std::make_tuple(
+		"topic", 1, 0b0100, publish_props {}, "payload"
+	);
+	detail::publish_rec_op<client_service_type> { svc_ptr }.perform(pub_msg);
+
+	asio::steady_timer timer(ioc.get_executor());
+	timer.expires_after(std::chrono::milliseconds(50));
+	timer.async_wait([&](error_code) {
+		BOOST_REQUIRE_EQUAL(store.entries.size(), 1u);
+		BOOST_CHECK(store.entries[0].kind == session_entry_e::inbound_publish);
+		BOOST_CHECK_EQUAL(store.entries[0].packet_id, 1);
+		BOOST_CHECK_EQUAL(store.entries[0].payload, "payload");
+
+		// the Broker has no session, the PUBREL will never arrive
+		svc_ptr->update_session_state();
+		BOOST_CHECK(store.entries.empty());
+		svc_ptr->cancel();
+	});
+
+	ioc.run();
+}
+
+BOOST_AUTO_TEST_CASE(inbound_publish_resumed) {
+	asio::io_context ioc;
+	auto svc_ptr = std::make_shared<client_service_type>(ioc.get_executor());
+
+	memory_store store;
+	auto header = encoders::encode_publish_header(
+		5, 7, "topic", qos_e::exactly_once, retain_e::no, dup_e::no,
+		publish_props {}
+	);
+	store.store(session_entry_e::inbound_publish, 5, header, "payload");
+	svc_ptr->session_store(store);
+
+	detail::resume_session(svc_ptr);
+	// waits for PUBREL
+	BOOST_CHECK_EQUAL(svc_ptr.use_count(), 2);
+
+	svc_ptr->cancel();
+	BOOST_CHECK_EQUAL(svc_ptr.use_count(), 1);
+	BOOST_CHECK_EQUAL(store.entries.size(), 1u);
+
+	ioc.run();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,200 @@
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/control_packet.hpp>
+#include <async_mqtt5/detail/spill_log.hpp>
+#include <async_mqtt5/impl/internal/codecs/message_encoders.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(spill_log/*, *boost::unit_test::disabled()*/)
+
+using packet_type = control_packet<std::allocator<char>>;
+
+struct spill_dir {
+	std::filesystem::path path;
+
+	spill_dir() {
+		static int n = 0;
+		path = std::filesystem::temp_directory_path() /
+			("async_mqtt5_spill_test_" + std::to_string(n++));
+		std::filesystem::remove_all(path);
+		std::filesystem::create_directories(path);
+	}
+
+	~spill_dir() {
+		std::filesystem::remove_all(path);
+	}
+
+	size_t files() const {
+		auto it = std::filesystem::directory_iterator(path);
+		return std::distance(it, std::filesystem::directory_iterator {});
+	}
+};
+
+packet_type make_publish(uint16_t packet_id, std::string payload) {
+	publish_props props;
+	props[prop::content_type] = "application/octet-stream";
+	return packet_type::of(
+		with_pid, std::allocator<char> {},
+		encoders::encode_publish_header, packet_id,
+		with_payload, std::move(payload),
+		"spill/topic", qos_e::at_least_once, retain_e::no, dup_e::no, props
+	);
+}
+
+std::string wire_bytes(const packet_type& packet) {
+	std::string bytes;
+	for (const auto& buffer : packet.wire_data())
+		bytes.append(static_cast<const char*>(buffer.data()), buffer.size());
+	return bytes;
+}
+
+BOOST_AUTO_TEST_CASE(spilled_packet_unchanged) {
+	spill_dir dir;
+	detail::spill_log log;
+	log.configure(dir.path.string(), 0, 4096);
+
+	auto publish = make_publish(1234, std::string(100, 'p'));
+	auto expected = wire_bytes(publish);
+
+	BOOST_REQUIRE(publish.spill(log));
+	BOOST_CHECK(publish.spilled());
+	BOOST_CHECK_EQUAL(wire_bytes(publish), expected);
+	BOOST_CHECK_EQUAL(publish.packet_id(), 1234);
+	BOOST_CHECK(publish.control_code() == control_code_e::publish);
+	BOOST_CHECK(publish.qos() == qos_e::at_least_once);
+
+	// already spilled
+	BOOST_CHECK(!publish.spill(log));
+
+	// resending sets the DUP flag in the mapped pages
+	publish.set_dup();
+	BOOST_CHECK(publish.dup() == dup_e::yes);
+	auto dup_bytes = wire_bytes(publish);
+	BOOST_CHECK_EQUAL(uint8_t(dup_bytes[0]), uint8_t(expected[0]) | 0b00001000);
+	BOOST_CHECK_EQUAL(dup_bytes.substr(1), expected.substr(1));
+
+	auto moved = std::move(publish);
+	BOOST_CHECK_EQUAL(wire_bytes(moved).substr(1), expected.substr(1));
+}
+
+BOOST_AUTO_TEST_CASE(segments_removed_when_released) {
+	spill_dir dir;
+	detail::spill_log log;
+	log.configure(dir.path.string(), 0, 4096);
+
+	std::vector<packet_type> packets;
+	for (uint16_t i = 1; i <= 100; ++i) {
+		packets.push_back(make_publish(i, std::string(200, char('a' + i % 26))));
+		BOOST_REQUIRE(packets.back().spill(log));
+	}
+
+	// about 16 packets fit into a segment
+	BOOST_CHECK_GT(dir.files(), 5u);
+
+	for (uint16_t i = 1; i <= 100; ++i)
+		BOOST_CHECK_EQUAL(
+			wire_bytes(packets[i - 1]),
+			wire_bytes(make_publish(i, std::string(200, char('a' + i % 26))))
+		);
+
+	packets.clear();
+	// the log keeps appending to its current segment
+	BOOST_CHECK_EQUAL(dir.files(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(packets_kept_in_memory) {
+	spill_dir dir;
+	detail::spill_log log;
+
+	auto publish = make_publish(1, std::string(100, 'p'));
+	BOOST_CHECK(!publish.spill(log)); // not configured
+
+	log.configure(dir.path.string(), 0, 4096);
+	auto large = make_publish(2, std::string(5000, 'p'));
+	auto expected = wire_bytes(large);
+	BOOST_CHECK(!large.spill(log));
+	BOOST_CHECK(!large.spilled());
+	BOOST_CHECK_EQUAL(wire_bytes(large), expected);
+
+	log.configure((dir.path / "missing").string(), 0, 4096);
+	BOOST_CHECK(!publish.spill(log));
+	BOOST_CHECK_EQUAL(dir.files(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(stale_segments_removed) {
+	spill_dir dir;
+	// left by a run that crashed
+	std::ofstream { dir.path / "async_mqtt5-spill-0" } << "stale";
+	std::ofstream { dir.path / "async_mqtt5-spill-7" } << "stale";
+	std::ofstream { dir.path / "unrelated" } << "kept";
+
+	detail::spill_log log;
+	log.configure(dir.path.string(), 0, 4096);
+	BOOST_CHECK_EQUAL(dir.files(), 1u);
+	BOOST_CHECK(std::filesystem::exists(dir.path / "unrelated"));
+
+	auto publish = make_publish(1, std::string(100, 'p'));
+	auto expected = wire_bytes(publish);
+	BOOST_REQUIRE(publish.spill(log));
+	BOOST_CHECK_EQUAL(wire_bytes(publish), expected);
+	BOOST_CHECK_EQUAL(dir.files(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(replay_throughput, *boost::unit_test::disabled()) {
+	// replays the packets queued during an outage, as a resend does
+	constexpr int num_packets = 256 * 1024;
+	constexpr size_t payload_size = 1024;
+
+	spill_dir dir;
+	detail::spill_log log;
+	log.configure(dir.path.string(), 0, 64 * 1024 * 1024);
+
+	auto replay = [](const std::vector<packet_type>& packets) {
+		std::vector<char> sink(64 * 1024);
+		size_t total = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for (const auto& packet : packets)
+			for (const auto& buffer : packet.wire_data()) {
+				total += boost::asio::buffer_copy(
+					boost::asio::buffer(sink), buffer
+				);
+			}
+		auto elapsed = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start
+		);
+
+		BOOST_CHECK_GT(total, size_t(num_packets) * payload_size);
+		return double(total) / (1024 * 1024) / elapsed.count();
+	};
+
+	std::vector<packet_type> packets;
+	packets.reserve(num_packets);
+	for (int i = 0; i < num_packets; ++i)
+		packets.push_back(make_publish(
+			uint16_t(i % 65535 + 1), std::string(payload_size, char(i))
+		));
+	auto in_memory = replay(packets);
+
+	for (auto& packet : packets)
+		packet.spill(log);
+	auto spilled = replay(packets);
+
+	BOOST_TEST_MESSAGE(
+		"Replayed " << num_packets << " packets: in memory " <<
+		in_memory << " MB/s, spilled " << spilled << " MB/s"
+	);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
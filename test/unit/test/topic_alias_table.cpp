@@ -0,0 +1,173 @@
+#include <boost/test/unit_test.hpp>
+
+#include <async_mqtt5/detail/topic_alias_table.hpp>
+
+using namespace async_mqtt5;
+
+BOOST_AUTO_TEST_SUITE(topic_alias_table/*, *boost::unit_test::disabled()*/)
+
+using table_type = detail::topic_alias_table;
+
+table_type make_table(uint16_t topic_alias_maximum) {
+	table_type table;
+	table.enable(true);
+	table.reset(topic_alias_maximum);
+	return table;
+}
+
+BOOST_AUTO_TEST_CASE(disabled_table) {
+	table_type table;
+	table.reset(10);
+
+	auto lease = table.acquire("topic");
+	BOOST_CHECK_EQUAL(lease.alias, 0);
+	BOOST_CHECK(!lease.alias_only);
+	BOOST_CHECK(table.current(lease));
+}
+
+BOOST_AUTO_TEST_CASE(no_aliases_allowed) {
+	auto table = make_table(0);
+
+	auto lease = table.acquire("topic");
+	BOOST_CHECK_EQUAL(lease.alias, 0);
+}
+
+BOOST_AUTO_TEST_CASE(alias_only_after_written) {
+	auto table = make_table(10);
+
+	auto first = table.acquire("topic");
+	BOOST_CHECK_EQUAL(first.alias, 1);
+	BOOST_CHECK(!first.alias_only);
+
+	// the first packet has not been written yet
+	auto second = table.acquire("topic");
+	BOOST_CHECK_EQUAL(second.alias, 1);
+	BOOST_CHECK(!second.alias_only);
+
+	table.established(first);
+	table.release(first);
+	BOOST_CHECK_EQUAL(first.alias, 0);
+
+	auto third = table.acquire("topic");
+	BOOST_CHECK_EQUAL(third.alias, 1);
+	BOOST_CHECK(third.alias_only);
+
+	auto other = table.acquire("other");
+	BOOST_CHECK_EQUAL(other.alias, 2);
+	BOOST_CHECK(!other.alias_only);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_evicted) {
+	auto table = make_table(2);
+
+	for (auto topic : { "a", "b" }) {
+		auto lease = table.acquire(topic);
+		table.established(lease);
+		table.release(lease);
+	}
+
+	// "a" becomes the most recently used topic
+	auto a = table.acquire("a");
+	BOOST_CHECK(a.alias_only);
+	table.release(a);
+
+	auto c = table.acquire("c");
+	BOOST_CHECK_EQUAL(c.alias, 2);
+	BOOST_CHECK(!c.alias_only);
+	table.established(c);
+	table.release(c);
+
+	auto b = table.acquire("b");
+	BOOST_CHECK_EQUAL(b.alias, 1);
+	BOOST_CHECK(!b.alias_only);
+	BOOST_CHECK_EQUAL(table.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(referenced_alias_not_evicted) {
+	auto table = make_table(1);
+
+	auto a = table.acquire("a");
+	table.established(a);
+
+	auto b = table.acquire("b");
+	BOOST_CHECK_EQUAL(b.alias, 0);
+
+	table.release(a);
+
+	b = table.acquire("b");
+	BOOST_CHECK_EQUAL(b.alias, 1);
+	BOOST_CHECK(!b.alias_only);
+}
+
+BOOST_AUTO_TEST_CASE(reset_on_reconnect) {
+	auto table = make_table(10);
+
+	auto a = table.acquire("a");
+	table.established(a);
+	BOOST_CHECK(table.current(a));
+
+	table.reset(5);
+	BOOST_CHECK(!table.current(a));
+
+	// stale leases are ignored
+	table.release(a);
+	BOOST_CHECK_EQUAL(table.size(), 0u);
+
+	auto b = table.acquire("b");
+	BOOST_CHECK_EQUAL(b.alias, 1);
+	BOOST_CHECK(!b.alias_only);
+
+	auto again = table.acquire("a");
+	BOOST_CHECK_EQUAL(again.alias, 2);
+	BOOST_CHECK(!again.alias_only);
+}
+
+BOOST_AUTO_TEST_CASE(inbound_aliases_resolved) {
+	detail::inbound_topic_alias_table table;
+	table.reset(2);
+
+	std::string topic = "sensors/1";
+	BOOST_CHECK(!table.resolve(topic, int16_t(2)));
+
+	std::string aliased;
+	BOOST_CHECK(!table.resolve(aliased, int16_t(2)));
+	BOOST_CHECK_EQUAL(aliased, "sensors/1");
+
+	// the Broker maps the alias to another topic
+	std::string remapped = "sensors/2";
+	BOOST_CHECK(!table.resolve(remapped, int16_t(2)));
+
+	aliased.clear();
+	BOOST_CHECK(!table.resolve(aliased, int16_t(2)));
+	BOOST_CHECK_EQUAL(aliased, "sensors/2");
+
+	std::string plain = "plain";
+	BOOST_CHECK(!table.resolve(plain, std::nullopt));
+	BOOST_CHECK_EQUAL(plain, "plain");
+}
+
+BOOST_AUTO_TEST_CASE(inbound_aliases_invalid) {
+	detail::inbound_topic_alias_table table;
+	table.reset(2);
+
+	std::string topic;
+	auto rc = table.resolve(topic, int16_t(1));
+	BOOST_CHECK(rc == detail::disconnect_rc_e::protocol_error);
+
+	rc = table.resolve(topic, int16_t(0));
+	BOOST_CHECK(rc == detail::disconnect_rc_e::topic_alias_invalid);
+
+	topic = "topic";
+	rc = table.resolve(topic, int16_t(3));
+	BOOST_CHECK(rc == detail::disconnect_rc_e::topic_alias_invalid);
+
+	BOOST_CHECK(!table.resolve(topic, int16_t(1)));
+
+	// aliases do not outlive the connection
+	table.reset(2);
+	std::string aliased;
+	rc = table.resolve(aliased, int16_t(1));
+	BOOST_CHECK(rc == detail::disconnect_rc_e::protocol_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
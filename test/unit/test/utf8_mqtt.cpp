@@ -0,0 +1,210 @@
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <async_mqtt5/error.hpp>
+#include <async_mqtt5/types.hpp>
+
+#include <async_mqtt5/detail/utf8_mqtt.hpp>
+
+using namespace async_mqtt5;
+
+namespace async_mqtt5::client {
+
+inline std::ostream& operator<<(std::ostream& os, const error& err) {
+	os << client_error_to_string(err);
+	return os;
+}
+
+} // end namespace async_mqtt5::client
+
+BOOST_AUTO_TEST_SUITE(utf8_mqtt/*, *boost::unit_test::disabled()*/)
+
+bool both_validate(std::string_view str) {
+	bool rv = detail::is_valid_mqtt_utf8(str);
+	BOOST_CHECK_EQUAL(rv, detail::is_valid_mqtt_utf8_scalar(str));
+	return rv;
+}
+
+BOOST_AUTO_TEST_CASE(well_formed_strings) {
+	BOOST_CHECK(both_validate(""));
+	BOOST_CHECK(both_validate("sensors/temperature"));
+	BOOST_CHECK(both_validate("\x7f"));
+	BOOST_CHECK(both_validate("\xc2\x80"));
+	BOOST_CHECK(both_validate("caf\xc3\xa9"));
+	BOOST_CHECK(both_validate("\xe2\x82\xac 10"));
+	BOOST_CHECK(both_validate("\xef\xbf\xbf"));
+	BOOST_CHECK(both_validate("\xf0\x9f\x98\x80"));
+	BOOST_CHECK(both_validate("\xf4\x8f\xbf\xbf"));
+}
+
+BOOST_AUTO_TEST_CASE(malformed_strings) {
+	using namespace std::string_view_literals;
+	BOOST_CHECK(!both_validate("\0"sv));
+	BOOST_CHECK(!both_validate("topic\0name"sv));
+	BOOST_CHECK(!both_validate("\x80"));
+	BOOST_CHECK(!both_validate("\xbf"));
+	BOOST_CHECK(!both_validate("\xc3"));
+	BOOST_CHECK(!both_validate("\xc3 "));
+	BOOST_CHECK(!both_validate("\xe2\x82"));
+	BOOST_CHECK(!both_validate("\xf0\x9f\x98"));
+	BOOST_CHECK(!both_validate("\xf8\x88\x80\x80\x80"));
+	BOOST_CHECK(!both_validate("\xff"));
+	// overlong encodings
+	BOOST_CHECK(!both_validate("\xc0\x80"));
+	BOOST_CHECK(!both_validate("\xc1\xbf"));
+	BOOST_CHECK(!both_validate("\xe0\x9f\xbf"));
+	BOOST_CHECK(!both_validate("\xf0\x8f\xbf\xbf"));
+	// surrogates
+	BOOST_CHECK(!both_validate("\xed\xa0\x80"));
+	BOOST_CHECK(!both_validate("\xed\xbf\xbf"));
+	// above U+10FFFF
+	BOOST_CHECK(!both_validate("\xf4\x90\x80\x80"));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_byte_at_every_position) {
+	// exercises the 32, 16 and 8 byte blocks and the tail
+	for (size_t size : { 7, 8, 15, 16, 31, 32, 33, 64, 100 })
+		for (size_t pos = 0; pos < size; ++pos) {
+			std::string str(size, 'a');
+			BOOST_CHECK(both_validate(str));
+
+			str[pos] = '\0';
+			BOOST_CHECK(!both_validate(str));
+
+			str[pos] = '\x80';
+			BOOST_CHECK(!both_validate(str));
+
+			if (pos + 1 < size) {
+				str[pos] = '\xc3';
+				str[pos + 1] = '\xa9';
+				BOOST_CHECK(both_validate(str));
+			}
+		}
+}
+
+BOOST_AUTO_TEST_CASE(random_strings) {
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int> byte(0, 255), ascii(1, 127);
+	std::uniform_int_distribution<size_t> length(0, 80);
+
+	for (int i = 0; i < 20'000; ++i) {
+		std::string str(length(gen), 'a');
+		for (auto& c : str)
+			c = char(i % 2 ? ascii(gen) : byte(gen));
+		// mostly ASCII with a few random bytes
+		if (i % 2 && !str.empty())
+			str[length(gen) % str.size()] = char(byte(gen));
+		both_validate(str);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(topic_names) {
+	BOOST_CHECK(detail::is_valid_topic_name(""));
+	BOOST_CHECK(detail::is_valid_topic_name("/"));
+	BOOST_CHECK(detail::is_valid_topic_name("sport/tennis/player1"));
+	BOOST_CHECK(detail::is_valid_topic_name("caf\xc3\xa9/menu"));
+	BOOST_CHECK(!detail::is_valid_topic_name("sport/tennis/+"));
+	BOOST_CHECK(!detail::is_valid_topic_name("sport/#"));
+	BOOST_CHECK(!detail::is_valid_topic_name("sport+"));
+	BOOST_CHECK(!detail::is_valid_topic_name("sport/\xc3"));
+	BOOST_CHECK(!detail::is_valid_topic_name(std::string(65536, 'a')));
+}
+
+BOOST_AUTO_TEST_CASE(topic_filters) {
+	BOOST_CHECK(detail::is_valid_topic_filter("#"));
+	BOOST_CHECK(detail::is_valid_topic_filter("+"));
+	BOOST_CHECK(detail::is_valid_topic_filter("/"));
+	BOOST_CHECK(detail::is_valid_topic_filter("sport/#"));
+	BOOST_CHECK(detail::is_valid_topic_filter("sport/tennis/+"));
+	BOOST_CHECK(detail::is_valid_topic_filter("+/tennis/#"));
+	BOOST_CHECK(detail::is_valid_topic_filter("+/+"));
+	BOOST_CHECK(detail::is_valid_topic_filter("/+/"));
+	BOOST_CHECK(detail::is_valid_topic_filter("$share/group/sport/#"));
+
+	BOOST_CHECK(!detail::is_valid_topic_filter(""));
+	BOOST_CHECK(!detail::is_valid_topic_filter("sport#"));
+	BOOST_CHECK(!detail::is_valid_topic_filter("sport/#/ranking"));
+	BOOST_CHECK(!detail::is_valid_topic_filter("#/"));
+	BOOST_CHECK(!detail::is_valid_topic_filter("sport+"));
+	BOOST_CHECK(!detail::is_valid_topic_filter("sport/+tennis"));
+	BOOST_CHECK(!detail::is_valid_topic_filter("sport/\xc0\x80"));
+}
+
+BOOST_AUTO_TEST_CASE(publish_strings) {
+	using namespace std::string_literals;
+
+	publish_props props;
+	props[prop::content_type] = "text/plain";
+	props[prop::user_property].push_back("k\xc3\xa9y");
+	// Binary Data is not UTF-8
+	props[prop::correlation_data] = "\0\xff\xfe"s;
+	BOOST_CHECK(!detail::validate_publish_strings("sport/tennis", props));
+
+	BOOST_CHECK_EQUAL(
+		detail::validate_publish_strings("sport/+", props),
+		client::error::invalid_topic
+	);
+
+	props[prop::user_property].push_back("\xed\xa0\x80");
+	BOOST_CHECK_EQUAL(
+		detail::validate_publish_strings("sport/tennis", props),
+		client::error::malformed_string
+	);
+
+	props[prop::user_property].pop_back();
+	props[prop::response_topic] = "reply\0"s;
+	BOOST_CHECK_EQUAL(
+		detail::validate_publish_strings("sport/tennis", props),
+		client::error::malformed_string
+	);
+}
+
+template <typename Validate>
+double gigabytes_per_second(const std::string& str, Validate&& validate) {
+	const size_t num_iterations = 256 * 1024 * 1024 / str.size();
+	// keeps the compiler from hoisting the call out of the loop
+	const char* volatile data = str.data();
+	size_t valid = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < num_iterations; ++i)
+		valid += validate(std::string_view(data, str.size()));
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	BOOST_CHECK_EQUAL(valid, num_iterations);
+	return num_iterations * str.size() / elapsed.count() / 1e9;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_validation, *boost::unit_test::disabled()) {
+	for (size_t size : { 16, 64, 256, 1024, 4096 }) {
+		std::string ascii(size, 'a');
+		for (size_t i = 0; i < size; i += 7)
+			ascii[i] = '/';
+
+		// a two byte sequence every 64 bytes
+		std::string mixed = ascii;
+		for (size_t i = 0; i + 1 < size; i += 64) {
+			mixed[i] = '\xc3';
+			mixed[i + 1] = '\xa9';
+		}
+
+		auto vectorized = [](std::string_view s) {
+			return detail::is_valid_mqtt_utf8(s);
+		};
+		auto scalar = [](std::string_view s) {
+			return detail::is_valid_mqtt_utf8_scalar(s);
+		};
+		BOOST_TEST_MESSAGE(
+			size << " B ASCII: vectorized " <<
+			gigabytes_per_second(ascii, vectorized) << " GB/s, scalar " <<
+			gigabytes_per_second(ascii, scalar) << " GB/s; " <<
+			"with multi-byte: vectorized " <<
+			gigabytes_per_second(mixed, vectorized) << " GB/s, scalar " <<
+			gigabytes_per_second(mixed, scalar) << " GB/s"
+		);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
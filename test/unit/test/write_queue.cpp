@@ -0,0 +1,525 @@
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <functional>
+#include <optional>
+
+#include <boost/asio/io_context.hpp>
+
+#include <async_mqtt5/impl/async_sender.hpp>
+
+using namespace async_mqtt5;
+
+namespace async_mqtt5::client {
+
+inline std::ostream& operator<<(std::ostream& os, const error& err) {
+	os << client_error_to_string(err);
+	return os;
+}
+
+} // end namespace async_mqtt5::client
+
+BOOST_AUTO_TEST_SUITE(write_queue/*, *boost::unit_test::disabled()*/)
+
+using detail::send_flag::traffic_class;
+
+struct test_queue {
+	detail::write_queue queue;
+	std::vector<int> written;
+	std::vector<std::string> payloads;
+	detail::serial_num_t serial_num = 0;
+
+	test_queue() { payloads.reserve(1024); }
+
+	void push(size_t size, unsigned flags, int id) {
+		auto& payload = payloads.emplace_back(size, 'x');
+		std::array<asio::const_buffer, 2> buffers {
+			asio::buffer(payload), asio::const_buffer {}
+		};
+		queue.push(detail::write_req {
+			buffers, ++serial_num, flags,
+			[this, id](error_code) { written.push_back(id); }
+		});
+	}
+
+	size_t write(uint16_t& quota, bool limited) {
+		std::vector<detail::write_req> reqs;
+		if (!queue.take_terminal(reqs))
+			queue.take(reqs, quota, limited);
+		for (auto& req : reqs)
+			req.complete(error_code {});
+		return reqs.size();
+	}
+};
+
+BOOST_AUTO_TEST_CASE(control_packets_first) {
+	test_queue q;
+	uint16_t quota = 0;
+
+	q.push(10, traffic_class(traffic_class_e::telemetry), 1);
+	q.push(10, traffic_class(traffic_class_e::bulk), 2);
+	q.push(10, detail::send_flag::none, 0);
+
+	BOOST_CHECK_EQUAL(q.write(quota, false), 3u);
+	BOOST_CHECK_EQUAL(q.written.front(), 0);
+	BOOST_CHECK(q.queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(alarm_not_delayed_by_bulk_backlog) {
+	test_queue q;
+	q.queue.max_write_bytes(256 * 1024);
+	uint16_t quota = 0;
+
+	for (int i = 0; i < 100; ++i)
+		q.push(100'000, traffic_class(traffic_class_e::bulk), 1000 + i);
+	q.push(100, traffic_class(traffic_class_e::alarm), 1);
+
+	// the backlog is written in many writes, the alarm in the first one
+	q.write(quota, false);
+	BOOST_CHECK(
+		std::find(q.written.begin(), q.written.end(), 1) != q.written.end()
+	);
+	BOOST_CHECK_LT(q.written.size(), 10u);
+
+	size_t writes = 1;
+	while (!q.queue.empty()) {
+		BOOST_REQUIRE_GT(q.write(quota, false), 0u);
+		++writes;
+	}
+	BOOST_CHECK_GT(writes, 30u);
+	BOOST_CHECK_EQUAL(q.written.size(), 101u);
+	BOOST_CHECK_EQUAL(q.queue.bytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(write_bounded_by_default) {
+	test_queue q;
+	uint16_t quota = 0;
+
+	for (int i = 0; i < 100; ++i)
+		q.push(100'000, traffic_class(traffic_class_e::bulk), i);
+
+	// packets are added until 256 KiB are taken
+	BOOST_CHECK_EQUAL(q.write(quota, false), 3u);
+
+	q.queue.max_write_bytes(0); // no limit
+	BOOST_CHECK_EQUAL(q.write(quota, false), 97u);
+	BOOST_CHECK(q.queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(weighted_share) {
+	test_queue q;
+	q.queue.weights(3, 1, 1);
+	q.queue.max_write_bytes(40 * 1024);
+	uint16_t quota = 0;
+
+	for (int i = 0; i < 100; ++i) {
+		q.push(1024, traffic_class(traffic_class_e::alarm), 1);
+		q.push(1024, traffic_class(traffic_class_e::bulk), 3);
+	}
+
+	q.write(quota, false);
+	q.write(quota, false);
+	auto alarms = std::count(q.written.begin(), q.written.end(), 1);
+	auto bulks = std::count(q.written.begin(), q.written.end(), 3);
+	BOOST_CHECK_EQUAL(alarms, 3 * bulks);
+}
+
+BOOST_AUTO_TEST_CASE(throttled_in_publish_order) {
+	test_queue q;
+	uint16_t quota = 2;
+
+	for (int i = 0; i < 5; ++i)
+		q.push(
+			10, detail::send_flag::throttled |
+				traffic_class(traffic_class_e::telemetry),
+			i
+		);
+	q.push(10, traffic_class(traffic_class_e::telemetry), 99);
+
+	q.write(quota, true);
+	BOOST_CHECK((q.written == std::vector<int> { 0, 1, 99 }));
+	BOOST_CHECK_EQUAL(quota, 0);
+	BOOST_CHECK_EQUAL(q.write(quota, true), 0u);
+
+	quota = 3;
+	q.write(quota, true);
+	BOOST_CHECK((q.written == std::vector<int> { 0, 1, 99, 2, 3, 4 }));
+}
+
+BOOST_AUTO_TEST_CASE(sort_restores_publish_order) {
+	test_queue q;
+	uint16_t quota = 0;
+
+	auto flags = detail::send_flag::throttled |
+		traffic_class(traffic_class_e::telemetry);
+	for (int i : { 3, 1, 4, 2, 0 }) {
+		q.serial_num = detail::serial_num_t(i);
+		q.push(10, flags, i);
+	}
+
+	q.queue.sort();
+	q.write(quota, false);
+	BOOST_CHECK((q.written == std::vector<int> { 0, 1, 2, 3, 4 }));
+}
+
+BOOST_AUTO_TEST_CASE(terminal_written_alone) {
+	test_queue q;
+	uint16_t quota = 0;
+
+	q.push(10, traffic_class(traffic_class_e::telemetry), 1);
+	q.push(10, detail::send_flag::terminal, 0);
+
+	BOOST_CHECK_EQUAL(q.write(quota, false), 1u);
+	BOOST_CHECK_EQUAL(q.written.front(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(writable_without_quota) {
+	test_queue q;
+	uint16_t quota = 0;
+
+	BOOST_CHECK(!q.queue.writable(quota, true));
+
+	auto throttled = detail::send_flag::throttled |
+		traffic_class(traffic_class_e::telemetry);
+	q.push(10, throttled, 1);
+	BOOST_CHECK(!q.queue.writable(quota, true));
+	BOOST_CHECK(q.queue.writable(quota, false));
+	BOOST_CHECK(q.queue.writable(1, true));
+
+	q.push(10, traffic_class(traffic_class_e::bulk), 2);
+	BOOST_CHECK(q.queue.writable(quota, true));
+	BOOST_CHECK_EQUAL(q.write(quota, true), 1u);
+	BOOST_CHECK(!q.queue.writable(quota, true));
+}
+
+BOOST_AUTO_TEST_CASE(drain_after_outage, *boost::unit_test::disabled()) {
+	// 65535 QoS 1 publishes queued during an outage are drained
+	// with a Receive Maximum of 100
+	constexpr int num_publishes = 65535;
+	constexpr uint16_t receive_maximum = 100;
+
+	test_queue q;
+	q.payloads.reserve(num_publishes);
+	for (int i = 0; i < num_publishes; ++i)
+		q.push(
+			64, detail::send_flag::throttled |
+				traffic_class(traffic_class_e::telemetry),
+			i
+		);
+
+	auto start = std::chrono::steady_clock::now();
+
+	size_t writes = 0;
+	while (!q.queue.empty()) {
+		uint16_t quota = receive_maximum;
+		q.write(quota, true);
+		++writes;
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start
+	);
+
+	BOOST_CHECK_EQUAL(q.written.size(), size_t(num_publishes));
+	BOOST_CHECK_EQUAL(writes, size_t(num_publishes + receive_maximum - 1) / receive_maximum);
+	BOOST_TEST_MESSAGE(
+		"Drained " << num_publishes << " publishes in " << writes <<
+		" writes: " << elapsed.count() << " us"
+	);
+}
+
+// A service whose stream holds every write until it is completed,
+// as if the Client was offline.
+struct stalled_service {
+	using executor_type = asio::io_context::executor_type;
+
+	struct stream {
+		std::function<void (error_code, size_t)> pending;
+
+		template <typename Buffers, typename Handler>
+		void async_write(const Buffers& buffers, Handler&& handler) {
+			auto size = asio::buffer_size(buffers);
+			pending = [h = std::make_shared<std::decay_t<Handler>>(
+				std::move(handler)
+			), size](error_code ec, size_t) { (*h)(ec, size); };
+		}
+
+		void complete() {
+			std::exchange(pending, nullptr)(error_code {}, 0);
+		}
+	};
+
+	struct replies {
+		void clear_fast_replies() {}
+		void resend_unanswered() {}
+	};
+
+	struct context {
+		std::optional<uint16_t> receive_maximum;
+
+		template <typename Prop>
+		std::optional<uint16_t> connack_prop(Prop) const {
+			if constexpr (Prop::value == prop::receive_maximum)
+				return receive_maximum;
+			return std::nullopt;
+		}
+	};
+
+	struct aliases {
+		void reset(uint16_t) {}
+	};
+
+	asio::io_context& ioc;
+	stream _stream;
+	replies _replies;
+	context _stream_context;
+	aliases _topic_aliases;
+
+	executor_type get_executor() const { return ioc.get_executor(); }
+	void update_session_state() {}
+};
+
+struct test_sender {
+	asio::io_context ioc;
+	stalled_service svc { ioc };
+	detail::async_sender<stalled_service> sender { svc };
+	std::vector<std::string> payloads;
+	std::vector<std::pair<int, error_code>> completed;
+
+	test_sender(detail::write_limits limits) {
+		payloads.reserve(1024);
+		sender.limits(limits);
+	}
+
+	void publish(int id, unsigned flags = detail::send_flag::throttled) {
+		auto& payload = payloads.emplace_back(10, 'x');
+		std::array<asio::const_buffer, 2> buffers {
+			asio::buffer(payload), asio::const_buffer {}
+		};
+		sender.async_send(
+			buffers, sender.next_serial_num(),
+			detail::send_flag::bounded | flags |
+				traffic_class(traffic_class_e::telemetry),
+			[this, id](error_code ec) { completed.emplace_back(id, ec); }
+		);
+	}
+
+	void qos0_publish(int id) {
+		publish(id, detail::send_flag::droppable);
+	}
+
+	void publish_batch(
+		std::initializer_list<int> ids,
+		unsigned flags = detail::send_flag::throttled
+	) {
+		std::vector<detail::write_req> reqs;
+		for (int id : ids) {
+			auto& payload = payloads.emplace_back(10, 'x');
+			std::array<asio::const_buffer, 2> buffers {
+				asio::buffer(payload), asio::const_buffer {}
+			};
+			reqs.emplace_back(
+				buffers, sender.next_serial_num(),
+				detail::send_flag::bounded | flags |
+					traffic_class(traffic_class_e::telemetry),
+				[this, id](error_code ec) { completed.emplace_back(id, ec); }
+			);
+		}
+		sender.send_batch(std::move(reqs));
+	}
+
+	error_code completion(int id) {
+		for (auto& [cid, ec] : completed)
+			if (cid == id)
+				return ec;
+		BOOST_FAIL("publish " << id << " has not completed");
+		return {};
+	}
+
+	void run() {
+		ioc.restart();
+		ioc.run();
+	}
+};
+
+BOOST_AUTO_TEST_CASE(limits_reject_newest) {
+	test_sender t({ 0, 2, 0, 1, overflow_policy_e::reject_newest });
+
+	// the first publish is written, the next two are queued
+	for (int i = 0; i < 4; ++i)
+		t.publish(i);
+	t.run();
+
+	BOOST_REQUIRE_EQUAL(t.completed.size(), 1u);
+	BOOST_CHECK_EQUAL(t.completion(3), client::error::queue_full);
+	BOOST_CHECK_EQUAL(t.sender.stats().rejected, 1u);
+
+	t.svc._stream.complete();
+	t.svc._stream.complete();
+	t.run();
+	BOOST_CHECK_EQUAL(t.completed.size(), 4u);
+	BOOST_CHECK(!t.completion(2));
+}
+
+BOOST_AUTO_TEST_CASE(limits_drop_oldest_qos0) {
+	test_sender t({ 0, 3, 0, 1, overflow_policy_e::drop_oldest_qos0 });
+
+	t.publish(0);
+	t.qos0_publish(1);
+	t.publish(2);
+	t.qos0_publish(3);
+
+	// QoS 0 publishes are dropped oldest first
+	t.publish(4);
+	t.publish(5);
+	t.run();
+	BOOST_CHECK_EQUAL(t.completion(1), client::error::message_dropped);
+	BOOST_CHECK_EQUAL(t.completion(3), client::error::message_dropped);
+	BOOST_CHECK_EQUAL(t.sender.stats().dropped, 2u);
+
+	// nothing left to drop
+	t.publish(6);
+	t.run();
+	BOOST_CHECK_EQUAL(t.completion(6), client::error::queue_full);
+
+	t.svc._stream.complete();
+	t.svc._stream.complete();
+	t.run();
+	for (int id : { 0, 2, 4, 5 })
+		BOOST_CHECK(!t.completion(id));
+}
+
+BOOST_AUTO_TEST_CASE(limits_block_until_low_watermark) {
+	test_sender t({ 0, 4, 0, 1, overflow_policy_e::block });
+
+	for (int i = 0; i < 7; ++i)
+		t.publish(i);
+
+	bool writable = false;
+	t.sender.async_wait_writable([&writable](error_code ec) {
+		BOOST_CHECK(!ec);
+		writable = true;
+	});
+	t.run();
+
+	// publishes 5 and 6 are held back, not rejected
+	BOOST_CHECK(t.completed.empty());
+	BOOST_CHECK(!writable);
+
+	// the queued publishes are written together, which drains the queue
+	t.svc._stream.complete();
+	t.run();
+	BOOST_CHECK(writable);
+
+	t.svc._stream.complete();
+	t.svc._stream.complete();
+	t.run();
+	BOOST_CHECK_EQUAL(t.completed.size(), 7u);
+	for (int i = 0; i < 7; ++i)
+		BOOST_CHECK_EQUAL(t.completed[i].first, i);
+}
+
+BOOST_AUTO_TEST_CASE(limits_cancel_blocked) {
+	test_sender t({ 0, 1, 0, 0, overflow_policy_e::block });
+
+	for (int i = 0; i < 3; ++i)
+		t.publish(i);
+
+	error_code wait_ec;
+	t.sender.async_wait_writable([&wait_ec](error_code ec) { wait_ec = ec; });
+	t.run();
+
+	t.sender.cancel();
+	t.run();
+	BOOST_CHECK_EQUAL(t.completion(2), asio::error::operation_aborted);
+	BOOST_CHECK_EQUAL(wait_ec, asio::error::operation_aborted);
+}
+
+BOOST_AUTO_TEST_CASE(limits_reject_whole_batch) {
+	test_sender t({ 0, 3, 0, 1, overflow_policy_e::reject_newest });
+
+	// the first publish is written, the second is queued
+	t.publish(0);
+	t.publish(1);
+
+	// two of the three publishes would fit, but none is queued
+	t.publish_batch({ 2, 3, 4 });
+	t.run();
+	BOOST_REQUIRE_EQUAL(t.completed.size(), 3u);
+	for (int id : { 2, 3, 4 })
+		BOOST_CHECK_EQUAL(t.completion(id), client::error::queue_full);
+	BOOST_CHECK_EQUAL(t.sender.stats().rejected, 3u);
+
+	t.publish_batch({ 5, 6 });
+	t.svc._stream.complete();
+	t.run();
+	t.svc._stream.complete();
+	t.run();
+	BOOST_CHECK_EQUAL(t.completed.size(), 7u);
+	for (int id : { 0, 1, 5, 6 })
+		BOOST_CHECK(!t.completion(id));
+}
+
+BOOST_AUTO_TEST_CASE(limits_drop_oldest_qos0_for_batch) {
+	test_sender t({ 0, 3, 0, 1, overflow_policy_e::drop_oldest_qos0 });
+
+	t.publish(0);
+	t.qos0_publish(1);
+	t.qos0_publish(2);
+
+	// room is made for the whole batch at once
+	t.publish_batch({ 3, 4 });
+	t.run();
+	BOOST_REQUIRE_EQUAL(t.completed.size(), 1u);
+	BOOST_CHECK_EQUAL(t.completion(1), client::error::message_dropped);
+
+	t.svc._stream.complete();
+	t.run();
+	t.svc._stream.complete();
+	t.run();
+	BOOST_CHECK_EQUAL(t.completed.size(), 5u);
+	for (int id : { 0, 2, 3, 4 })
+		BOOST_CHECK(!t.completion(id));
+}
+
+BOOST_AUTO_TEST_CASE(no_linger_without_quota) {
+	test_sender t({});
+	t.sender.coalescing({ std::chrono::milliseconds(10), 64 * 1024, 64 });
+	t.svc._stream_context.receive_maximum = 1;
+	t.sender.resend();
+
+	// written at once after the reconnect, using up the quota
+	t.publish(0);
+	t.svc._stream.complete();
+	t.run();
+	BOOST_CHECK_EQUAL(t.completed.size(), 1u);
+
+	// waits for the quota without arming the linger timer
+	t.publish(1);
+	t.run();
+	BOOST_CHECK(!t.svc._stream.pending);
+	BOOST_CHECK_EQUAL(t.sender.stats().linger_expirations, 0u);
+
+	// lingers once the publish can be written
+	t.sender.throttled_op_done();
+	t.run();
+	BOOST_REQUIRE(t.svc._stream.pending);
+	BOOST_CHECK_EQUAL(t.sender.stats().linger_expirations, 1u);
+	t.svc._stream.complete();
+	t.run();
+	BOOST_CHECK_EQUAL(t.completed.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(zero_thresholds_not_applied) {
+	test_sender t({});
+	t.sender.coalescing({ std::chrono::milliseconds(1), 0, 0 });
+
+	// held for the linger time, however small the queue
+	t.publish(0, detail::send_flag::none);
+	BOOST_CHECK(!t.svc._stream.pending);
+	t.run();
+	BOOST_REQUIRE(t.svc._stream.pending);
+	BOOST_CHECK_EQUAL(t.sender.stats().linger_expirations, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()